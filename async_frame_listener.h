@@ -0,0 +1,318 @@
+/// @file async_frame_listener.h
+/// @brief process frames on their own thread
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-28
+
+#ifndef ASYNC_FRAME_LISTENER_H
+#define ASYNC_FRAME_LISTENER_H
+
+#include "frame_source.h"
+#include "notifier.h"
+#include "spsc_ring.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace soma
+{
+
+/// @brief queue frames from the frame source's thread and process them on another thread
+///
+/// on_frame () copies the frame into a lock-free ring and returns, so a slow listener can't hold up the frame source.
+/// If the ring is full the frame is dropped and counted, unless the listener was told to wait for room, which is for
+/// sources that aren't live, like a recording replayed as fast as possible.
+///
+/// Frames that the listener says can wait don't wake the processing thread.  They stay in the ring until a frame
+/// that can't wait arrives, or until the ring is a quarter full, which saves a wakeup per frame while there is
+/// nothing to do.  Since they are held on purpose, their time in the ring is counted separately from the time the
+/// other frames spend waiting for the processing thread.
+class async_frame_listener : public frame_listener
+{
+    private:
+    typedef std::chrono::steady_clock clock;
+    /// @brief a frame and when it was queued
+    struct queued_frame
+    {
+        frame f;
+        clock::time_point queued;
+        /// @brief true if it was queued without waking the processing thread
+        bool deferred;
+    };
+    frame_listener &l;
+    spsc_ring<queued_frame> ring;
+    std::thread t;
+    std::atomic<bool> stopping;
+    std::atomic<bool> sleeping;
+    notifier wakeup;
+    std::function<bool (const frame &)> can_wait;
+    std::atomic<bool> wait_for_room;
+    /// @brief set while the producer is waiting for room
+    std::atomic<bool> full;
+    notifier room;
+    // producer statistics
+    std::atomic<uint64_t> queued;
+    std::atomic<uint64_t> overflows;
+    std::atomic<uint64_t> full_waits;
+    std::atomic<size_t> max_occupancy;
+    std::atomic<uint64_t> deferred;
+    // consumer statistics
+    std::atomic<uint64_t> processed;
+    std::atomic<uint64_t> total_delay;
+    std::atomic<uint64_t> max_delay;
+    std::atomic<uint64_t> processed_deferred;
+    std::atomic<uint64_t> total_deferred_delay;
+    std::atomic<uint64_t> max_deferred_delay;
+    std::atomic<uint64_t> wakeups;
+    void run ()
+    {
+        while (true)
+        {
+            queued_frame *q = ring.front ();
+            if (!q)
+            {
+                if (stopping)
+                    break;
+                // wait for the producer.  the ring is checked again after saying we are sleeping, so a frame that
+                // was committed before the producer saw the flag is not missed, and one committed after it
+                // leaves a notification in the eventfd.
+                sleeping = true;
+                std::atomic_thread_fence (std::memory_order_seq_cst);
+                if (ring.empty () && !stopping)
+                {
+                    wakeup.wait ();
+                    ++wakeups;
+                }
+                sleeping = false;
+                continue;
+            }
+            const uint64_t d = std::chrono::duration_cast<std::chrono::microseconds> (clock::now () - q->queued)
+                .count ();
+            if (q->deferred)
+            {
+                ++processed_deferred;
+                total_deferred_delay += d;
+                if (d > max_deferred_delay)
+                    max_deferred_delay = d;
+            }
+            else
+            {
+                total_delay += d;
+                if (d > max_delay)
+                    max_delay = d;
+            }
+            l.on_frame (q->f);
+            ring.pop ();
+            ++processed;
+            if (wait_for_room)
+            {
+                // order the pop before reading the flag, pairs with the producer setting the flag then checking the
+                // ring
+                std::atomic_thread_fence (std::memory_order_seq_cst);
+                if (full)
+                    room.notify ();
+            }
+        }
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param l the listener that processes the frames
+    /// @param capacity number of frames that can be queued, must be a power of 2
+    async_frame_listener (frame_listener &l, size_t capacity = 256)
+        : l (l)
+        , ring (capacity)
+        , stopping (false)
+        , sleeping (false)
+        , wait_for_room (false)
+        , full (false)
+        , queued (0)
+        , overflows (0)
+        , full_waits (0)
+        , max_occupancy (0)
+        , deferred (0)
+        , processed (0)
+        , total_delay (0)
+        , max_delay (0)
+        , processed_deferred (0)
+        , total_deferred_delay (0)
+        , max_deferred_delay (0)
+        , wakeups (0)
+    {
+        t = std::thread (&async_frame_listener::run, this);
+    }
+    /// @brief destructor
+    ~async_frame_listener ()
+    {
+        stop ();
+    }
+    /// @brief process the frames that are still queued, then stop the processing thread
+    void stop ()
+    {
+        stopping = true;
+        wakeup.notify ();
+        room.notify ();
+        if (t.joinable ())
+            t.join ();
+    }
+    /// @brief say which frames can wait in the ring without waking the processing thread
+    ///
+    /// This must be called before frames start arriving.
+    ///
+    /// @param f called on the frame source's thread for each frame
+    void set_can_wait (const std::function<bool (const frame &)> &f)
+    {
+        can_wait = f;
+    }
+    /// @brief say whether a frame that arrives when the ring is full waits for room instead of being dropped
+    ///
+    /// Waiting holds up the frame source's thread, so it is only for sources that aren't live.  This must be called
+    /// before frames start arriving.
+    ///
+    /// @param w true to wait
+    void set_wait_for_room (bool w)
+    {
+        wait_for_room = w;
+    }
+    /// @brief queue a frame, called on the frame source's thread
+    ///
+    /// @param f the frame
+    virtual void on_frame (const frame &f)
+    {
+        queued_frame *q = ring.prepare ();
+        if (!q && wait_for_room)
+        {
+            ++full_waits;
+            while (!q && !stopping)
+            {
+                // the ring is checked again after saying we are waiting, like the processing thread's sleep
+                full = true;
+                std::atomic_thread_fence (std::memory_order_seq_cst);
+                q = ring.prepare ();
+                if (!q)
+                {
+                    if (sleeping)
+                        wakeup.notify ();
+                    room.wait ();
+                }
+                full = false;
+            }
+        }
+        if (!q)
+        {
+            ++overflows;
+            return;
+        }
+        // decide before committing, so the consumer sees the tag with the frame
+        const size_t n = ring.size () + 1;
+        q->f = f;
+        q->queued = clock::now ();
+        q->deferred = can_wait && n < ring.capacity () / 4 && can_wait (f);
+        const bool defer = q->deferred;
+        ring.commit ();
+        ++queued;
+        if (n > max_occupancy)
+            max_occupancy = n;
+        if (defer)
+        {
+            ++deferred;
+            return;
+        }
+        // order the commit before reading the flag, pairs with the consumer setting the flag then checking the ring
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        if (sleeping)
+            wakeup.notify ();
+    }
+    /// @brief number of frames waiting to be processed
+    size_t occupancy () const
+    {
+        return ring.size ();
+    }
+    /// @brief most frames that have been waiting at once
+    size_t get_max_occupancy () const
+    {
+        return max_occupancy;
+    }
+    /// @brief number of slots in the ring
+    size_t capacity () const
+    {
+        return ring.capacity ();
+    }
+    /// @brief number of frames queued
+    uint64_t get_queued () const
+    {
+        return queued;
+    }
+    /// @brief number of frames dropped because the ring was full
+    uint64_t get_overflows () const
+    {
+        return overflows;
+    }
+    /// @brief number of frames that had to wait for room in the ring
+    uint64_t get_full_waits () const
+    {
+        return full_waits;
+    }
+    /// @brief number of frames that were queued without waking the processing thread
+    uint64_t get_deferred () const
+    {
+        return deferred;
+    }
+    /// @brief number of times the processing thread woke up
+    uint64_t get_wakeups () const
+    {
+        return wakeups;
+    }
+    /// @brief number of frames processed
+    uint64_t get_processed () const
+    {
+        return processed;
+    }
+    /// @brief mean time frames that woke the processing thread spent in the ring in useconds
+    double mean_delay () const
+    {
+        const uint64_t n = processed - processed_deferred;
+        return n ? static_cast<double> (total_delay) / n : 0.0;
+    }
+    /// @brief longest time a frame that woke the processing thread spent in the ring in useconds
+    uint64_t get_max_delay () const
+    {
+        return max_delay;
+    }
+    /// @brief mean time frames that were allowed to wait spent in the ring in useconds
+    double mean_deferred_delay () const
+    {
+        return processed_deferred ? static_cast<double> (total_deferred_delay) / processed_deferred : 0.0;
+    }
+    /// @brief longest time a frame that was allowed to wait spent in the ring in useconds
+    uint64_t get_max_deferred_delay () const
+    {
+        return max_deferred_delay;
+    }
+};
+
+/// @brief print queue statistics
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param a the listener
+template<typename S>
+void print_stats (S &s, const async_frame_listener &a)
+{
+    s << a.get_queued () << " frames queued" << std::endl;
+    s << a.get_processed () << " frames processed" << std::endl;
+    s << a.get_overflows () << " frames dropped" << std::endl;
+    s << a.get_full_waits () << " frames waited for room" << std::endl;
+    s << a.get_deferred () << " frames queued without a wakeup" << std::endl;
+    s << a.get_wakeups () << " processing thread wakeups" << std::endl;
+    s << a.get_max_occupancy () << "/" << a.capacity () << " max ring occupancy" << std::endl;
+    s << a.mean_delay () << "us mean queueing delay" << std::endl;
+    s << a.get_max_delay () << "us max queueing delay" << std::endl;
+    s << a.mean_deferred_delay () << "us mean queueing delay for frames that could wait" << std::endl;
+    s << a.get_max_deferred_delay () << "us max queueing delay for frames that could wait" << std::endl;
+}
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+/// @file clock_mapper.h
+/// @brief map device timestamps to host time
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-09
+
+#ifndef CLOCK_MAPPER_H
+#define CLOCK_MAPPER_H
+
+#include <cassert>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief get the host time
+///
+/// @return CLOCK_MONOTONIC in useconds
+uint64_t host_now ()
+{
+    timespec t;
+    clock_gettime (CLOCK_MONOTONIC, &t);
+    return static_cast<uint64_t> (t.tv_sec) * 1000000 + t.tv_nsec / 1000;
+}
+
+/// @brief estimate the offset and drift between a device clock and the host clock
+///
+/// Each frame gives a pair of times: the device timestamp, and the host time when the frame arrived.  Their
+/// difference is the clock offset plus however long the frame took to get here, which varies from frame to frame.
+/// The smallest difference in each bucket of time is the one that was held up least, so a line fit through the
+/// bucket minimums tracks the offset and its drift without being pulled around by delayed frames.
+///
+/// Host times that come out of the mapping are when the frame would have arrived if it had been held up no more than
+/// the quickest frames, so they include the fixed part of the transport delay, which can't be seen from the host.
+class clock_mapper
+{
+    private:
+    /// @brief the least delayed frame in a bucket
+    struct point
+    {
+        uint64_t device_ts;
+        int64_t offset;
+    };
+    const uint64_t bucket_duration;
+    /// @brief the last few full buckets, oldest first
+    std::vector<point> points;
+    const size_t max_points;
+    /// @brief the bucket being filled
+    point current;
+    uint64_t current_start;
+    bool has_current;
+    uint64_t last_device_ts;
+    // the fit, offset = a + b * (device_ts - ref)
+    uint64_t ref;
+    double a;
+    double b;
+    void fit ()
+    {
+        assert (has_current);
+        ref = points.empty () ? current.device_ts : points.front ().device_ts;
+        // least squares over the full buckets.  the current bucket has seen too few frames to be trusted, unless
+        // there is not much else to go on.
+        const size_t n = points.size () < 2 ? points.size () + 1 : points.size ();
+        double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const point &p = i < points.size () ? points[i] : current;
+            const double x = static_cast<double> (p.device_ts - ref);
+            const double y = static_cast<double> (p.offset - current.offset);
+            sx += x;
+            sy += y;
+            sxx += x * x;
+            sxy += x * y;
+        }
+        const double d = n * sxx - sx * sx;
+        b = (n > 1 && d > 0.0) ? (n * sxy - sx * sy) / d : 0.0;
+        a = current.offset + (sy - b * sx) / n;
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param window how far back the estimate looks, in device useconds
+    /// @param buckets the window is split into this many buckets
+    clock_mapper (uint64_t window = 30000000, size_t buckets = 30)
+        : bucket_duration (window / buckets)
+        , max_points (buckets)
+        , current_start (0)
+        , has_current (false)
+        , last_device_ts (0)
+        , ref (0)
+        , a (0.0)
+        , b (0.0)
+    {
+        assert (buckets > 0);
+        assert (bucket_duration > 0);
+        points.reserve (max_points);
+    }
+    /// @brief forget everything
+    void clear ()
+    {
+        points.clear ();
+        has_current = false;
+        last_device_ts = 0;
+        a = b = 0.0;
+    }
+    /// @brief add a frame's times
+    ///
+    /// If the device clock goes backwards, the device was restarted, so the estimate starts over.
+    ///
+    /// @param device_ts device timestamp in useconds
+    /// @param host_ts host time in useconds when the frame arrived
+    void add (uint64_t device_ts, uint64_t host_ts)
+    {
+        if (device_ts < last_device_ts)
+            clear ();
+        last_device_ts = device_ts;
+        const point p = { device_ts, static_cast<int64_t> (host_ts - device_ts) };
+        if (!has_current || device_ts - current_start >= bucket_duration)
+        {
+            if (has_current)
+            {
+                if (points.size () == max_points)
+                    points.erase (points.begin ());
+                points.push_back (current);
+            }
+            current = p;
+            current_start = device_ts;
+            has_current = true;
+            fit ();
+        }
+        else if (p.offset < current.offset)
+        {
+            current = p;
+            fit ();
+        }
+    }
+    /// @brief true once a frame has been added
+    bool is_ready () const
+    {
+        return has_current;
+    }
+    /// @brief map a device timestamp to host time
+    ///
+    /// @param device_ts device timestamp in useconds
+    ///
+    /// @return host time in useconds
+    uint64_t to_host (uint64_t device_ts) const
+    {
+        assert (has_current);
+        const double x = static_cast<double> (device_ts) - static_cast<double> (ref);
+        return device_ts + static_cast<int64_t> (a + b * x + 0.5);
+    }
+    /// @brief the offset at the last frame, add it to a device timestamp to get host time, in useconds
+    int64_t get_offset () const
+    {
+        return to_host (last_device_ts) - last_device_ts;
+    }
+    /// @brief how fast the host clock gains on the device clock, in parts per million
+    double get_drift () const
+    {
+        return b * 1e6;
+    }
+};
+
+}
+
+#endif
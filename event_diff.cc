@@ -0,0 +1,63 @@
+/// @file event_diff.cc
+/// @brief compare two event logs
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-12
+
+#include "event_diff.h"
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: event_diff golden_events events [pixels [frames [window]]]";
+
+int main (int argc, char **argv)
+{
+    try
+    {
+        if (argc < 3 || argc > 6)
+            throw runtime_error (usage);
+
+        const vector<event_record> a = read_event_log (argv[1]);
+        const vector<event_record> b = read_event_log (argv[2]);
+        event_tolerance t;
+        if (argc > 3)
+            t.pixels = atoi (argv[3]);
+        if (argc > 4)
+            t.frames = atol (argv[4]);
+        if (argc > 5)
+            t.window = atol (argv[5]);
+
+        const vector<event_difference> d = compare_events (a, b, t);
+        for (auto i : d)
+            print_difference (cout, i, a, b);
+
+        // small differences that are within tolerance can still add up to a pointer that ends up somewhere else
+        int64_t ax = 0, ay = 0, bx = 0, by = 0;
+        for (auto i : a)
+        {
+            if (i.e.type != mouse_event_type::move)
+                continue;
+            ax += i.e.x;
+            ay += i.e.y;
+        }
+        for (auto i : b)
+        {
+            if (i.e.type != mouse_event_type::move)
+                continue;
+            bx += i.e.x;
+            by += i.e.y;
+        }
+        clog << a.size () << " and " << b.size () << " events" << endl;
+        clog << "total motion " << ax << " " << ay << " and " << bx << " " << by << endl;
+        clog << d.size () << " differences" << endl;
+
+        return d.empty () ? 0 : 1;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,196 @@
+/// @file event_diff.h
+/// @brief compare two streams of mouse events
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-12
+
+#ifndef EVENT_DIFF_H
+#define EVENT_DIFF_H
+
+#include "event_log.h"
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief how different two events can be and still match
+struct event_tolerance
+{
+    /// @brief how far apart the ids of the frames that caused the events can be
+    int64_t frames;
+    /// @brief how far apart the coordinates of move and set events can be, in pixels
+    int32_t pixels;
+    /// @brief how many events ahead to look for a match before giving up on an event
+    size_t window;
+    event_tolerance ()
+        : frames (0)
+        , pixels (0)
+        , window (32)
+    {
+    }
+};
+
+/// @brief how two streams differ at some point
+enum class event_change
+{
+    /// @brief an event in the first stream isn't in the second
+    missing,
+    /// @brief an event in the second stream isn't in the first
+    extra,
+    /// @brief the same kind of event, but it moved too far or came from a different frame
+    changed,
+};
+
+std::string to_string (const event_change c)
+{
+    switch (c)
+    {
+        default: assert (0); // logic error
+        case event_change::missing: return std::string ("missing");
+        case event_change::extra: return std::string ("extra");
+        case event_change::changed: return std::string ("changed");
+    }
+}
+
+/// @brief a difference between two streams
+struct event_difference
+{
+    event_change change;
+    /// @brief index of the event in the first stream, or where it would be if it is extra
+    size_t a;
+    /// @brief index of the event in the second stream, or where it would be if it is missing
+    size_t b;
+};
+
+/// @brief true if two events are the same kind of event: the same type, button and direction
+bool same_kind (const event_record &a, const event_record &b)
+{
+    return a.e.type == b.e.type && a.e.button == b.e.button && a.e.down == b.e.down;
+}
+
+/// @brief true if two events match within a tolerance
+bool matches (const event_record &a, const event_record &b, const event_tolerance &t)
+{
+    return same_kind (a, b)
+        && std::llabs (a.id - b.id) <= t.frames
+        && std::abs (a.e.x - b.e.x) <= t.pixels
+        && std::abs (a.e.y - b.e.y) <= t.pixels;
+}
+
+/// @brief find the differences between two event streams
+///
+/// The streams are walked together.  When the events at the front of each don't match, the one whose match is
+/// nearer in the other stream is kept, and the events that were skipped over to get to that match are reported as
+/// missing or extra.  If neither has a match nearby, events of the same kind are reported as changed.
+///
+/// @param a the first stream, usually the golden one
+/// @param b the second stream
+/// @param t tolerance
+///
+/// @return the differences, in stream order
+std::vector<event_difference> compare_events (const std::vector<event_record> &a,
+    const std::vector<event_record> &b,
+    const event_tolerance &t = event_tolerance ())
+{
+    std::vector<event_difference> d;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size () && j < b.size ())
+    {
+        if (matches (a[i], b[j], t))
+        {
+            ++i;
+            ++j;
+            continue;
+        }
+        // how far ahead is the next match for each front event
+        size_t ka = 0;
+        for (size_t k = 1; k <= t.window && j + k < b.size () && !ka; ++k)
+            if (matches (a[i], b[j + k], t))
+                ka = k;
+        size_t kb = 0;
+        for (size_t k = 1; k <= t.window && i + k < a.size () && !kb; ++k)
+            if (matches (a[i + k], b[j], t))
+                kb = k;
+        if (ka && (!kb || ka <= kb))
+        {
+            for (size_t k = 0; k < ka; ++k)
+                d.push_back (event_difference { event_change::extra, i, j + k });
+            j += ka;
+        }
+        else if (kb)
+        {
+            for (size_t k = 0; k < kb; ++k)
+                d.push_back (event_difference { event_change::missing, i + k, j });
+            i += kb;
+        }
+        else if (same_kind (a[i], b[j]))
+        {
+            d.push_back (event_difference { event_change::changed, i++, j++ });
+        }
+        else
+        {
+            d.push_back (event_difference { event_change::missing, i++, j });
+            d.push_back (event_difference { event_change::extra, i, j++ });
+        }
+    }
+    for (; i < a.size (); ++i)
+        d.push_back (event_difference { event_change::missing, i, j });
+    for (; j < b.size (); ++j)
+        d.push_back (event_difference { event_change::extra, i, j });
+    return d;
+}
+
+/// @brief print an event on one line
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param r the event
+template<typename S>
+void print_event (S &s, const event_record &r)
+{
+    s << "frame " << r.id << " ts " << r.ts << " ";
+    switch (r.e.type)
+    {
+        case mouse_event_type::move:
+        s << "move " << r.e.x << " " << r.e.y;
+        break;
+        case mouse_event_type::set:
+        s << "set " << r.e.x << " " << r.e.y;
+        break;
+        case mouse_event_type::button:
+        s << "button " << static_cast<int> (r.e.button) << (r.e.down ? " down" : " up");
+        break;
+    }
+}
+
+/// @brief print a difference on one line
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param d the difference
+/// @param a the first stream
+/// @param b the second stream
+template<typename S>
+void print_difference (S &s, const event_difference &d,
+    const std::vector<event_record> &a,
+    const std::vector<event_record> &b)
+{
+    s << to_string (d.change) << "\t" << d.a << "\t" << d.b << "\t";
+    if (d.change != event_change::extra)
+        print_event (s, a[d.a]);
+    if (d.change == event_change::changed)
+        s << "\t-> ";
+    if (d.change != event_change::missing)
+        print_event (s, b[d.b]);
+    s << std::endl;
+}
+
+}
+
+#endif
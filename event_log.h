@@ -0,0 +1,212 @@
+/// @file event_log.h
+/// @brief binary log of mouse events
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-04
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include "mouse.h"
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief event log file header, followed by event_records
+struct event_log_header
+{
+    /// @brief identifies the file type
+    char magic[8];
+    /// @brief format version
+    uint32_t version;
+    /// @brief sizeof (event_record) of the program that wrote the file
+    uint32_t record_size;
+    /// @brief total events, filled in when the log is closed
+    uint64_t events;
+    /// @brief unused, must be zero
+    uint64_t reserved;
+};
+
+/// @brief a mouse event and the frame that caused it
+struct event_record
+{
+    /// @brief timestamp of the frame in useconds
+    uint64_t ts;
+    /// @brief id of the frame
+    int64_t id;
+    /// @brief the event
+    mouse_event e;
+    uint32_t pad;
+};
+
+static const char EVENT_LOG_MAGIC[8] = { 'S', 'O', 'M', 'A', 'E', 'V', 'T', 0 };
+static const uint32_t EVENT_LOG_VERSION = 1;
+
+static_assert (sizeof (event_log_header) == 32, "unexpected event_log_header size");
+static_assert (sizeof (event_record) == 32, "unexpected event_record size");
+
+/// @brief write mouse events to a file
+class event_log_writer
+{
+    private:
+    FILE *fp;
+    uint64_t events;
+    bool write_header ()
+    {
+        event_log_header h;
+        memset (&h, 0, sizeof (h));
+        memcpy (h.magic, EVENT_LOG_MAGIC, sizeof (h.magic));
+        h.version = EVENT_LOG_VERSION;
+        h.record_size = sizeof (event_record);
+        h.events = events;
+        return fwrite (&h, sizeof (h), 1, fp) == 1;
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param fn filename
+    event_log_writer (const std::string &fn)
+        : fp (fopen (fn.c_str (), "wb"))
+        , events (0)
+    {
+        if (!fp)
+            throw std::runtime_error ("could not open event log for writing");
+        if (!write_header ())
+        {
+            fclose (fp);
+            throw std::runtime_error ("could not write event log header");
+        }
+    }
+    /// @brief destructor
+    ~event_log_writer ()
+    {
+        if (fp)
+        {
+            try { close (); }
+            catch (...) { }
+        }
+    }
+    /// @brief get number of events written
+    uint64_t get_events () const
+    {
+        return events;
+    }
+    /// @brief get number of bytes written
+    uint64_t get_bytes () const
+    {
+        return sizeof (event_log_header) + events * sizeof (event_record);
+    }
+    /// @brief write an event
+    ///
+    /// @param r the event
+    void write (const event_record &r)
+    {
+        assert (fp);
+        if (fwrite (&r, sizeof (r), 1, fp) != 1)
+            throw std::runtime_error ("could not write event to event log");
+        ++events;
+    }
+    /// @brief write buffered events to the file
+    void flush ()
+    {
+        assert (fp);
+        if (fflush (fp) != 0)
+            throw std::runtime_error ("could not flush event log");
+    }
+    /// @brief fill in the event count and close the file
+    void close ()
+    {
+        assert (fp);
+        bool ok = (fflush (fp) == 0)
+            && (fseek (fp, 0, SEEK_SET) == 0)
+            && write_header ();
+        ok = (fclose (fp) == 0) && ok;
+        fp = 0;
+        if (!ok)
+            throw std::runtime_error ("could not close event log");
+    }
+};
+
+/// @brief write each mouse event to an event log, stamped with the frame that caused it
+class event_log_observer : public mouse_observer
+{
+    private:
+    event_log_writer w;
+    uint64_t ts;
+    int64_t id;
+    public:
+    /// @brief constructor
+    ///
+    /// @param fn filename
+    event_log_observer (const std::string &fn)
+        : w (fn)
+        , ts (0)
+        , id (0)
+    {
+    }
+    /// @brief start processing a frame, the events that follow are stamped with it
+    ///
+    /// @param frame_ts timestamp of the frame in useconds
+    /// @param frame_id id of the frame
+    void begin (uint64_t frame_ts, int64_t frame_id)
+    {
+        ts = frame_ts;
+        id = frame_id;
+    }
+    /// @brief write an event
+    virtual void on_event (const mouse_event &e)
+    {
+        const event_record r = { ts, id, e, 0 };
+        w.write (r);
+    }
+    /// @brief get number of events written
+    uint64_t get_events () const
+    {
+        return w.get_events ();
+    }
+    /// @brief fill in the event count and close the file
+    void close ()
+    {
+        w.close ();
+    }
+};
+
+/// @brief read an event log
+///
+/// A log that was not closed is read up to its last complete event.
+///
+/// @param fn filename
+///
+/// @return the events
+std::vector<event_record> read_event_log (const std::string &fn)
+{
+    FILE *fp = fopen (fn.c_str (), "rb");
+    if (!fp)
+        throw std::runtime_error ("could not open event log for reading");
+    event_log_header h;
+    if (fread (&h, sizeof (h), 1, fp) != 1
+        || memcmp (h.magic, EVENT_LOG_MAGIC, sizeof (h.magic)) != 0
+        || h.version != EVENT_LOG_VERSION
+        || h.record_size != sizeof (event_record))
+    {
+        fclose (fp);
+        throw std::runtime_error ("unrecognized event log format");
+    }
+    std::vector<event_record> events;
+    event_record r;
+    while (fread (&r, sizeof (r), 1, fp) == 1)
+        events.push_back (r);
+    fclose (fp);
+    return events;
+}
+
+}
+
+#endif
@@ -0,0 +1,183 @@
+/// @file event_loop.h
+/// @brief block the main thread until there is something to do
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-05
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "frame_source.h"
+#include "notifier.h"
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <pthread.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief run the main thread until it is told to quit
+///
+/// The loop sleeps in epoll_wait () until a done_flag it is watching gets set, a timer expires, or SIGINT, SIGTERM
+/// or SIGHUP arrives, so an idle program does not wake up at all.
+///
+/// The signals are blocked and read from a signalfd, so the event_loop must be created before any other threads,
+/// which inherit the blocked signals.
+class event_loop
+{
+    private:
+    struct timer
+    {
+        int fd;
+        std::function<void ()> f;
+    };
+    int epfd;
+    int sigfd;
+    notifier quit_notifier;
+    std::vector<timer> timers;
+    int last_signal;
+    sigset_t signals;
+    enum { QUIT = -1, SIGNAL = -2 };
+    void watch (int fd, int id)
+    {
+        epoll_event e;
+        e.events = EPOLLIN;
+        e.data.u64 = 0;
+        e.data.u32 = id;
+        if (epoll_ctl (epfd, EPOLL_CTL_ADD, fd, &e) == -1)
+            throw std::runtime_error ("could not add file descriptor to event loop");
+    }
+    public:
+    event_loop ()
+        : epfd (epoll_create1 (EPOLL_CLOEXEC))
+        , sigfd (-1)
+        , last_signal (0)
+    {
+        if (epfd == -1)
+            throw std::runtime_error ("could not create epoll file descriptor");
+        sigemptyset (&signals);
+        sigaddset (&signals, SIGINT);
+        sigaddset (&signals, SIGTERM);
+        sigaddset (&signals, SIGHUP);
+        pthread_sigmask (SIG_BLOCK, &signals, 0);
+        sigfd = signalfd (-1, &signals, SFD_CLOEXEC | SFD_NONBLOCK);
+        if (sigfd == -1)
+        {
+            close (epfd);
+            throw std::runtime_error ("could not create signalfd");
+        }
+        watch (quit_notifier.get_fd (), QUIT);
+        watch (sigfd, SIGNAL);
+    }
+    ~event_loop ()
+    {
+        for (auto &t : timers)
+            close (t.fd);
+        close (sigfd);
+        close (epfd);
+        pthread_sigmask (SIG_UNBLOCK, &signals, 0);
+    }
+    event_loop (const event_loop &) = delete;
+    event_loop &operator= (const event_loop &) = delete;
+    /// @brief make run () return, can be called from any thread
+    void quit ()
+    {
+        quit_notifier.notify ();
+    }
+    /// @brief quit when a flag gets set
+    ///
+    /// This must be called before the thread that sets the flag is started.
+    ///
+    /// @param d the flag
+    void quit_when (done_flag &d)
+    {
+        d.on_set ([this] () { quit (); });
+        if (d.is_set ())
+            quit ();
+    }
+    /// @brief call a function periodically on the main thread
+    ///
+    /// @param interval time between calls
+    /// @param f the function
+    void add_timer (std::chrono::microseconds interval, const std::function<void ()> &f)
+    {
+        assert (interval.count () > 0);
+        const int fd = timerfd_create (CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        if (fd == -1)
+            throw std::runtime_error ("could not create timerfd");
+        itimerspec t;
+        t.it_interval.tv_sec = interval.count () / 1000000;
+        t.it_interval.tv_nsec = (interval.count () % 1000000) * 1000;
+        t.it_value = t.it_interval;
+        if (timerfd_settime (fd, 0, &t, 0) == -1)
+        {
+            close (fd);
+            throw std::runtime_error ("could not set timer");
+        }
+        const timer x = { fd, f };
+        timers.push_back (x);
+        watch (fd, timers.size () - 1);
+    }
+    /// @brief the signal that made run () return, or 0
+    int get_signal () const
+    {
+        return last_signal;
+    }
+    /// @brief block until quit () is called or a signal arrives, calling timer functions as they expire
+    void run ()
+    {
+        while (true)
+        {
+            epoll_event events[8];
+            const int n = epoll_wait (epfd, events, 8, -1);
+            if (n == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error ("epoll_wait failed");
+            }
+            bool done = false;
+            for (int i = 0; i < n; ++i)
+            {
+                const int id = static_cast<int32_t> (events[i].data.u32);
+                if (id == QUIT)
+                {
+                    quit_notifier.clear ();
+                    done = true;
+                }
+                else if (id == SIGNAL)
+                {
+                    signalfd_siginfo si;
+                    if (::read (sigfd, &si, sizeof (si)) == sizeof (si))
+                    {
+                        last_signal = si.ssi_signo;
+                        done = true;
+                    }
+                }
+                else
+                {
+                    assert (id >= 0 && static_cast<size_t> (id) < timers.size ());
+                    uint64_t expirations;
+                    if (::read (timers[id].fd, &expirations, sizeof (expirations)) == sizeof (expirations))
+                        timers[id].f ();
+                }
+            }
+            if (done)
+                return;
+        }
+    }
+};
+
+}
+
+#endif
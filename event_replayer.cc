@@ -0,0 +1,57 @@
+/// @file event_replayer.cc
+/// @brief replay a recording through soma_mouse without a display and log the mouse events it makes
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-12
+
+#include "recording.h"
+#include "soma_mouse.h"
+#include <stdexcept>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: event_replayer recording events [config]";
+
+int main (int argc, char **argv)
+{
+    try
+    {
+        if (argc != 3 && argc != 4)
+            throw runtime_error (usage);
+
+        // the defaults, unless a config file says otherwise, so the events don't depend on whoever's somarc
+        options opts;
+        if (argc == 4)
+            read (opts, argv[3]);
+        // nothing but the event log gets written
+        opts.set_flight_seconds (0.0);
+        opts.set_record (false);
+
+        recording_reader r (argv[1]);
+        uint64_t frames = 0;
+        uint64_t events = 0;
+        {
+            // frames go straight to the pipeline on this thread, one after another, so every replay is the same
+            soma_mouse sm (opts, true);
+            sm.log_events (argv[2]);
+            frame f;
+            for (auto i = r.begin (); i != r.end () && !sm.get_done ().is_set (); ++i)
+            {
+                (*i).get (f);
+                sm.on_frame (f);
+                ++frames;
+            }
+            events = sm.get_event_log ()->get_events ();
+            sm.get_event_log ()->close ();
+        }
+        clog << frames << " frames" << endl;
+        clog << events << " events" << endl;
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
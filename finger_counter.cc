@@ -4,38 +4,43 @@
 /// @version 1.0
 /// @date 2013-09-27
 
+#include "event_loop.h"
 #include "finger_counter.h"
-#include "hand_sample.h"
-#include "Leap.h"
+#include "frame_sources.h"
+#include "hand_tracker.h"
 #include <stdexcept>
 #include <unistd.h>
 
 using namespace std;
 using namespace soma;
-const string usage = "usage: finger_counter";
+const string usage = "usage: finger_counter " + frame_source_usage;
 
 /// @brief grab frames and count fingers
-class grabber : public Leap::Listener
+class grabber : public frame_listener
 {
     private:
-    finger_counter fc;
+    /// @brief a counter for each hand
+    hand_tracker<finger_counter> hands;
     public:
     grabber (uint64_t duration)
-        : fc (duration)
+        : hands (finger_counter (duration), duration)
     {
     }
-    virtual void onFrame (const Leap::Controller& c)
+    virtual void on_frame (const frame &f)
     {
-        // get the frame
-        Leap::Frame f = c.frame ();
-        uint64_t ts = f.timestamp ();
-        // get the sample
-        hand_sample hs (f.pointables ());
-        // add it to the counter
-        fc.add (ts, hs.size ());
-        // if it's changed, print the result
-        if (fc.has_changed ())
-            clog << fc.get_count () << endl;
+        hand h[MAX_SPLIT_HANDS];
+        hand_sample s[MAX_SPLIT_HANDS];
+        const size_t n = split_hands (f, h, s);
+        hands.update (f.ts, h, n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            // add it to the hand's counter
+            finger_counter &fc = hands.get (h[i].id);
+            fc.add (f.ts, s[i].size ());
+            // if it's changed, print the result
+            if (fc.has_changed ())
+                clog << "hand " << h[i].id << ": " << fc.get_count () << endl;
+        }
     }
 };
 
@@ -43,21 +48,24 @@ int main (int argc, char **argv)
 {
     try
     {
-        if (argc != 1)
+        if (!valid_frame_source_args (argc - 1, argv + 1))
             throw runtime_error (usage);
 
+        // signals are blocked in every thread started after this
+        event_loop loop;
+
         clog << "Press CTRL-C to exit" << endl;
 
         static const uint64_t WINDOW_DURATION = 200000;
         grabber g (WINDOW_DURATION);
-        Leap::Controller c (g);
+        unique_ptr<frame_source> src = make_frame_source (argc - 1, argv + 1);
+        loop.quit_when (src->get_done ());
+        src->start (g);
 
-        // receive frames even when you don't have focus
-        c.setPolicyFlags (Leap::Controller::POLICY_BACKGROUND_FRAMES);
+        // sleep until CTRL-C or the source runs out of frames
+        loop.run ();
 
-        // loop
-        while (1)
-            usleep (5000);
+        src->stop ();
 
         return 0;
     }
@@ -7,6 +7,7 @@
 #ifndef FINGER_COUNTER_H
 #define FINGER_COUNTER_H
 
+#include "hand_sample.h"
 #include "sliding_window.h"
 #include "stats.h"
 #include <cstdint>
@@ -29,7 +30,7 @@ class finger_counter
     /// @brief indicates how many of the samples must be equal to the mode
     float mode_ratio;
     /// @brief mode of finger count
-    running_mode rm;
+    bounded_running_mode<hand_sample::MAX_FINGERS + 1> rm;
     public:
     /// @brief constructor
     ///
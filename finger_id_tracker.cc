@@ -5,16 +5,16 @@
 /// @date 2013-09-27
 
 #include <stdexcept>
+#include "event_loop.h"
 #include "finger_id_tracker.h"
-#include "hand_sample.h"
-#include "Leap.h"
+#include "frame_sources.h"
 #include <unistd.h>
 
 using namespace std;
 using namespace soma;
-const string usage = "usage: finger_id_tracker";
+const string usage = "usage: finger_id_tracker " + frame_source_usage;
 
-class grabber : public Leap::Listener
+class grabber : public frame_listener
 {
     private:
     finger_id_tracker fit;
@@ -23,18 +23,13 @@ class grabber : public Leap::Listener
         : fit (duration)
     {
     }
-    virtual void onFrame (const Leap::Controller& c)
+    virtual void on_frame (const frame &f)
     {
-        // get the frame
-        Leap::Frame f = c.frame ();
-        uint64_t ts = f.timestamp ();
-        // get the sample
-        hand_sample hs (f.pointables ());
         finger_ids ids;
-        for (auto j : hs)
+        for (auto j : f.s)
             ids.push_back (j.id);
         // add it to the tracker
-        fit.add (ts, ids);
+        fit.add (f.ts, ids);
         // if it's changed, print the result
         for (size_t nfingers = 0; nfingers < 10; ++nfingers)
         {
@@ -52,19 +47,24 @@ int main (int argc, char **argv)
 {
     try
     {
-        if (argc != 1)
+        if (!valid_frame_source_args (argc - 1, argv + 1))
             throw runtime_error (usage);
 
+        // signals are blocked in every thread started after this
+        event_loop loop;
+
         clog << "Press CTRL-C to exit" << endl;
 
         static const uint64_t WINDOW_DURATION = 1000000;
         grabber g (WINDOW_DURATION);
-        Leap::Controller c (g);
+        unique_ptr<frame_source> src = make_frame_source (argc - 1, argv + 1);
+        loop.quit_when (src->get_done ());
+        src->start (g);
+
+        // sleep until CTRL-C or the source runs out of frames
+        loop.run ();
 
-        // receive frames even when you don't have focus
-        c.setPolicyFlags (Leap::Controller::POLICY_BACKGROUND_FRAMES);
-        while (1)
-            usleep (5000);
+        src->stop ();
 
         return 0;
     }
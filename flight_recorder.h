@@ -0,0 +1,340 @@
+/// @file flight_recorder.h
+/// @brief keep the recent past in memory so it can be dumped when something goes wrong
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-03
+
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include "frame_source.h"
+#include "mouse.h"
+#include <cassert>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief one frame, what the pipeline decided, and what it did to the mouse
+struct flight_record
+{
+    /// @brief most mouse events kept per frame
+    static const size_t MAX_EVENTS = 4;
+    /// @brief frame id
+    int64_t id;
+    /// @brief frame timestamp in useconds
+    uint64_t ts;
+    /// @brief number of fingers
+    uint32_t nfingers;
+    /// @brief hand_shape after the frame
+    int8_t shape;
+    /// @brief finger count the shape is based on
+    int8_t count;
+    /// @brief pinch_detector state after the frame
+    uint8_t pinch;
+    /// @brief number of mouse events, can be more than MAX_EVENTS, but only MAX_EVENTS are kept
+    uint8_t nevents;
+    finger fingers[hand_sample::MAX_FINGERS];
+    mouse_event events[MAX_EVENTS];
+};
+
+/// @brief flight recorder dump file header, followed by flight_header::records flight_records, oldest first
+struct flight_header
+{
+    /// @brief identifies the file type
+    char magic[8];
+    /// @brief format version
+    uint32_t version;
+    /// @brief sizeof (flight_record) of the program that wrote the file
+    uint32_t record_size;
+    /// @brief sizeof (finger) of the program that wrote the file
+    uint32_t finger_size;
+    /// @brief unused, must be zero
+    uint32_t reserved;
+    /// @brief number of records
+    uint64_t records;
+};
+
+static const char FLIGHT_MAGIC[8] = { 'S', 'O', 'M', 'A', 'F', 'L', 'T', 0 };
+static const uint32_t FLIGHT_VERSION = 1;
+
+static_assert (sizeof (flight_header) == 32, "unexpected flight_header size");
+static_assert (sizeof (flight_record) % 8 == 0, "flight records must stay aligned");
+
+/// @brief set by SIGUSR1
+static volatile sig_atomic_t flight_dump_requested = 0;
+
+/// @brief keep the last few seconds of frames, classifier states and mouse events
+///
+/// The records live in a ring that is allocated once, so recording a frame is a copy into memory that is already
+/// there.  The ring is dumped to a file when SIGUSR1 is received, when the trigger says so, or when the program
+/// crashes.  All of the recording is done on the thread that processes the frames.
+class flight_recorder : public mouse_observer
+{
+    private:
+    /// @brief the fastest frame rate we expect, used to size the ring
+    static const size_t MAX_FPS = 250;
+    uint64_t duration;
+    std::vector<flight_record> ring;
+    /// @brief total records, the next one goes in ring[n % ring.size ()]
+    uint64_t n;
+    std::string dir;
+    std::function<bool (const flight_record &)> trigger;
+    uint64_t last_dump_ts;
+    uint64_t dumps;
+    /// @brief crash dump filename, made ahead of time because we can't allocate in a signal handler
+    char crash_fn[512];
+    flight_record &current ()
+    {
+        assert (n > 0);
+        return ring[(n - 1) % ring.size ()];
+    }
+    /// @brief index of the first record in the dump
+    uint64_t first () const
+    {
+        uint64_t i = n > ring.size () ? n - ring.size () : 0;
+        // only the records from the last duration useconds
+        const uint64_t last_ts = ring[(n - 1) % ring.size ()].ts;
+        while (i + 1 < n && last_ts - ring[i % ring.size ()].ts > duration)
+            ++i;
+        return i;
+    }
+    static bool write_all (int fd, const void *p, size_t bytes)
+    {
+        const char *q = static_cast<const char *> (p);
+        while (bytes)
+        {
+            const ssize_t w = ::write (fd, q, bytes);
+            if (w <= 0)
+                return false;
+            q += w;
+            bytes -= w;
+        }
+        return true;
+    }
+    /// @brief write the ring to a file, using only async signal safe calls
+    bool write_fd (int fd) const
+    {
+        const uint64_t b = n ? first () : 0;
+        flight_header h;
+        memset (&h, 0, sizeof (h));
+        memcpy (h.magic, FLIGHT_MAGIC, sizeof (h.magic));
+        h.version = FLIGHT_VERSION;
+        h.record_size = sizeof (flight_record);
+        h.finger_size = sizeof (finger);
+        h.records = n - b;
+        if (!write_all (fd, &h, sizeof (h)))
+            return false;
+        if (n == b)
+            return true;
+        // at most two pieces, before and after the wrap
+        const size_t i = b % ring.size ();
+        const size_t j = (n - 1) % ring.size () + 1;
+        if (i < j)
+            return write_all (fd, &ring[i], (j - i) * sizeof (flight_record));
+        return write_all (fd, &ring[i], (ring.size () - i) * sizeof (flight_record))
+            && write_all (fd, &ring[0], j * sizeof (flight_record));
+    }
+    static flight_recorder *&crash_recorder ()
+    {
+        static flight_recorder *fr = 0;
+        return fr;
+    }
+    static void on_usr1 (int)
+    {
+        flight_dump_requested = 1;
+    }
+    static void on_crash (int sig)
+    {
+        const flight_recorder *fr = crash_recorder ();
+        if (fr)
+        {
+            const int fd = ::open (fr->crash_fn, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd != -1)
+            {
+                fr->write_fd (fd);
+                ::close (fd);
+            }
+        }
+        // the handler was reset, so this gets the default action
+        raise (sig);
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param seconds how many seconds to keep
+    /// @param dir directory to put dumps in
+    flight_recorder (double seconds, const std::string &dir)
+        : duration (seconds * 1000000)
+        , ring (std::max (static_cast<size_t> (seconds * MAX_FPS), static_cast<size_t> (1)))
+        , n (0)
+        , dir (dir)
+        , last_dump_ts (0)
+        , dumps (0)
+    {
+        const std::string fn = dir + "/flight-crash.somf";
+        if (fn.size () >= sizeof (crash_fn))
+            throw std::runtime_error ("flight recorder directory name is too long");
+        strcpy (crash_fn, fn.c_str ());
+    }
+    /// @brief destructor
+    ~flight_recorder ()
+    {
+        if (crash_recorder () == this)
+            crash_recorder () = 0;
+    }
+    /// @brief dump on SIGUSR1, and dump to dir/flight-crash.somf on a crash
+    ///
+    /// Only one recorder can be dumped on a crash.
+    void install_signal_handlers ()
+    {
+        crash_recorder () = this;
+        struct sigaction sa;
+        memset (&sa, 0, sizeof (sa));
+        sigemptyset (&sa.sa_mask);
+        sa.sa_handler = on_usr1;
+        sa.sa_flags = SA_RESTART;
+        sigaction (SIGUSR1, &sa, 0);
+        sa.sa_handler = on_crash;
+        sa.sa_flags = SA_RESETHAND;
+        const int crashes[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+        for (auto s : crashes)
+            sigaction (s, &sa, 0);
+    }
+    /// @brief set a function that decides when to dump
+    ///
+    /// It is called with each completed record.  After a triggered dump, the trigger is ignored until the ring
+    /// has been refilled, so one misfire doesn't cause a string of dumps.
+    ///
+    /// @param t the trigger
+    void set_trigger (const std::function<bool (const flight_record &)> &t)
+    {
+        trigger = t;
+    }
+    /// @brief number of records that can be kept
+    size_t capacity () const
+    {
+        return ring.size ();
+    }
+    /// @brief number of records made
+    uint64_t get_records () const
+    {
+        return n;
+    }
+    /// @brief number of dumps written
+    uint64_t get_dumps () const
+    {
+        return dumps;
+    }
+    /// @brief start a record for a frame
+    ///
+    /// @param f the frame
+    void begin (const frame &f)
+    {
+        flight_record &r = ring[n++ % ring.size ()];
+        r.id = f.id;
+        r.ts = f.ts;
+        r.nfingers = f.s.size ();
+        r.shape = -1;
+        r.count = -1;
+        r.pinch = 0;
+        r.nevents = 0;
+        std::copy (f.s.begin (), f.s.end (), r.fingers);
+    }
+    /// @brief remember what the classifiers decided about the current frame
+    ///
+    /// @param shape hand shape
+    /// @param count finger count
+    /// @param pinch pinch detector state
+    void set_state (int shape, int count, int pinch)
+    {
+        flight_record &r = current ();
+        r.shape = shape;
+        r.count = count;
+        r.pinch = pinch;
+    }
+    /// @brief remember a mouse event for the current frame
+    virtual void on_event (const mouse_event &e)
+    {
+        if (n == 0)
+            return;
+        flight_record &r = current ();
+        if (r.nevents < flight_record::MAX_EVENTS)
+            r.events[r.nevents] = e;
+        if (r.nevents < UINT8_MAX)
+            ++r.nevents;
+    }
+    /// @brief finish the current record, and dump if it was asked for
+    void end ()
+    {
+        const flight_record &r = current ();
+        bool dump_it = false;
+        if (flight_dump_requested)
+        {
+            flight_dump_requested = 0;
+            dump_it = true;
+        }
+        else if (trigger && (dumps == 0 || r.ts - last_dump_ts > duration) && trigger (r))
+            dump_it = true;
+        if (!dump_it)
+            return;
+        const std::string fn = dir + "/flight-" + std::to_string (r.ts) + ".somf";
+        dump (fn);
+        std::clog << "flight recorder dumped to " << fn << std::endl;
+    }
+    /// @brief write the last few seconds to a file
+    ///
+    /// @param fn filename
+    void dump (const std::string &fn)
+    {
+        const int fd = ::open (fn.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1)
+            throw std::runtime_error ("could not open flight recorder dump file");
+        const bool ok = write_fd (fd);
+        if (::close (fd) != 0 || !ok)
+            throw std::runtime_error ("could not write flight recorder dump file");
+        last_dump_ts = n ? ring[(n - 1) % ring.size ()].ts : 0;
+        ++dumps;
+    }
+};
+
+/// @brief read a flight recorder dump
+///
+/// @param fn filename
+///
+/// @return the records, oldest first
+std::vector<flight_record> read_flight_records (const std::string &fn)
+{
+    const int fd = ::open (fn.c_str (), O_RDONLY);
+    if (fd == -1)
+        throw std::runtime_error ("could not open flight recorder dump");
+    flight_header h;
+    if (::read (fd, &h, sizeof (h)) != sizeof (h)
+        || memcmp (h.magic, FLIGHT_MAGIC, sizeof (h.magic)) != 0
+        || h.version != FLIGHT_VERSION
+        || h.record_size != sizeof (flight_record)
+        || h.finger_size != sizeof (finger))
+    {
+        ::close (fd);
+        throw std::runtime_error ("unrecognized flight recorder dump format");
+    }
+    std::vector<flight_record> r (h.records);
+    const ssize_t bytes = r.size () * sizeof (flight_record);
+    const bool ok = r.empty () || ::read (fd, &r[0], bytes) == bytes;
+    ::close (fd);
+    if (!ok)
+        throw std::runtime_error ("flight recorder dump is truncated");
+    return r;
+}
+
+}
+
+#endif
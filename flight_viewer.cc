@@ -0,0 +1,74 @@
+/// @file flight_viewer.cc
+/// @brief print a flight recorder dump
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-03
+
+#include "flight_recorder.h"
+#include "hand_shape_classifier.h"
+#include "mouse_clicker.h"
+#include "recording.h"
+#include <stdexcept>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: flight_viewer dump [recording]";
+
+string to_string (const mouse_event &e)
+{
+    switch (e.type)
+    {
+        default: return "?";
+        case mouse_event_type::move: return "move " + std::to_string (e.x) + " " + std::to_string (e.y);
+        case mouse_event_type::set: return "set " + std::to_string (e.x) + " " + std::to_string (e.y);
+        case mouse_event_type::button: return "button " + std::to_string (e.button) + (e.down ? " down" : " up");
+    }
+}
+
+int main (int argc, char **argv)
+{
+    try
+    {
+        if (argc != 2 && argc != 3)
+            throw runtime_error (usage);
+
+        const vector<flight_record> records = read_flight_records (argv[1]);
+        clog << records.size () << " records" << endl;
+        if (records.empty ())
+            return 0;
+
+        const uint64_t first_ts = records[0].ts;
+        cout << "seconds\tid\tfingers\tcount\tshape\tpinch\tevents" << endl;
+        for (const auto &r : records)
+        {
+            cout << (r.ts - first_ts) / 1000000.0
+                << '\t' << r.id
+                << '\t' << r.nfingers
+                << '\t' << static_cast<int> (r.count)
+                << '\t' << to_string (static_cast<hand_shape> (r.shape))
+                << '\t' << pinch_detector::state_name (r.pinch);
+            for (size_t i = 0; i < r.nevents && i < flight_record::MAX_EVENTS; ++i)
+                cout << '\t' << to_string (r.events[i]);
+            if (r.nevents > flight_record::MAX_EVENTS)
+                cout << "\t(" << r.nevents - flight_record::MAX_EVENTS << " more)";
+            cout << endl;
+        }
+
+        // the frames can be replayed like any other recording
+        if (argc == 3)
+        {
+            recording_writer w (argv[2]);
+            for (const auto &r : records)
+                w.write (r.id, r.ts, hand_sample (r.fingers, r.fingers + r.nfingers));
+            w.close ();
+            clog << w.get_frames () << " frames written to " << argv[2] << endl;
+        }
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
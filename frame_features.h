@@ -0,0 +1,221 @@
+/// @file frame_features.h
+/// @brief per frame quantities shared by the pipeline stages
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-30
+
+#ifndef FRAME_FEATURES_H
+#define FRAME_FEATURES_H
+
+#include "hand_sample.h"
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+namespace soma
+{
+
+/// @brief ways to order the fingers in a sample
+enum class finger_order
+{
+    left_to_right,
+    top_to_bottom,
+    back_to_front,
+    by_id,
+};
+
+/// @brief features of a hand sample that more than one stage needs
+///
+/// The features are computed the first time they are asked for and remembered, so each one is computed at most
+/// once per frame no matter how many stages use it.  The sample must outlive the features.
+class frame_features
+{
+    private:
+    static const size_t MAXF = hand_sample::MAX_FINGERS;
+    /// @brief matrix rows are padded to a multiple of 4 for SIMD
+    static const size_t STRIDE = (MAXF + 3) & ~3;
+    static const size_t ORDERS = 4;
+    const hand_sample &s;
+    /// @brief bits indicating which features have been computed
+    mutable unsigned valid;
+    mutable uint8_t orders[ORDERS][MAXF];
+    mutable float d[MAXF][STRIDE];
+    mutable vec3 c;
+    mutable float sp;
+    enum { DISTANCES = 1 << ORDERS, CENTROID = DISTANCES << 1, SPREAD = CENTROID << 1 };
+    static bool less (finger_order o, const finger &a, const finger &b)
+    {
+        switch (o)
+        {
+            default: assert (0); // logic error
+            case finger_order::left_to_right: return sort_left_to_right (a, b);
+            case finger_order::top_to_bottom: return sort_top_to_bottom (a, b);
+            case finger_order::back_to_front: return sort_back_to_front (a, b);
+            case finger_order::by_id: return sort_by_id (a, b);
+        }
+    }
+    const uint8_t *order (finger_order o) const
+    {
+        const unsigned k = static_cast<unsigned> (o);
+        uint8_t *x = orders[k];
+        if (!(valid & (1 << k)))
+        {
+            // insertion sort is stable and cheap for a handful of fingers, and it does no work when the sample is
+            // already in order, which it usually is for left to right
+            for (size_t i = 0; i < s.size (); ++i)
+            {
+                size_t j = i;
+                for (; j > 0 && less (o, s[i], s[x[j - 1]]); --j)
+                    x[j] = x[j - 1];
+                x[j] = i;
+            }
+            valid |= (1 << k);
+        }
+        return x;
+    }
+    void compute_distances () const
+    {
+        const size_t n = s.size ();
+        // structure of arrays copy of the positions, padded with zeros
+        float x[STRIDE] = { 0 };
+        float y[STRIDE] = { 0 };
+        float z[STRIDE] = { 0 };
+        for (size_t i = 0; i < n; ++i)
+        {
+            x[i] = s[i].position.x;
+            y[i] = s[i].position.y;
+            z[i] = s[i].position.z;
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+#ifdef __SSE__
+            const __m128 xi = _mm_set1_ps (x[i]);
+            const __m128 yi = _mm_set1_ps (y[i]);
+            const __m128 zi = _mm_set1_ps (z[i]);
+            for (size_t j = 0; j < n; j += 4)
+            {
+                const __m128 dx = _mm_sub_ps (_mm_loadu_ps (x + j), xi);
+                const __m128 dy = _mm_sub_ps (_mm_loadu_ps (y + j), yi);
+                const __m128 dz = _mm_sub_ps (_mm_loadu_ps (z + j), zi);
+                const __m128 d2 = _mm_add_ps (_mm_add_ps (_mm_mul_ps (dx, dx), _mm_mul_ps (dy, dy)), _mm_mul_ps (dz, dz));
+                _mm_storeu_ps (d[i] + j, _mm_sqrt_ps (d2));
+            }
+#else
+            for (size_t j = 0; j < n; ++j)
+            {
+                const float dx = x[j] - x[i];
+                const float dy = y[j] - y[i];
+                const float dz = z[j] - z[i];
+                d[i][j] = sqrtf (dx * dx + dy * dy + dz * dz);
+            }
+#endif
+        }
+        valid |= DISTANCES;
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param s the sample
+    explicit frame_features (const hand_sample &s)
+        : s (s)
+        , valid (0)
+        , sp (0)
+    {
+    }
+    /// @brief the sample
+    const hand_sample &sample () const
+    {
+        return s;
+    }
+    /// @brief number of fingers
+    size_t size () const
+    {
+        return s.size ();
+    }
+    /// @brief get the index into the sample of the i'th finger in some order
+    ///
+    /// @param o the order
+    /// @param i position in that order
+    ///
+    /// @return index into the sample
+    size_t index (finger_order o, size_t i) const
+    {
+        assert (i < s.size ());
+        return order (o)[i];
+    }
+    /// @brief get the i'th finger in some order
+    ///
+    /// @param o the order
+    /// @param i position in that order
+    ///
+    /// @return the finger
+    const finger &get (finger_order o, size_t i) const
+    {
+        return s[index (o, i)];
+    }
+    /// @brief get the i'th finger from the left
+    const finger &left_to_right (size_t i) const
+    {
+        return get (finger_order::left_to_right, i);
+    }
+    /// @brief distance between two fingers
+    ///
+    /// @param i index into the sample
+    /// @param j index into the sample
+    ///
+    /// @return the distance in mm
+    float distance (size_t i, size_t j) const
+    {
+        assert (i < s.size () && j < s.size ());
+        if (!(valid & DISTANCES))
+            compute_distances ();
+        return d[i][j];
+    }
+    /// @brief distance between two fingers
+    ///
+    /// @param o the order
+    /// @param i position in that order
+    /// @param j position in that order
+    ///
+    /// @return the distance in mm
+    float distance (finger_order o, size_t i, size_t j) const
+    {
+        return distance (index (o, i), index (o, j));
+    }
+    /// @brief mean finger position
+    const vec3 &centroid () const
+    {
+        if (!(valid & CENTROID))
+        {
+            c = vec3 ();
+            for (auto &i : s)
+                c += i.position;
+            if (!s.empty ())
+                c = c / s.size ();
+            valid |= CENTROID;
+        }
+        return c;
+    }
+    /// @brief mean distance of the fingers from the centroid
+    float spread () const
+    {
+        if (!(valid & SPREAD))
+        {
+            const vec3 &m = centroid ();
+            sp = 0;
+            for (auto &i : s)
+                sp += i.position.distanceTo (m);
+            if (!s.empty ())
+                sp /= s.size ();
+            valid |= SPREAD;
+        }
+        return sp;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,225 @@
+/// @file frame_gaps.h
+/// @brief find dropped, repeated and out of order frames, and fill short gaps
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-10
+
+#ifndef FRAME_GAPS_H
+#define FRAME_GAPS_H
+
+#include "frame_source.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+namespace soma
+{
+
+/// @brief how a frame follows the one before it
+enum class frame_status
+{
+    /// @brief the next frame
+    ok,
+    /// @brief the first frame, or the first after the source restarted
+    first,
+    /// @brief frames are missing between this one and the last
+    gap,
+    /// @brief the same frame again
+    duplicate,
+    /// @brief older than a frame that already arrived
+    out_of_order,
+};
+
+std::string to_string (const frame_status s)
+{
+    switch (s)
+    {
+        default: assert (0); // logic error
+        case frame_status::ok: return std::string ("ok");
+        case frame_status::first: return std::string ("first");
+        case frame_status::gap: return std::string ("gap");
+        case frame_status::duplicate: return std::string ("duplicate");
+        case frame_status::out_of_order: return std::string ("out_of_order");
+    }
+}
+
+/// @brief track frame ids to find frames that were dropped, repeated or delivered out of order
+///
+/// Frame ids go up by one from each frame to the next.  Frames that are duplicates or out of order should be thrown
+/// away, since the rest of the pipeline expects timestamps that only go forward.  An id that goes back a long way
+/// means the source started over, so counting starts over from there.
+class frame_gap_detector
+{
+    private:
+    /// @brief ids further back than this mean the source restarted
+    static const int64_t MAX_REORDER = 1000;
+    bool has_last;
+    int64_t last_id;
+    uint64_t missing;
+    uint64_t frames;
+    uint64_t gaps;
+    uint64_t dropped;
+    uint64_t duplicates;
+    uint64_t out_of_order;
+    uint64_t restarts;
+    public:
+    frame_gap_detector ()
+        : has_last (false)
+        , last_id (0)
+        , missing (0)
+        , frames (0)
+        , gaps (0)
+        , dropped (0)
+        , duplicates (0)
+        , out_of_order (0)
+        , restarts (0)
+    {
+    }
+    /// @brief check the next frame
+    ///
+    /// @param f the frame
+    ///
+    /// @return how it follows the last frame that was ok
+    frame_status update (const frame &f)
+    {
+        missing = 0;
+        if (has_last && f.id == last_id)
+        {
+            ++duplicates;
+            return frame_status::duplicate;
+        }
+        if (has_last && f.id < last_id && last_id - f.id <= MAX_REORDER)
+        {
+            ++out_of_order;
+            return frame_status::out_of_order;
+        }
+        ++frames;
+        frame_status s = frame_status::ok;
+        if (!has_last || f.id < last_id)
+        {
+            restarts += has_last;
+            s = frame_status::first;
+        }
+        else if (f.id > last_id + 1)
+        {
+            missing = f.id - last_id - 1;
+            ++gaps;
+            dropped += missing;
+            s = frame_status::gap;
+        }
+        has_last = true;
+        last_id = f.id;
+        return s;
+    }
+    /// @brief number of frames missing before the last frame
+    uint64_t get_missing () const
+    {
+        return missing;
+    }
+    /// @brief number of frames that were ok, gaps or firsts
+    uint64_t get_frames () const
+    {
+        return frames;
+    }
+    /// @brief number of gaps
+    uint64_t get_gaps () const
+    {
+        return gaps;
+    }
+    /// @brief number of frames missing in all of the gaps
+    uint64_t get_dropped () const
+    {
+        return dropped;
+    }
+    /// @brief number of duplicate frames
+    uint64_t get_duplicates () const
+    {
+        return duplicates;
+    }
+    /// @brief number of out of order frames
+    uint64_t get_out_of_order () const
+    {
+        return out_of_order;
+    }
+    /// @brief number of times the source started over
+    uint64_t get_restarts () const
+    {
+        return restarts;
+    }
+    /// @brief fraction of the frames the source sent that never arrived
+    double drop_rate () const
+    {
+        return frames + dropped ? static_cast<double> (dropped) / (frames + dropped) : 0.0;
+    }
+};
+
+/// @brief print frame gap statistics on one line
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param d the detector
+template<typename S>
+void print_stats (S &s, const frame_gap_detector &d)
+{
+    s << d.get_dropped () << " dropped (" << d.drop_rate () * 100.0 << "%) in "
+        << d.get_gaps () << " gaps, "
+        << d.get_duplicates () << " duplicates, "
+        << d.get_out_of_order () << " out of order" << std::endl;
+}
+
+/// @brief make a frame part way between two frames
+///
+/// Fingers and hands that are in both frames are moved along a straight line between them.  Everything else is
+/// taken from b.
+///
+/// @param a the earlier frame
+/// @param b the later frame
+/// @param k which of the missing frames, 1 to n
+/// @param n how many frames are missing between a and b
+/// @param f the frame
+void interpolate (const frame &a, const frame &b, uint64_t k, uint64_t n, frame &f)
+{
+    assert (k >= 1 && k <= n);
+    assert (b.ts > a.ts);
+    const double t = static_cast<double> (k) / (n + 1);
+    f = b;
+    f.id = a.id + k;
+    f.ts = a.ts + (b.ts - a.ts) * k / (n + 1);
+    f.host_ts = 0;
+    for (auto &i : f.s)
+    {
+        for (auto &j : a.s)
+        {
+            if (i.id != j.id)
+                continue;
+            i.position = j.position + (i.position - j.position) * t;
+            i.velocity = j.velocity + (i.velocity - j.velocity) * t;
+            i.direction = j.direction + (i.direction - j.direction) * t;
+            break;
+        }
+    }
+    for (size_t i = 0; i < f.nhands; ++i)
+        for (size_t j = 0; j < a.nhands; ++j)
+            if (f.hands[i].id == a.hands[j].id)
+                f.hands[i].palm_position = a.hands[j].palm_position
+                    + (f.hands[i].palm_position - a.hands[j].palm_position) * t;
+    // moving the fingers may have changed their order, so sort them and move the hand bits with them
+    int32_t ids[hand_sample::MAX_FINGERS];
+    for (size_t i = 0; i < f.s.size (); ++i)
+        ids[i] = f.s[i].id;
+    std::sort (f.s.begin (), f.s.end (), sort_left_to_right);
+    for (size_t i = 0; i < f.nhands; ++i)
+    {
+        const uint16_t old = f.hands[i].fingers;
+        f.hands[i].fingers = 0;
+        for (size_t j = 0; j < f.s.size (); ++j)
+            for (size_t m = 0; m < f.s.size (); ++m)
+                if ((old & (1 << m)) && ids[m] == f.s[j].id)
+                    f.hands[i].fingers |= 1 << j;
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,256 @@
+/// @file frame_source.h
+/// @brief hardware independent source of frames
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-25
+
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include "clock_mapper.h"
+#include "hand_sample.h"
+#include "notifier.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace soma
+{
+
+/// @brief a frame of data, independent of where it came from
+///
+/// The fingers of every hand are in s.  If the source knows which hand each finger belongs to, has_hands is set and
+/// the hands say which fingers are theirs.  Fingers that the source couldn't attach to a hand, and the fingers of
+/// hands past MAX_HANDS, are in s but not in any hand.
+struct frame
+{
+    /// @brief most hands a frame can hold
+    static const size_t MAX_HANDS = 2;
+    /// @brief frame id
+    int64_t id;
+    /// @brief frame timestamp in useconds, from the device's clock
+    uint64_t ts;
+    /// @brief when the frame reached this machine, see host_now (), or 0 if that isn't known
+    uint64_t host_ts;
+    /// @brief the fingers, left to right
+    hand_sample s;
+    /// @brief true if the source groups fingers by hand
+    bool has_hands;
+    /// @brief number of hands
+    uint32_t nhands;
+    /// @brief the hands
+    hand hands[MAX_HANDS];
+    frame ()
+        : id (0)
+        , ts (0)
+        , host_ts (0)
+        , has_hands (false)
+        , nhands (0)
+    {
+    }
+};
+
+/// @brief a flag that one thread sets to say it is finished, and another thread waits for
+class done_flag
+{
+    private:
+    std::atomic<bool> done;
+    std::function<void ()> f;
+    public:
+    done_flag ()
+        : done (false)
+    {
+    }
+    /// @brief set a function to call when the flag gets set
+    ///
+    /// This must be called before the thread that sets the flag is started.
+    ///
+    /// @param g the function, which is called on the thread that sets the flag
+    void on_set (const std::function<void ()> &g)
+    {
+        f = g;
+    }
+    /// @brief set the flag
+    void set ()
+    {
+        if (!done.exchange (true) && f)
+            f ();
+    }
+    /// @brief clear the flag
+    void reset ()
+    {
+        done = false;
+    }
+    /// @brief check the flag
+    bool is_set () const
+    {
+        return done;
+    }
+};
+
+/// @brief receives frames from a frame source
+class frame_listener
+{
+    public:
+    virtual ~frame_listener () { }
+    /// @brief called once for each frame on the frame source's thread
+    ///
+    /// @param f the frame
+    virtual void on_frame (const frame &f) = 0;
+};
+
+/// @brief something that produces frames
+class frame_source
+{
+    protected:
+    /// @brief set when there are no more frames
+    done_flag done;
+    public:
+    virtual ~frame_source () { }
+    /// @brief start sending frames to a listener
+    ///
+    /// @param l the listener
+    virtual void start (frame_listener &l) = 0;
+    /// @brief stop sending frames
+    ///
+    /// No callbacks are made after this returns.
+    virtual void stop () = 0;
+    /// @brief check if the frames come from a device as they happen
+    ///
+    /// A live source can't be held up, so a listener that falls behind has to drop frames.  A source that isn't live
+    /// can wait for the listener instead.
+    virtual bool is_live () const
+    {
+        return true;
+    }
+    /// @brief check if the source has run out of frames
+    ///
+    /// @return true if there are no more frames
+    bool is_done () const
+    {
+        return done.is_set ();
+    }
+    /// @brief get the flag that is set when the source runs out of frames
+    done_flag &get_done ()
+    {
+        return done;
+    }
+};
+
+/// @brief a frame source that generates its frames on its own thread
+///
+/// The speed controls the pacing of the frames: 1.0 sends them in real time, N sends them N times faster than real
+/// time, and 0.0 sends them as fast as the listener can take them.
+class paced_frame_source : public frame_source
+{
+    private:
+    double speed;
+    std::thread t;
+    std::atomic<bool> stopping;
+    notifier wakeup;
+    void run (frame_listener &l)
+    {
+        typedef std::chrono::steady_clock clock;
+        frame f;
+        clock::time_point start;
+        uint64_t start_ts = 0;
+        bool first = true;
+        while (!stopping && next (f))
+        {
+            if (speed > 0.0)
+            {
+                // the device's clock starts over when it restarts, so start the pacing over from this frame
+                if (first || f.ts < start_ts)
+                {
+                    start = clock::now ();
+                    start_ts = f.ts;
+                    first = false;
+                }
+                // wait until the frame is due, or until stop () wakes us
+                const std::chrono::microseconds due (static_cast<uint64_t> ((f.ts - start_ts) / speed));
+                if (wakeup.wait_until (start + due) || stopping)
+                    break;
+            }
+            f.host_ts = host_now ();
+            l.on_frame (f);
+        }
+        done.set ();
+    }
+    protected:
+    /// @brief get the next frame
+    ///
+    /// @param f the frame
+    ///
+    /// @return false if there are no more frames
+    virtual bool next (frame &f) = 0;
+    public:
+    /// @brief constructor
+    ///
+    /// @param speed replay speed
+    paced_frame_source (double speed)
+        : speed (speed)
+        , stopping (false)
+    {
+    }
+    /// @brief destructor
+    ///
+    /// Derived classes must call stop () in their destructors, since the thread calls next ().
+    virtual ~paced_frame_source ()
+    {
+        assert (!t.joinable ());
+    }
+    virtual void start (frame_listener &l)
+    {
+        assert (!t.joinable ());
+        stopping = false;
+        wakeup.clear ();
+        done.reset ();
+        t = std::thread (&paced_frame_source::run, this, std::ref (l));
+    }
+    virtual void stop ()
+    {
+        stopping = true;
+        wakeup.notify ();
+        if (t.joinable ())
+            t.join ();
+    }
+    virtual bool is_live () const
+    {
+        return false;
+    }
+};
+
+/// @brief a frame source whose frames are generated by a function
+class generated_frame_source : public paced_frame_source
+{
+    public:
+    /// @brief generator type, returns false when there are no more frames
+    typedef std::function<bool (frame &)> generator;
+    private:
+    generator g;
+    protected:
+    virtual bool next (frame &f)
+    {
+        return g (f);
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param g the frame generator
+    /// @param speed replay speed
+    generated_frame_source (const generator &g, double speed = 0.0)
+        : paced_frame_source (speed)
+        , g (g)
+    {
+    }
+    ~generated_frame_source ()
+    {
+        stop ();
+    }
+};
+
+}
+
+#endif
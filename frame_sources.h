@@ -0,0 +1,107 @@
+/// @file frame_sources.h
+/// @brief choose a frame source from the command line
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-25
+
+#ifndef FRAME_SOURCES_H
+#define FRAME_SOURCES_H
+
+#include "fused_frame_source.h"
+#include "leap_frame_source.h"
+#include "recording_frame_source.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief usage string for the frame source arguments
+const std::string frame_source_usage = "[leap | recording [speed]] [+ leap | recording [speed] ...]";
+
+/// @brief create a single frame source from its arguments
+///
+/// @param argc number of arguments
+/// @param argv the arguments
+///
+/// @return the frame source
+std::unique_ptr<frame_source> make_single_frame_source (int argc, char **argv)
+{
+    if (argc == 0 || (argc == 1 && std::string (argv[0]) == "leap"))
+        return std::unique_ptr<frame_source> (new leap_frame_source);
+    if (argc > 2)
+        throw std::runtime_error ("too many frame source arguments");
+    double speed = 1.0;
+    if (argc == 2)
+    {
+        speed = atof (argv[1]);
+        if (speed < 0.0)
+            throw std::runtime_error ("replay speed must not be negative");
+    }
+    return std::unique_ptr<frame_source> (new recording_frame_source (argv[0], speed));
+}
+
+/// @brief check the number of frame source arguments
+///
+/// @param argc number of arguments
+/// @param argv the arguments, not including the program name
+///
+/// @return true if each source separated by + has at most two arguments, and none are missing
+bool valid_frame_source_args (int argc, char **argv)
+{
+    int n = 0;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (std::string (argv[i]) != "+")
+            ++n;
+        else if (n == 0 || n > 2 || i + 1 == argc)
+            return false;
+        else
+            n = 0;
+    }
+    return n <= 2;
+}
+
+/// @brief create a frame source from command line arguments
+///
+/// With no arguments, frames come from the Leap controller.  Otherwise the first argument is a recording to replay,
+/// or leap for the controller, and the optional second argument is the replay speed: 1 is real time, N is N times
+/// faster than real time, and 0 is as fast as possible.
+///
+/// Several sources separated by + are fused into one, see fused_frame_source.  Their clocks are aligned by when
+/// their frames arrive, so recordings that are fused should be replayed in real time.
+///
+/// @param argc number of arguments
+/// @param argv the arguments, not including the program name
+///
+/// @return the frame source
+std::unique_ptr<frame_source> make_frame_source (int argc, char **argv)
+{
+    // split the arguments at each +
+    std::vector<int> starts (1, 0);
+    for (int i = 0; i < argc; ++i)
+        if (std::string (argv[i]) == "+")
+            starts.push_back (i + 1);
+    if (starts.size () == 1)
+        return make_single_frame_source (argc, argv);
+    std::unique_ptr<fused_frame_source> f (new fused_frame_source);
+    size_t controllers = 0;
+    for (size_t i = 0; i < starts.size (); ++i)
+    {
+        const int n = (i + 1 < starts.size () ? starts[i + 1] - 1 : argc) - starts[i];
+        if (n == 0)
+            throw std::runtime_error ("missing frame source on one side of a +");
+        std::unique_ptr<frame_source> src = make_single_frame_source (n, argv + starts[i]);
+        // the controller sends the same frames to every listener
+        if (dynamic_cast<leap_frame_source *> (src.get ()) && ++controllers > 1)
+            throw std::runtime_error ("only one leap frame source can be used");
+        f->add_source (std::move (src));
+    }
+    return std::unique_ptr<frame_source> (f.release ());
+}
+
+}
+
+#endif
@@ -0,0 +1,541 @@
+/// @file fused_frame_source.h
+/// @brief drive one pipeline from several frame sources
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-07
+
+#ifndef FUSED_FRAME_SOURCE_H
+#define FUSED_FRAME_SOURCE_H
+
+#include "clock_mapper.h"
+#include "frame_source.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief fusion parameters
+struct fusion_parameters
+{
+    /// @brief fingers from different sources that are closer than this are the same finger, in mm
+    float match_distance;
+    /// @brief hands from different sources whose palms are closer than this are the same hand, in mm
+    float hand_match_distance;
+    /// @brief another source's last frame is only fused if it is within this much of the newest frame, in useconds
+    uint64_t max_age;
+    /// @brief how far back a source's clock offset and drift estimate looks, in useconds
+    uint64_t offset_window;
+    /// @brief how much each new measurement moves the latency and noise estimates
+    double alpha;
+    /// @brief noise variance a source starts out with, in mm^2
+    double initial_noise;
+    fusion_parameters ()
+        : match_distance (20.0f)
+        , hand_match_distance (60.0f)
+        , max_age (25000)
+        , offset_window (30000000)
+        , alpha (0.02)
+        , initial_noise (4.0)
+    {
+    }
+};
+
+/// @brief what a fused_frame_source has learned about one of its sources
+struct fusion_source_stats
+{
+    /// @brief frames received
+    uint64_t frames;
+    /// @brief added to the source's timestamps to put them on the common clock, in useconds
+    int64_t offset;
+    /// @brief how fast the common clock gains on the source's clock, in parts per million
+    double drift;
+    /// @brief average time a frame spent getting to us, beyond the fastest one, in useconds
+    double latency;
+    /// @brief tracking noise variance, in mm^2
+    double noise;
+    fusion_source_stats ()
+        : frames (0)
+        , offset (0)
+        , drift (0.0)
+        , latency (0.0)
+        , noise (0.0)
+    {
+    }
+};
+
+/// @brief merge the frames of several sources into one stream of frames
+///
+/// Each source's timestamps are put on a common clock, the host clock, by a clock_mapper that follows the offset
+/// and drift between the source's clock and the host's.  How much later than that a source's frames arrive, on
+/// average, is the source's latency.
+///
+/// Every frame that arrives is fused with the last frame of each of the other sources, if that frame is recent, and
+/// the result is sent on, so the fused stream has the combined frame rate of the sources.  The other sources' fingers
+/// are moved forward to the new frame's time using their velocities, and matched to its fingers by nearest
+/// neighbour.  Matched fingers are averaged, weighted by the inverse of each source's noise, which is estimated from
+/// how well each finger's position is predicted by its previous position and velocity.  Fingers only one source can
+/// see are kept, which widens the field of view.
+///
+/// Finger and hand ids are given out by the fused source and stay the same while any source keeps seeing the
+/// finger, and fused timestamps are strictly increasing, so the rest of the pipeline sees a single controller.
+class fused_frame_source : public frame_source
+{
+    public:
+    /// @brief most sources that can be fused
+    static const size_t MAX_SOURCES = 4;
+    private:
+    /// @brief how long a source finger or hand keeps its fused id after it goes out of view
+    static const uint64_t ALIAS_LINGER = 1000000;
+    /// @brief a source, and what has been learned about it
+    struct input : public frame_listener
+    {
+        fused_frame_source *owner;
+        uint32_t index;
+        std::unique_ptr<frame_source> src;
+        vec3 origin;
+        fusion_source_stats stats;
+        clock_mapper cm;
+        /// @brief the last frame, on the common clock and in common coordinates
+        frame last;
+        uint64_t last_source_ts;
+        input (uint64_t offset_window)
+            : cm (offset_window, 15)
+        {
+        }
+        virtual void on_frame (const frame &f)
+        {
+            owner->add (*this, f);
+        }
+    };
+    /// @brief a finger or hand in a source
+    struct member
+    {
+        uint32_t source;
+        int32_t id;
+    };
+    /// @brief the fused id of a finger or hand in a source
+    struct alias
+    {
+        uint32_t source;
+        int32_t id;
+        int32_t fused_id;
+        uint64_t ts;
+    };
+    /// @brief a fused finger or hand, and the weighted sums that make it up
+    struct cluster
+    {
+        double w;
+        vec3 position;
+        vec3 velocity;
+        vec3 direction;
+        int hand;
+        size_t n;
+        member members[MAX_SOURCES];
+        cluster ()
+            : w (0.0)
+            , hand (-1)
+            , n (0)
+        {
+        }
+        vec3 mean () const
+        {
+            return position / w;
+        }
+        void add (double x, uint32_t source, const finger &f, const vec3 &p, int h)
+        {
+            w += x;
+            position += p * x;
+            velocity += f.velocity * x;
+            direction += f.direction * x;
+            if (hand == -1)
+                hand = h;
+            const member m = { source, f.id };
+            members[n++] = m;
+        }
+    };
+    const fusion_parameters p;
+    std::vector<std::unique_ptr<input>> inputs;
+    frame_listener *l;
+    mutable std::mutex m;
+    std::atomic<size_t> running;
+    int64_t next_frame_id;
+    uint64_t last_ts;
+    int32_t next_finger_id;
+    int32_t next_hand_id;
+    std::vector<alias> finger_aliases;
+    std::vector<alias> hand_aliases;
+    // the frame being built
+    size_t nclusters;
+    cluster clusters[hand_sample::MAX_FINGERS];
+    size_t nhand_clusters;
+    cluster hand_clusters[frame::MAX_HANDS];
+    void update_clock (input &in, uint64_t ts, uint64_t now)
+    {
+        in.cm.add (ts, now);
+        in.stats.offset = in.cm.get_offset ();
+        in.stats.drift = in.cm.get_drift ();
+        const double x = static_cast<double> (now) - static_cast<double> (in.cm.to_host (ts));
+        in.stats.latency = in.stats.frames == 0 ? x : (1.0 - p.alpha) * in.stats.latency + p.alpha * x;
+    }
+    /// @brief compare a frame with what the last frame predicted
+    void update_noise (input &in, const frame &g, uint64_t ts)
+    {
+        if (in.stats.frames == 0)
+            return;
+        const double dt = (static_cast<double> (ts) - in.last_source_ts) / 1000000.0;
+        const double max_e2 = p.match_distance * p.match_distance;
+        for (auto &i : g.s)
+        {
+            for (auto &j : in.last.s)
+            {
+                if (i.id != j.id)
+                    continue;
+                const vec3 e = i.position - (j.position + j.velocity * dt);
+                const double e2 = e.dot (e);
+                // a big jump is an id swap or a new finger, not noise
+                if (e2 < max_e2)
+                    in.stats.noise = (1.0 - p.alpha) * in.stats.noise + p.alpha * e2;
+            }
+        }
+    }
+    /// @brief fuse one source's frame into the frame being built
+    ///
+    /// @param in the source
+    /// @param dt how far to move the frame forward in time, in seconds
+    void merge (const input &in, double dt)
+    {
+        const frame &g = in.last;
+        const double w = 1.0 / std::max (in.stats.noise, 1e-6);
+        // match hands by palm position
+        int hand_map[frame::MAX_HANDS] = { -1, -1 };
+        const size_t nh = g.has_hands ? g.nhands : 0;
+        const size_t old_hands = nhand_clusters;
+        bool hand_taken[frame::MAX_HANDS] = { false };
+        for (size_t i = 0; i < nh; ++i)
+        {
+            float best = p.hand_match_distance;
+            for (size_t j = 0; j < old_hands; ++j)
+            {
+                const float d = hand_clusters[j].mean ().distanceTo (g.hands[i].palm_position);
+                if (d < best && !hand_taken[j])
+                {
+                    best = d;
+                    hand_map[i] = j;
+                }
+            }
+            if (hand_map[i] == -1 && nhand_clusters < frame::MAX_HANDS)
+            {
+                hand_map[i] = nhand_clusters;
+                hand_clusters[nhand_clusters++] = cluster ();
+            }
+            if (hand_map[i] != -1)
+            {
+                hand_taken[hand_map[i]] = true;
+                cluster &c = hand_clusters[hand_map[i]];
+                c.w += w;
+                c.position += g.hands[i].palm_position * w;
+                c.direction += g.hands[i].palm_normal * w;
+                const member x = { in.index, g.hands[i].id };
+                c.members[c.n++] = x;
+            }
+        }
+        // where the fingers are now, and which fused hand they belong to
+        vec3 pos[hand_sample::MAX_FINGERS];
+        int hands[hand_sample::MAX_FINGERS];
+        for (size_t i = 0; i < g.s.size (); ++i)
+        {
+            pos[i] = g.s[i].position + g.s[i].velocity * dt;
+            hands[i] = -1;
+            for (size_t j = 0; j < nh; ++j)
+                if (g.hands[j].fingers & (1 << i))
+                    hands[i] = hand_map[j];
+        }
+        // match fingers to the fingers already there, closest pairs first
+        struct pair
+        {
+            float d;
+            uint8_t i;
+            uint8_t j;
+            bool operator< (const pair &x) const { return d < x.d; }
+        };
+        pair pairs[hand_sample::MAX_FINGERS * hand_sample::MAX_FINGERS];
+        size_t npairs = 0;
+        const size_t old_clusters = nclusters;
+        for (size_t i = 0; i < g.s.size (); ++i)
+        {
+            for (size_t j = 0; j < old_clusters; ++j)
+            {
+                const float d = clusters[j].mean ().distanceTo (pos[i]);
+                if (d < p.match_distance)
+                {
+                    const pair x = { d, static_cast<uint8_t> (i), static_cast<uint8_t> (j) };
+                    pairs[npairs++] = x;
+                }
+            }
+        }
+        std::sort (pairs, pairs + npairs);
+        bool used[hand_sample::MAX_FINGERS] = { false };
+        bool taken[hand_sample::MAX_FINGERS] = { false };
+        for (size_t k = 0; k < npairs; ++k)
+        {
+            const pair &x = pairs[k];
+            if (used[x.i] || taken[x.j])
+                continue;
+            used[x.i] = taken[x.j] = true;
+            clusters[x.j].add (w, in.index, g.s[x.i], pos[x.i], hands[x.i]);
+        }
+        // fingers that only this source can see
+        for (size_t i = 0; i < g.s.size () && nclusters < hand_sample::MAX_FINGERS; ++i)
+        {
+            if (used[i])
+                continue;
+            cluster &c = clusters[nclusters++];
+            c = cluster ();
+            c.add (w, in.index, g.s[i], pos[i], hands[i]);
+        }
+    }
+    /// @brief get the fused id of a finger or hand, and remember it for each of the source ids that went into it
+    ///
+    /// @param a the aliases
+    /// @param c the fused finger or hand
+    /// @param ts the time
+    /// @param next the next new id
+    /// @param in_use fused ids already given out in this frame
+    /// @param n number of ids in use
+    int32_t fused_id (std::vector<alias> &a, const cluster &c, uint64_t ts, int32_t &next, const int32_t *in_use, size_t n)
+    {
+        int32_t id = -1;
+        for (size_t i = 0; i < c.n && id == -1; ++i)
+        {
+            for (auto &j : a)
+            {
+                if (j.source == c.members[i].source && j.id == c.members[i].id
+                    && std::find (in_use, in_use + n, j.fused_id) == in_use + n)
+                {
+                    id = j.fused_id;
+                    break;
+                }
+            }
+        }
+        if (id == -1)
+            id = next++;
+        for (size_t i = 0; i < c.n; ++i)
+        {
+            bool found = false;
+            for (auto &j : a)
+            {
+                if (j.source == c.members[i].source && j.id == c.members[i].id)
+                {
+                    j.fused_id = id;
+                    j.ts = ts;
+                    found = true;
+                }
+            }
+            if (!found)
+            {
+                const alias x = { c.members[i].source, c.members[i].id, id, ts };
+                a.push_back (x);
+            }
+        }
+        return id;
+    }
+    static void expire (std::vector<alias> &a, uint64_t ts)
+    {
+        a.erase (std::remove_if (a.begin (), a.end (), [&] (const alias &x) { return x.ts + ALIAS_LINGER < ts; }),
+            a.end ());
+    }
+    /// @brief fuse the newest frame with the other sources' last frames
+    void fuse (const input &newest, frame &f)
+    {
+        nclusters = 0;
+        nhand_clusters = 0;
+        const uint64_t ts = newest.last.ts;
+        bool has_hands = newest.last.has_hands;
+        merge (newest, 0.0);
+        for (auto &i : inputs)
+        {
+            if (i.get () == &newest || i->stats.frames == 0)
+                continue;
+            const double dt = static_cast<double> (ts) - static_cast<double> (i->last.ts);
+            if (std::fabs (dt) > p.max_age)
+                continue;
+            has_hands = has_hands || i->last.has_hands;
+            merge (*i, dt / 1000000.0);
+        }
+        expire (finger_aliases, ts);
+        expire (hand_aliases, ts);
+        f.id = next_frame_id++;
+        f.ts = std::max (ts, last_ts + 1);
+        last_ts = f.ts;
+        f.host_ts = newest.last.host_ts;
+        f.has_hands = has_hands;
+        f.nhands = nhand_clusters;
+        int32_t ids[hand_sample::MAX_FINGERS];
+        for (size_t i = 0; i < nhand_clusters; ++i)
+        {
+            const cluster &c = hand_clusters[i];
+            hand &h = f.hands[i];
+            h = hand ();
+            h.id = fused_id (hand_aliases, c, ts, next_hand_id, ids, i);
+            ids[i] = h.id;
+            h.palm_position = c.mean ();
+            h.palm_normal = c.direction.normalized ();
+        }
+        // put the fingers left to right, and tell the hands where they went
+        size_t order[hand_sample::MAX_FINGERS];
+        for (size_t i = 0; i < nclusters; ++i)
+            order[i] = i;
+        std::sort (order, order + nclusters, [&] (size_t a, size_t b)
+            { return clusters[a].position.x / clusters[a].w < clusters[b].position.x / clusters[b].w; });
+        f.s.resize (nclusters);
+        for (size_t i = 0; i < nclusters; ++i)
+        {
+            const cluster &c = clusters[order[i]];
+            finger &j = f.s[i];
+            j.id = fused_id (finger_aliases, c, ts, next_finger_id, ids, i);
+            ids[i] = j.id;
+            j.position = c.mean ();
+            j.velocity = c.velocity / c.w;
+            j.direction = c.direction.normalized ();
+            if (c.hand != -1)
+                f.hands[c.hand].fingers |= 1 << i;
+        }
+    }
+    void add (input &in, const frame &f)
+    {
+        const uint64_t now = f.host_ts ? f.host_ts : host_now ();
+        std::lock_guard<std::mutex> lock (m);
+        update_clock (in, f.ts, now);
+        // put the frame on the common clock and in common coordinates
+        frame g (f);
+        g.ts = in.cm.to_host (f.ts);
+        g.host_ts = now;
+        for (auto &i : g.s)
+            i.position += in.origin;
+        for (size_t i = 0; i < g.nhands; ++i)
+            g.hands[i].palm_position += in.origin;
+        update_noise (in, g, f.ts);
+        in.last = g;
+        in.last_source_ts = f.ts;
+        ++in.stats.frames;
+        frame fused;
+        fuse (in, fused);
+        l->on_frame (fused);
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param p parameters
+    fused_frame_source (const fusion_parameters &p = fusion_parameters ())
+        : p (p)
+        , l (0)
+        , running (0)
+        , next_frame_id (0)
+        , last_ts (0)
+        , next_finger_id (1)
+        , next_hand_id (1)
+        , nclusters (0)
+        , nhand_clusters (0)
+    {
+    }
+    ~fused_frame_source ()
+    {
+        stop ();
+    }
+    /// @brief add a source, before start () is called
+    ///
+    /// @param src the source
+    /// @param origin where the source's origin is in the first source's coordinates, in mm
+    void add_source (std::unique_ptr<frame_source> src, const vec3 &origin = vec3 (0, 0, 0))
+    {
+        assert (!l);
+        if (inputs.size () == MAX_SOURCES)
+            throw std::runtime_error ("too many frame sources");
+        std::unique_ptr<input> in (new input (p.offset_window));
+        in->owner = this;
+        in->index = inputs.size ();
+        in->src = std::move (src);
+        in->origin = origin;
+        inputs.push_back (std::move (in));
+    }
+    /// @brief number of sources
+    size_t size () const
+    {
+        return inputs.size ();
+    }
+    /// @brief what has been learned about a source
+    ///
+    /// @param i the source's index
+    fusion_source_stats get_stats (size_t i) const
+    {
+        assert (i < inputs.size ());
+        std::lock_guard<std::mutex> lock (m);
+        return inputs[i]->stats;
+    }
+    /// @brief start all of the sources, the fused source is done when they all are
+    virtual void start (frame_listener &l)
+    {
+        assert (!this->l);
+        assert (!inputs.empty ());
+        this->l = &l;
+        done.reset ();
+        running = inputs.size ();
+        for (auto &i : inputs)
+        {
+            i->stats = fusion_source_stats ();
+            i->cm.clear ();
+            i->stats.noise = p.initial_noise;
+            i->src->get_done ().on_set ([this] ()
+                {
+                    if (--running == 0)
+                        done.set ();
+                });
+            i->src->start (*i);
+        }
+    }
+    virtual void stop ()
+    {
+        for (auto &i : inputs)
+            i->src->stop ();
+        l = 0;
+    }
+    virtual bool is_live () const
+    {
+        for (auto &i : inputs)
+            if (i->src->is_live ())
+                return true;
+        return false;
+    }
+};
+
+/// @brief print what a fused source has learned about its sources
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param f the fused source
+template<typename S>
+void print_stats (S &s, const fused_frame_source &f)
+{
+    for (size_t i = 0; i < f.size (); ++i)
+    {
+        const fusion_source_stats x = f.get_stats (i);
+        s << "source " << i << ": "
+            << x.frames << " frames, "
+            << x.offset << "us offset, "
+            << x.drift << "ppm drift, "
+            << x.latency << "us latency, "
+            << std::sqrt (x.noise) << "mm noise" << std::endl;
+    }
+}
+
+}
+
+#endif
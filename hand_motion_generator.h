@@ -0,0 +1,348 @@
+/// @file hand_motion_generator.h
+/// @brief generate synthetic hand motion
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-26
+
+#ifndef HAND_MOTION_GENERATOR_H
+#define HAND_MOTION_GENERATOR_H
+
+#include "frame_source.h"
+#include "hand_shape_classifier.h"
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace soma
+{
+
+/// @brief gestures that the generator can make
+enum class gesture
+{
+    none,
+    pointing1,
+    pointing2,
+    pinching,
+    scrolling,
+    centering,
+};
+
+std::string to_string (const gesture g)
+{
+    switch (g)
+    {
+        default: assert (0); // logic error
+        case gesture::none: return std::string ("none");
+        case gesture::pointing1: return std::string ("pointing1");
+        case gesture::pointing2: return std::string ("pointing2");
+        case gesture::pinching: return std::string ("pinching");
+        case gesture::scrolling: return std::string ("scrolling");
+        case gesture::centering: return std::string ("centering");
+    }
+}
+
+/// @brief the hand shape that should be recognized for a gesture
+///
+/// @param g the gesture
+///
+/// @return the hand shape
+hand_shape expected_shape (const gesture g)
+{
+    switch (g)
+    {
+        default: assert (0); // logic error
+        case gesture::none: return hand_shape::zero;
+        case gesture::pointing1: return hand_shape::pointing;
+        case gesture::pointing2: return hand_shape::pointing;
+        case gesture::pinching: return hand_shape::pointing;
+        case gesture::scrolling: return hand_shape::scrolling;
+        case gesture::centering: return hand_shape::centering;
+    }
+}
+
+/// @brief ground truth for a generated frame
+struct gesture_label
+{
+    /// @brief the gesture being made
+    gesture g;
+    /// @brief timestamp of the frame where the gesture started
+    uint64_t onset_ts;
+    /// @brief true if this frame is the first frame of the gesture
+    bool onset;
+    /// @brief true if noise changed the number of fingers in this frame
+    bool flicker;
+    /// @brief true if noise swapped two finger ids in this frame
+    bool id_swap;
+    /// @brief true if a spurious second hand is in this frame
+    bool second_hand;
+};
+
+/// @brief generator parameters
+struct hand_motion_parameters
+{
+    /// @brief frames per second
+    double fps;
+    /// @brief tracking noise standard deviation in mm
+    double noise;
+    /// @brief probability that a frame has a spurious finger count
+    double flicker;
+    /// @brief probability that a frame has two finger ids swapped
+    double id_swap;
+    /// @brief probability that a second hand wanders into view in a frame, it stays for 0.1 to 1 seconds
+    double second_hand;
+    /// @brief shortest gesture in useconds
+    uint64_t min_duration;
+    /// @brief longest gesture in useconds
+    uint64_t max_duration;
+    /// @brief random number seed
+    unsigned seed;
+    hand_motion_parameters ()
+        : fps (120)
+        , noise (0.5)
+        , flicker (0.01)
+        , id_swap (0.001)
+        , second_hand (0.0)
+        , min_duration (1000000)
+        , max_duration (3000000)
+        , seed (0)
+    {
+    }
+};
+
+/// @brief generate a stream of frames containing known gestures
+class hand_motion_generator
+{
+    private:
+    /// @brief pinch cycle period in useconds
+    static const uint64_t PINCH_PERIOD = 1200000;
+    static const uint64_t START_TS = 1000000;
+    /// @brief hand ids
+    static const int32_t HAND_ID = 1;
+    static const int32_t SECOND_HAND_ID = 2;
+    /// @brief finger ids of the second hand start here
+    static const int32_t SECOND_HAND_FINGER_ID = 1 << 30;
+    hand_motion_parameters p;
+    std::mt19937 rng;
+    std::normal_distribution<double> n;
+    std::uniform_real_distribution<double> u;
+    uint64_t frames;
+    gesture current;
+    uint64_t onset_ts;
+    uint64_t end_ts;
+    int32_t next_id;
+    int32_t ids[5];
+    uint64_t second_hand_end_ts;
+    size_t second_hand_fingers;
+    /// @brief pick the next gesture and how long it lasts
+    void next_gesture (uint64_t ts)
+    {
+        gesture g;
+        do { g = static_cast<gesture> (rng () % 6); }
+        while (g == current);
+        current = g;
+        onset_ts = ts;
+        const uint64_t range = p.max_duration - p.min_duration;
+        end_ts = ts + p.min_duration + (range ? rng () % range : 0);
+        // fingers get new ids when they reappear
+        for (auto &i : ids)
+            i = next_id++;
+    }
+    /// @brief where the hand is at time t
+    vec3 hand_position (double t) const
+    {
+        return vec3 (60 * sin (0.7 * t), 200 + 40 * sin (1.1 * t), 20 * sin (0.3 * t));
+    }
+    /// @brief where the fingers are relative to the hand at time t
+    size_t finger_offsets (gesture g, double t, vec3 *o) const
+    {
+        switch (g)
+        {
+            default: assert (0); // logic error
+            case gesture::none:
+            return 0;
+            case gesture::pointing1:
+            o[0] = vec3 (0, 40, -30);
+            return 1;
+            case gesture::pointing2:
+            o[0] = vec3 (-60, 0, 0);
+            o[1] = vec3 (0, 40, -30);
+            return 2;
+            case gesture::pinching:
+            {
+                // open long enough for the pinch detector, then close, then open again
+                const double OPEN = 80.0;
+                const double CLOSED = 20.0;
+                const double phase = fmod (t * 1000000, PINCH_PERIOD) / PINCH_PERIOD;
+                const double d = phase < 0.6 ? OPEN : CLOSED;
+                o[0] = vec3 (-d, 0, 0);
+                o[1] = vec3 (0, 0, 0);
+                return 2;
+            }
+            case gesture::scrolling:
+            {
+                // thumb on left, close to the index finger, hand moving up and down
+                const double dy = 30 * sin (6 * t);
+                o[0] = vec3 (-25, dy - 10, 0);
+                o[1] = vec3 (0, dy, -20);
+                o[2] = vec3 (20, dy, -20);
+                return 3;
+            }
+            case gesture::centering:
+            o[0] = vec3 (-80, -10, 0);
+            o[1] = vec3 (-35, 40, -20);
+            o[2] = vec3 (0, 50, -25);
+            o[3] = vec3 (30, 45, -20);
+            o[4] = vec3 (60, 25, -10);
+            return 5;
+        }
+    }
+    vec3 noise ()
+    {
+        return vec3 (p.noise * n (rng), p.noise * n (rng), p.noise * n (rng));
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param p generator parameters
+    hand_motion_generator (const hand_motion_parameters &p = hand_motion_parameters ())
+        : p (p)
+        , rng (p.seed)
+        , frames (0)
+        , current (gesture::none)
+        , onset_ts (0)
+        , end_ts (0)
+        , next_id (1)
+        , second_hand_end_ts (0)
+        , second_hand_fingers (0)
+    {
+        assert (p.fps > 0.0);
+        assert (p.max_duration >= p.min_duration);
+    }
+    /// @brief generate the next frame
+    ///
+    /// @param f the frame
+    /// @param l the frame's ground truth
+    void next (frame &f, gesture_label &l)
+    {
+        f.id = frames;
+        f.ts = START_TS + static_cast<uint64_t> (frames * 1000000 / p.fps);
+        ++frames;
+        l.onset = (f.ts >= end_ts);
+        if (l.onset)
+            next_gesture (f.ts);
+        l.g = current;
+        l.onset_ts = onset_ts;
+        l.flicker = false;
+        l.id_swap = false;
+        l.second_hand = false;
+        // compute positions at this time and a little later to get velocities
+        const double t = f.ts / 1000000.0;
+        const double dt = 0.001;
+        vec3 o0[5];
+        vec3 o1[5];
+        size_t nf = finger_offsets (current, t, o0);
+        finger_offsets (current, t + dt, o1);
+        const vec3 h0 = hand_position (t);
+        const vec3 h1 = hand_position (t + dt);
+        // spurious finger counts
+        if (u (rng) < p.flicker)
+        {
+            l.flicker = true;
+            if (nf == 5 || (nf > 0 && rng () % 2))
+                --nf;
+            else
+            {
+                o0[nf] = o1[nf] = vec3 (50, -30, 10);
+                ++nf;
+            }
+        }
+        f.s.resize (nf);
+        for (size_t i = 0; i < nf; ++i)
+        {
+            finger &j = f.s[i];
+            j.id = ids[i];
+            j.position = h0 + o0[i] + noise ();
+            j.velocity = ((h1 + o1[i]) - (h0 + o0[i])) / dt;
+            j.direction = vec3 (0, 0, -1);
+        }
+        f.has_hands = true;
+        f.nhands = 1;
+        f.hands[0] = hand ();
+        f.hands[0].id = HAND_ID;
+        f.hands[0].palm_position = h0 + vec3 (0, -40, 20);
+        f.hands[0].palm_normal = vec3 (0, -1, 0);
+        // a second hand wanders in to the right for a while, with one to four fingers showing
+        if (f.ts >= second_hand_end_ts && p.second_hand > 0.0 && u (rng) < p.second_hand)
+        {
+            second_hand_end_ts = f.ts + 100000 + rng () % 900000;
+            second_hand_fingers = 1 + rng () % 4;
+        }
+        if (f.ts < second_hand_end_ts)
+        {
+            l.second_hand = true;
+            const vec3 h2 = h0 + vec3 (150, -20, 0);
+            for (size_t i = 0; i < second_hand_fingers; ++i)
+            {
+                finger j;
+                j.id = SECOND_HAND_FINGER_ID + i;
+                j.position = h2 + vec3 (25 * i, 40, -20) + noise ();
+                j.direction = vec3 (0, 0, -1);
+                f.s.push_back (j);
+            }
+            f.nhands = 2;
+            f.hands[1] = hand ();
+            f.hands[1].id = SECOND_HAND_ID;
+            f.hands[1].palm_position = h2;
+            f.hands[1].palm_normal = vec3 (0, -1, 0);
+        }
+        // id swaps
+        if (nf > 1 && u (rng) < p.id_swap)
+        {
+            l.id_swap = true;
+            const size_t a = rng () % nf;
+            const size_t b = (a + 1) % nf;
+            std::swap (f.s[a].id, f.s[b].id);
+        }
+        std::sort (f.s.begin (), f.s.end (), sort_left_to_right);
+        for (size_t i = 0; i < f.s.size (); ++i)
+            f.hands[f.s[i].id >= SECOND_HAND_FINGER_ID].fingers |= 1 << i;
+    }
+    /// @brief generate the next frame
+    ///
+    /// @param f the frame
+    void next (frame &f)
+    {
+        gesture_label l;
+        next (f, l);
+    }
+};
+
+/// @brief a generated_frame_source generator that makes a fixed number of frames
+class hand_motion_frames
+{
+    private:
+    hand_motion_generator g;
+    uint64_t remaining;
+    public:
+    /// @brief constructor
+    ///
+    /// @param p generator parameters
+    /// @param total total number of frames to generate
+    hand_motion_frames (const hand_motion_parameters &p, uint64_t total)
+        : g (p)
+        , remaining (total)
+    {
+    }
+    bool operator() (frame &f)
+    {
+        if (remaining == 0)
+            return false;
+        --remaining;
+        g.next (f);
+        return true;
+    }
+};
+
+}
+
+#endif
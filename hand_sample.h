@@ -8,8 +8,10 @@
 #define HAND_SAMPLE_H
 
 #include <algorithm>
+#include <cassert>
 #include <cstdint>
 #include <limits>
+#include <vector>
 #include "stats.h"
 #include "Leap.h"
 
@@ -30,6 +32,32 @@ struct finger
     }
 };
 
+/// @brief a hand, and which of a sample's fingers belong to it
+struct hand
+{
+    /// @brief hand id
+    int32_t id;
+    /// @brief bit i is set when finger i of the sample belongs to this hand
+    uint16_t fingers;
+    /// @brief unused, must be zero
+    uint16_t reserved;
+    /// @brief palm center
+    vec3 palm_position;
+    /// @brief unit vector pointing out of the palm
+    vec3 palm_normal;
+    hand ()
+        : id (-1)
+        , fingers (0)
+        , reserved (0)
+    {
+    }
+    /// @brief number of fingers
+    size_t size () const
+    {
+        return __builtin_popcount (fingers);
+    }
+};
+
 bool sort_by_id (const finger &a, const finger &b)
 {
     return a.id < b.id;
@@ -50,25 +78,137 @@ bool sort_back_to_front (const finger &a, const finger &b)
     return a.position.z < b.position.z;
 }
 
-class hand_sample : public std::vector<finger>
+/// @brief the fingers in a frame
+///
+/// The fingers are stored inline, so making, copying and sorting samples never touches the heap.
+class hand_sample
 {
     public:
+    /// @brief most fingers a sample can hold
+    static const size_t MAX_FINGERS = 10;
+    typedef finger value_type;
+    typedef finger &reference;
+    typedef const finger &const_reference;
+    typedef finger *iterator;
+    typedef const finger *const_iterator;
+    typedef size_t size_type;
+    private:
+    size_t n;
+    finger fingers[MAX_FINGERS];
+    public:
+    hand_sample ()
+        : n (0)
+    {
+    }
     hand_sample (const Leap::PointableList &pl)
+        : n (0)
     {
-        resize (pl.count ());
         // get the relevant info from the list
-        for (int i = 0; i < pl.count () && i < 5; ++i)
+        for (int i = 0; i < pl.count () && n < MAX_FINGERS; ++i)
         {
-            data ()[i].id = pl[i].id ();
-            data ()[i].position = pl[i].tipPosition ();
-            data ()[i].velocity = pl[i].tipVelocity ();
-            data ()[i].direction = pl[i].direction ();
+            finger &f = fingers[n++];
+            f.id = pl[i].id ();
+            f.position = pl[i].tipPosition ();
+            f.velocity = pl[i].tipVelocity ();
+            f.direction = pl[i].direction ();
         }
         // sort by x position
         std::sort (begin (), end (), sort_left_to_right);
     }
+    /// @brief construct from fingers that are already sorted left to right
+    ///
+    /// Fingers past MAX_FINGERS are dropped.
+    ///
+    /// @tparam I iterator type
+    /// @param b first finger
+    /// @param e one past the last finger
+    template<typename I>
+    hand_sample (I b, I e)
+        : n (0)
+    {
+        assign (b, e);
+    }
+    /// @brief copy only the fingers that are in use
+    hand_sample (const hand_sample &s)
+        : n (s.n)
+    {
+        std::copy (s.begin (), s.end (), fingers);
+    }
+    hand_sample &operator= (const hand_sample &s)
+    {
+        n = s.n;
+        std::copy (s.begin (), s.end (), fingers);
+        return *this;
+    }
+    /// @brief replace the fingers
+    ///
+    /// Fingers past MAX_FINGERS are dropped, so a damaged recording can't write past the end of the fingers.
+    ///
+    /// @tparam I iterator type
+    /// @param b first finger
+    /// @param e one past the last finger
+    template<typename I>
+    void assign (I b, I e)
+    {
+        n = 0;
+        for (; b != e && n < MAX_FINGERS; ++b)
+            fingers[n++] = *b;
+    }
+    size_t size () const { return n; }
+    size_t capacity () const { return MAX_FINGERS; }
+    bool empty () const { return n == 0; }
+    finger *data () { return fingers; }
+    const finger *data () const { return fingers; }
+    iterator begin () { return fingers; }
+    iterator end () { return fingers + n; }
+    const_iterator begin () const { return fingers; }
+    const_iterator end () const { return fingers + n; }
+    finger &operator[] (size_t i) { assert (i < n); return fingers[i]; }
+    const finger &operator[] (size_t i) const { assert (i < n); return fingers[i]; }
+    finger &front () { assert (n); return fingers[0]; }
+    const finger &front () const { assert (n); return fingers[0]; }
+    finger &back () { assert (n); return fingers[n - 1]; }
+    const finger &back () const { assert (n); return fingers[n - 1]; }
+    void clear () { n = 0; }
+    void push_back (const finger &f)
+    {
+        assert (n < MAX_FINGERS);
+        fingers[n++] = f;
+    }
+    void pop_back ()
+    {
+        assert (n);
+        --n;
+    }
+    /// @brief change the number of fingers, new fingers are default constructed
+    ///
+    /// @param sz the new size, no more than MAX_FINGERS
+    void resize (size_t sz)
+    {
+        assert (sz <= MAX_FINGERS);
+        for (size_t i = n; i < sz; ++i)
+            fingers[i] = finger ();
+        n = sz;
+    }
 };
 
+static_assert (hand_sample::MAX_FINGERS <= 16, "hand::fingers needs a bit for each finger");
+
+/// @brief get the fingers that belong to a hand
+///
+/// @param s all of the fingers
+/// @param h the hand
+///
+/// @return the hand's fingers, in the same order as they are in s
+hand_sample hand_fingers (const hand_sample &s, const hand &h)
+{
+    hand_sample r;
+    for (size_t i = 0; i < s.size (); ++i)
+        if (h.fingers & (1 << i))
+            r.push_back (s[i]);
+    return r;
+}
+
 typedef std::vector<hand_sample> hand_samples;
 
 hand_samples filter_by_num_fingers (const hand_samples &s)
@@ -83,7 +223,7 @@ hand_samples filter_by_num_fingers (const hand_samples &s)
     //std::clog << "mode of number of fingers " << nf << std::endl;
     // build new vector containing only ones with correct number
     hand_samples r;
-    for (auto i : s)
+    for (const auto &i : s)
         if (i.size () == nf)
             r.push_back (i);
     return r;
@@ -96,7 +236,7 @@ hand_samples filter_by_finger_ids (const hand_samples &s)
     // how many fingers are there?
     size_t n = s[0].size ();
     std::vector<std::vector<int32_t>> ids (n);
-    for (auto i : s)
+    for (const auto &i : s)
     {
         // each hand sample should have the same number of fingers
         assert (i.size () == n);
@@ -112,7 +252,7 @@ hand_samples filter_by_finger_ids (const hand_samples &s)
     }
     // build new vector containing only ones with correct ids
     hand_samples r;
-    for (auto i : s)
+    for (const auto &i : s)
     {
         bool good = true;
         for (size_t j = 0; j < n; ++j)
@@ -4,36 +4,42 @@
 /// @version 1.0
 /// @date 2013-09-20
 
+#include "event_loop.h"
+#include "frame_sources.h"
 #include "hand_shape_classifier.h"
-#include "Leap.h"
+#include "hand_tracker.h"
 #include <stdexcept>
 #include <unistd.h>
 
 using namespace std;
 using namespace soma;
-const string usage = "usage: hand_shape_classifier";
+const string usage = "usage: hand_shape_classifier " + frame_source_usage;
 
-class grabber : public Leap::Listener
+class grabber : public frame_listener
 {
     private:
-    hand_shape_classifier hsc;
+    /// @brief a classifier for each hand
+    hand_tracker<hand_shape_classifier> hands;
     public:
     grabber (uint64_t duration)
-        : hsc (duration)
+        : hands (hand_shape_classifier (duration), duration)
     {
     }
-    virtual void onFrame (const Leap::Controller& c)
+    virtual void on_frame (const frame &f)
     {
-        // get the frame
-        Leap::Frame f = c.frame ();
-        uint64_t ts = f.timestamp ();
-        // get the sample
-        hand_sample s (f.pointables ());
-        // add it to the classifier
-        hsc.add (ts, s);
-        // if it's changed, print the result
-        if (hsc.has_changed ())
-            clog << to_string (hsc.get_shape ()) << endl;
+        hand h[MAX_SPLIT_HANDS];
+        hand_sample s[MAX_SPLIT_HANDS];
+        const size_t n = split_hands (f, h, s);
+        hands.update (f.ts, h, n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            // add it to the hand's classifier
+            hand_shape_classifier &hsc = hands.get (h[i].id);
+            hsc.add (f.ts, s[i]);
+            // if it's changed, print the result
+            if (hsc.has_changed ())
+                clog << "hand " << h[i].id << ": " << to_string (hsc.get_shape ()) << endl;
+        }
     }
 };
 
@@ -41,21 +47,24 @@ int main (int argc, char **argv)
 {
     try
     {
-        if (argc != 1)
+        if (!valid_frame_source_args (argc - 1, argv + 1))
             throw runtime_error (usage);
 
+        // signals are blocked in every thread started after this
+        event_loop loop;
+
         clog << "Press CTRL-C to exit" << endl;
 
         static const uint64_t WINDOW_DURATION = 400000;
         grabber g (WINDOW_DURATION);
-        Leap::Controller c (g);
+        unique_ptr<frame_source> src = make_frame_source (argc - 1, argv + 1);
+        loop.quit_when (src->get_done ());
+        src->start (g);
 
-        // receive frames even when you don't have focus
-        c.setPolicyFlags (Leap::Controller::POLICY_BACKGROUND_FRAMES);
+        // sleep until CTRL-C or the source runs out of frames
+        loop.run ();
 
-        // loop
-        while (1)
-            usleep (5000);
+        src->stop ();
 
         return 0;
     }
@@ -8,6 +8,7 @@
 #define HAND_SHAPE_CLASSIFIER_H
 
 #include "finger_counter.h"
+#include "frame_features.h"
 #include "hand_sample.h"
 #include <cassert>
 #include <string>
@@ -41,11 +42,9 @@ class hand_shape_classifier
 {
     private:
     finger_counter fc;
-    static const uint64_t D = 100000;
-    sliding_window<hand_sample> swhs;
     hand_shape current;
     bool changed;
-    void update (const hand_sample &s)
+    void update ()
     {
         switch (fc.get_count ())
         {
@@ -74,23 +73,30 @@ class hand_shape_classifier
     public:
     hand_shape_classifier (uint64_t duration)
         : fc (duration)
-        , swhs (D)
         , current (hand_shape::unknown)
         , changed (false)
     {
     }
-    void add (uint64_t ts, const hand_sample &s)
+    void add (uint64_t ts, const frame_features &ff)
     {
         hand_shape last = current;
-        fc.add (ts, s.size ());
-        swhs.add (ts, s);
-        update (s);
+        fc.add (ts, ff.size ());
+        update ();
         changed = (last != current);
     }
+    void add (uint64_t ts, const hand_sample &s)
+    {
+        add (ts, frame_features (s));
+    }
     hand_shape get_shape () const
     {
         return current;
     }
+    /// @brief get the finger count the shape is based on, -1 if it is not certain
+    int get_count () const
+    {
+        return fc.get_count ();
+    }
     bool has_changed () const
     {
         return changed;
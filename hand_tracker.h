@@ -0,0 +1,292 @@
+/// @file hand_tracker.h
+/// @brief keep separate state for each hand and pick the hand that drives the pointer
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-06
+
+#ifndef HAND_TRACKER_H
+#define HAND_TRACKER_H
+
+#include "frame_source.h"
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief most hands split_hands () can return, the frame's hands plus one for the fingers no hand claims
+static const size_t MAX_SPLIT_HANDS = frame::MAX_HANDS + 1;
+
+/// @brief split a frame into hands
+///
+/// If the source does not group fingers by hand, all of the fingers are put in one hand whose id is -1, which is
+/// how frames were treated before they had hands.  If it does, the fingers that no hand claims are put in an extra
+/// hand whose id is -1, with its palm at the middle of its fingers, so they aren't lost.
+///
+/// @param f the frame
+/// @param h the hands, must have room for MAX_SPLIT_HANDS
+/// @param s each hand's fingers, left to right, must have room for MAX_SPLIT_HANDS
+///
+/// @return the number of hands
+size_t split_hands (const frame &f, hand *h, hand_sample *s)
+{
+    if (!f.has_hands)
+    {
+        h[0] = hand ();
+        s[0] = f.s;
+        return 1;
+    }
+    assert (f.nhands <= frame::MAX_HANDS);
+    uint32_t claimed = 0;
+    for (size_t i = 0; i < f.nhands; ++i)
+    {
+        h[i] = f.hands[i];
+        s[i] = hand_fingers (f.s, f.hands[i]);
+        claimed |= f.hands[i].fingers;
+    }
+    size_t n = f.nhands;
+    const uint32_t rest = ((1u << f.s.size ()) - 1) & ~claimed;
+    if (rest)
+    {
+        h[n] = hand ();
+        h[n].fingers = rest;
+        s[n] = hand_fingers (f.s, h[n]);
+        vec3 p;
+        for (auto &i : s[n])
+            p += i.position;
+        h[n].palm_position = p / s[n].size ();
+        ++n;
+    }
+    return n;
+}
+
+/// @brief which hand drives the pointer when there is more than one
+enum class hand_policy
+{
+    /// @brief the hand that has been in view the longest
+    first,
+    /// @brief the rightmost hand
+    right,
+    /// @brief the leftmost hand
+    left,
+};
+
+std::string to_string (const hand_policy p)
+{
+    switch (p)
+    {
+        default: assert (0); // logic error
+        case hand_policy::first: return std::string ("first");
+        case hand_policy::right: return std::string ("right");
+        case hand_policy::left: return std::string ("left");
+    }
+}
+
+/// @brief parse a hand policy
+///
+/// @param name first, right or left
+///
+/// @return the policy
+hand_policy to_hand_policy (const std::string &name)
+{
+    if (name == "first")
+        return hand_policy::first;
+    if (name == "right")
+        return hand_policy::right;
+    if (name == "left")
+        return hand_policy::left;
+    throw std::runtime_error ("unknown hand policy: " + name);
+}
+
+/// @brief keep state, like a classifier, for each hand, and decide which hand drives the pointer
+///
+/// A hand's state is kept for a while after the hand goes out of view, so a hand that drops out for a few frames
+/// carries on where it left off.  If the controller loses a hand and finds it again under a new id, the new id
+/// takes over the old state.
+///
+/// Once a hand is driving, it keeps driving until it has been out of view for a while, so a second hand that
+/// wanders in and out of view can't take over the pointer.
+///
+/// @tparam T state type, which must be copyable
+template<typename T>
+class hand_tracker
+{
+    private:
+    struct slot
+    {
+        /// @brief identifies the slot while hand ids come and go
+        uint64_t serial;
+        int32_t id;
+        uint64_t first_ts;
+        uint64_t last_ts;
+        vec3 palm;
+        T state;
+    };
+    /// @brief how close a new hand has to be to a lost one to take over its state, in mm
+    static constexpr float ADOPT_DISTANCE = 80.0f;
+    /// @brief most hands that are remembered
+    static const size_t MAX_SLOTS = 2 * frame::MAX_HANDS;
+    const T prototype;
+    const uint64_t linger;
+    const hand_policy policy;
+    std::vector<slot> slots;
+    uint64_t next_serial;
+    /// @brief serial number of the driver's slot, 0 if there isn't one
+    uint64_t driver;
+    bool changed;
+    slot *find (int32_t id)
+    {
+        for (auto &i : slots)
+            if (i.id == id)
+                return &i;
+        return 0;
+    }
+    const slot *find_serial (uint64_t serial) const
+    {
+        for (auto &i : slots)
+            if (i.serial == serial)
+                return &i;
+        return 0;
+    }
+    /// @brief forget hands that have been out of view too long
+    void expire (uint64_t ts)
+    {
+        for (size_t i = 0; i < slots.size (); )
+        {
+            if (ts - slots[i].last_ts > linger)
+                slots.erase (slots.begin () + i);
+            else
+                ++i;
+        }
+    }
+    /// @brief get the slot for a hand, adding one if it is new
+    slot &get_slot (uint64_t ts, const hand &h, const hand *visible, size_t n)
+    {
+        slot *s = find (h.id);
+        if (s)
+            return *s;
+        // a lost hand nearby is probably the same hand
+        for (auto &i : slots)
+        {
+            if (i.last_ts == ts || i.palm.distanceTo (h.palm_position) > ADOPT_DISTANCE)
+                continue;
+            bool in_view = false;
+            for (size_t j = 0; j < n; ++j)
+                in_view = in_view || visible[j].id == i.id;
+            if (in_view)
+                continue;
+            i.id = h.id;
+            return i;
+        }
+        // make room by forgetting the hand that has been gone longest
+        if (slots.size () == MAX_SLOTS)
+        {
+            size_t oldest = 0;
+            for (size_t i = 1; i < slots.size (); ++i)
+                if (slots[i].last_ts < slots[oldest].last_ts)
+                    oldest = i;
+            slots.erase (slots.begin () + oldest);
+        }
+        const slot x = { next_serial++, h.id, ts, ts, h.palm_position, prototype };
+        slots.push_back (x);
+        return slots.back ();
+    }
+    /// @brief is a better driver than b, given the policy
+    bool better (const hand &a, const slot &sa, const hand &b, const slot &sb) const
+    {
+        switch (policy)
+        {
+            default: assert (0); // logic error
+            case hand_policy::first: return sa.first_ts < sb.first_ts;
+            case hand_policy::right: return a.palm_position.x > b.palm_position.x;
+            case hand_policy::left: return a.palm_position.x < b.palm_position.x;
+        }
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param prototype the state a new hand starts with
+    /// @param linger how long a hand is remembered after it goes out of view, in useconds
+    /// @param policy which hand drives the pointer
+    hand_tracker (const T &prototype, uint64_t linger, hand_policy policy = hand_policy::first)
+        : prototype (prototype)
+        , linger (linger)
+        , policy (policy)
+        , next_serial (1)
+        , driver (0)
+        , changed (false)
+    {
+        slots.reserve (MAX_SLOTS);
+    }
+    /// @brief update the hands in a frame
+    ///
+    /// References returned by get () are invalidated by update ().
+    ///
+    /// @param ts the frame's timestamp
+    /// @param h the frame's hands
+    /// @param n the number of hands
+    ///
+    /// @return the index of the hand that drives the pointer, or -1 if it is out of view
+    int update (uint64_t ts, const hand *h, size_t n)
+    {
+        expire (ts);
+        for (size_t i = 0; i < n; ++i)
+        {
+            slot &s = get_slot (ts, h[i], h, n);
+            s.last_ts = ts;
+            s.palm = h[i].palm_position;
+        }
+        const uint64_t last_driver = driver;
+        const slot *ds = find_serial (driver);
+        int d = -1;
+        if (ds)
+        {
+            // keep the driver, even if it is out of view for now
+            for (size_t i = 0; i < n; ++i)
+                if (h[i].id == ds->id)
+                    d = i;
+        }
+        else
+        {
+            // the driver is gone for good, so pick a new one
+            for (size_t i = 0; i < n; ++i)
+                if (d == -1 || better (h[i], *find (h[i].id), h[d], *find (h[d].id)))
+                    d = i;
+            driver = d == -1 ? 0 : find (h[d].id)->serial;
+        }
+        changed = driver != last_driver;
+        return d;
+    }
+    /// @brief get a hand's state
+    ///
+    /// @param id the hand id, which must have been in a frame passed to update ()
+    T &get (int32_t id)
+    {
+        slot *s = find (id);
+        assert (s);
+        return s->state;
+    }
+    /// @brief the id of the hand that drives the pointer, or -1 if there isn't one
+    int32_t get_driver () const
+    {
+        const slot *s = find_serial (driver);
+        return s ? s->id : -1;
+    }
+    /// @brief true if the last update () changed which hand drives the pointer
+    bool has_changed () const
+    {
+        return changed;
+    }
+    /// @brief number of hands being remembered
+    size_t size () const
+    {
+        return slots.size ();
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+/// @file idle_detector.h
+/// @brief notice when nobody is using the device, so frames can skip the pipeline
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-11
+
+#ifndef IDLE_DETECTOR_H
+#define IDLE_DETECTOR_H
+
+#include "frame_source.h"
+#include <cstdint>
+#include <ctime>
+
+namespace soma
+{
+
+/// @brief get the CPU time used by the calling thread
+///
+/// @return CLOCK_THREAD_CPUTIME_ID in useconds
+uint64_t thread_cpu_now ()
+{
+    timespec t;
+    clock_gettime (CLOCK_THREAD_CPUTIME_ID, &t);
+    return static_cast<uint64_t> (t.tv_sec) * 1000000 + t.tv_nsec / 1000;
+}
+
+/// @brief decide which frames can skip the pipeline
+///
+/// Most frames in a day have no fingers in them, either because there is no hand or because the hand is a fist.
+/// Once there have been no fingers for a while, a frame without fingers can't change anything, so checking for
+/// fingers is all that needs doing.  The first frame with fingers in it goes through the pipeline.
+///
+/// The detector also keeps track of what frames cost while it isn't idle, so it can estimate what skipping them saved.
+class idle_detector
+{
+    private:
+    uint64_t idle_after;
+    bool has_busy;
+    uint64_t busy_ts;
+    bool idle;
+    uint64_t frames;
+    uint64_t idle_frames;
+    uint64_t idle_periods;
+    // processing cost of frames without fingers that weren't skipped
+    uint64_t empty_frames;
+    uint64_t empty_cpu;
+    public:
+    /// @brief constructor
+    ///
+    /// @param idle_after how long there have to be no fingers before frames are skipped, in useconds, 0 never skips
+    idle_detector (uint64_t idle_after)
+        : idle_after (idle_after)
+        , has_busy (false)
+        , busy_ts (0)
+        , idle (false)
+        , frames (0)
+        , idle_frames (0)
+        , idle_periods (0)
+        , empty_frames (0)
+        , empty_cpu (0)
+    {
+    }
+    /// @brief check the next frame
+    ///
+    /// @param f the frame
+    ///
+    /// @return true if the frame can skip the pipeline
+    bool update (const frame &f)
+    {
+        ++frames;
+        // start counting from the first frame, or from where the clock started over
+        if (!has_busy || f.ts < busy_ts)
+        {
+            has_busy = true;
+            busy_ts = f.ts;
+        }
+        if (!f.s.empty () || idle_after == 0)
+        {
+            idle = false;
+            busy_ts = f.ts;
+            return false;
+        }
+        if (!idle && f.ts - busy_ts >= idle_after)
+        {
+            idle = true;
+            ++idle_periods;
+        }
+        idle_frames += idle;
+        return idle;
+    }
+    /// @brief true if frames without fingers are being skipped
+    bool is_idle () const
+    {
+        return idle;
+    }
+    /// @brief say what a frame that went through the pipeline cost
+    ///
+    /// @param f the frame
+    /// @param cpu CPU time in useconds
+    void add_cost (const frame &f, uint64_t cpu)
+    {
+        if (!f.s.empty ())
+            return;
+        ++empty_frames;
+        empty_cpu += cpu;
+    }
+    /// @brief number of frames checked
+    uint64_t get_frames () const
+    {
+        return frames;
+    }
+    /// @brief number of frames skipped
+    uint64_t get_idle_frames () const
+    {
+        return idle_frames;
+    }
+    /// @brief number of times it went idle
+    uint64_t get_idle_periods () const
+    {
+        return idle_periods;
+    }
+    /// @brief mean CPU time of a frame without fingers that went through the pipeline, in useconds
+    double empty_frame_cost () const
+    {
+        return empty_frames ? static_cast<double> (empty_cpu) / empty_frames : 0.0;
+    }
+    /// @brief estimated CPU time that skipping frames saved, in useconds
+    double cpu_saved () const
+    {
+        return idle_frames * empty_frame_cost ();
+    }
+};
+
+/// @brief print idle statistics
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param d the detector
+template<typename S>
+void print_stats (S &s, const idle_detector &d)
+{
+    s << d.get_idle_frames () << " of " << d.get_frames () << " frames skipped while idle ("
+        << (d.get_frames () ? 100.0 * d.get_idle_frames () / d.get_frames () : 0.0) << "%) in "
+        << d.get_idle_periods () << " idle periods, "
+        << d.empty_frame_cost () << "us per frame without fingers, "
+        << d.cpu_saved () / 1000.0 << "ms CPU saved" << std::endl;
+}
+
+}
+
+#endif
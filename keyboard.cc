@@ -4,6 +4,7 @@
 /// @version 1.0
 /// @date 2013-10-01
 
+#include "event_loop.h"
 #include "keyboard.h"
 #include <iostream>
 #include <stdexcept>
@@ -16,14 +17,18 @@ int main ()
 {
     try
     {
+        event_loop loop;
         keyboard k;
-        while (1)
-        {
-            vector<int> s = k.key_states ();
-            for (auto key : s)
-                clog << ' ' << key;
-            clog << endl;
-        }
+        // the key states can only be polled, so poll them on a timer instead of spinning
+        loop.add_timer (chrono::milliseconds (100), [&] ()
+            {
+                vector<int> s = k.key_states ();
+                for (auto key : s)
+                    clog << ' ' << key;
+                clog << endl;
+            });
+        // until CTRL-C
+        loop.run ();
 
         return 0;
     }
@@ -23,8 +23,19 @@ class keyboard
     private:
     FILE *fp;
     public:
-    keyboard (const std::string &fn = std::string ("/dev/input/event4"))
+    /// @brief the device that is opened by default
+    static std::string default_device ()
     {
+        return std::string ("/dev/input/event4");
+    }
+    /// @brief constructor
+    ///
+    /// @param fn input device, or an empty string for a keyboard that never has any keys down
+    keyboard (const std::string &fn = default_device ())
+        : fp (0)
+    {
+        if (fn.empty ())
+            return;
         std::clog << "opening " << fn.c_str () << std::endl;
         fp = fopen (fn.c_str (), "r");
         if (!fp)
@@ -32,8 +43,11 @@ class keyboard
     }
     ~keyboard ()
     {
-        fclose (fp);
+        if (fp)
+            fclose (fp);
     }
+    keyboard (const keyboard &) = delete;
+    keyboard &operator= (const keyboard &) = delete;
     std::vector<int> key_states () const
     {
         const std::vector<int> keys {
@@ -45,6 +59,8 @@ class keyboard
             KEY_RIGHTCTRL
             };
         std::vector<int> states (keys.size ());
+        if (!fp)
+            return states;
         // Create a byte array the size of the number of keys
         std::vector<char> key_map (KEY_MAX/8 + 1);
         // Fill the keymap with the current keyboard state
@@ -0,0 +1,208 @@
+/// @file latency_monitor.h
+/// @brief measure how long it takes a frame to move the mouse
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-09
+
+#ifndef LATENCY_MONITOR_H
+#define LATENCY_MONITOR_H
+
+#include "clock_mapper.h"
+#include "frame_source.h"
+#include "mouse.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief count latencies in equal width buckets
+class latency_histogram
+{
+    private:
+    uint64_t width;
+    /// @brief the last bucket holds everything that doesn't fit in the others
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t sum;
+    uint64_t max;
+    public:
+    /// @brief constructor
+    ///
+    /// @param width bucket width in useconds
+    /// @param buckets number of buckets, not counting the overflow bucket
+    latency_histogram (uint64_t width = 250, size_t buckets = 400)
+        : width (width)
+        , counts (buckets + 1)
+        , total (0)
+        , sum (0)
+        , max (0)
+    {
+        assert (width > 0);
+    }
+    /// @brief add a latency
+    ///
+    /// @param us the latency in useconds
+    void add (uint64_t us)
+    {
+        ++counts[std::min<uint64_t> (us / width, counts.size () - 1)];
+        ++total;
+        sum += us;
+        max = std::max (max, us);
+    }
+    /// @brief number of latencies added
+    uint64_t size () const
+    {
+        return total;
+    }
+    /// @brief mean latency in useconds
+    double mean () const
+    {
+        return total ? static_cast<double> (sum) / total : 0.0;
+    }
+    /// @brief largest latency in useconds
+    uint64_t get_max () const
+    {
+        return max;
+    }
+    /// @brief get a quantile
+    ///
+    /// @param q the quantile, 0.0 to 1.0
+    ///
+    /// @return the upper edge of the bucket that holds the quantile, or the largest latency if it is in the
+    /// overflow bucket, in useconds
+    uint64_t quantile (double q) const
+    {
+        assert (q >= 0.0 && q <= 1.0);
+        if (total == 0)
+            return 0;
+        const uint64_t n = std::max<uint64_t> (1, static_cast<uint64_t> (q * total + 0.5));
+        uint64_t c = 0;
+        for (size_t i = 0; i + 1 < counts.size (); ++i)
+        {
+            c += counts[i];
+            if (c >= n)
+                return std::min ((i + 1) * width, max);
+        }
+        return max;
+    }
+    /// @brief bucket width in useconds
+    uint64_t get_width () const
+    {
+        return width;
+    }
+    /// @brief the counts, bucket i holds latencies from i * width up to (i + 1) * width
+    const std::vector<uint64_t> &get_counts () const
+    {
+        return counts;
+    }
+};
+
+/// @brief print a summary of a histogram, and the buckets that aren't empty
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param h the histogram
+template<typename S>
+void print_stats (S &s, const latency_histogram &h)
+{
+    s << h.size () << " samples, "
+        << h.mean () << "us mean, "
+        << h.quantile (0.5) << "us median, "
+        << h.quantile (0.9) << "us 90%, "
+        << h.quantile (0.99) << "us 99%, "
+        << h.get_max () << "us max" << std::endl;
+    const std::vector<uint64_t> &c = h.get_counts ();
+    for (size_t i = 0; i < c.size (); ++i)
+    {
+        if (c[i] == 0)
+            continue;
+        s << "\t" << i * h.get_width () << "us";
+        if (i + 1 < c.size ())
+            s << "-" << (i + 1) * h.get_width () << "us";
+        else
+            s << "+";
+        s << "\t" << c[i] << std::endl;
+    }
+}
+
+/// @brief time each mouse event from when the frame that caused it was captured
+///
+/// Call begin () before each frame is processed.  The frame's device timestamp is mapped to host time with a
+/// clock_mapper, and when the mouse reports an event, the time since then goes into a histogram.  The time since
+/// the frame arrived goes into another histogram, which is how much of the latency is ours.
+class latency_monitor : public mouse_observer
+{
+    private:
+    clock_mapper cm;
+    latency_histogram capture;
+    latency_histogram processing;
+    uint64_t capture_ts;
+    uint64_t arrival_ts;
+    public:
+    latency_monitor ()
+        : capture_ts (0)
+        , arrival_ts (0)
+    {
+    }
+    /// @brief start processing a frame
+    ///
+    /// @param f the frame, frames without a host timestamp are not timed
+    void begin (const frame &f)
+    {
+        arrival_ts = f.host_ts;
+        capture_ts = 0;
+        if (!f.host_ts)
+            return;
+        cm.add (f.ts, f.host_ts);
+        capture_ts = cm.to_host (f.ts);
+    }
+    /// @brief a mouse event for the current frame reached the X server
+    virtual void on_event (const mouse_event &)
+    {
+        if (!arrival_ts)
+            return;
+        const uint64_t now = host_now ();
+        if (now >= capture_ts)
+            capture.add (now - capture_ts);
+        if (now >= arrival_ts)
+            processing.add (now - arrival_ts);
+    }
+    /// @brief the device clock mapping
+    const clock_mapper &get_clock_mapper () const
+    {
+        return cm;
+    }
+    /// @brief latencies from capture to the mouse event
+    const latency_histogram &get_capture_latency () const
+    {
+        return capture;
+    }
+    /// @brief latencies from arrival to the mouse event
+    const latency_histogram &get_processing_latency () const
+    {
+        return processing;
+    }
+};
+
+/// @brief print latency statistics
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param m the monitor
+template<typename S>
+void print_stats (S &s, const latency_monitor &m)
+{
+    if (m.get_clock_mapper ().is_ready ())
+        s << m.get_clock_mapper ().get_drift () << "ppm device clock drift" << std::endl;
+    s << "capture to mouse latency: ";
+    print_stats (s, m.get_capture_latency ());
+    s << "arrival to mouse latency: ";
+    print_stats (s, m.get_processing_latency ());
+}
+
+}
+
+#endif
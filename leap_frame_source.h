@@ -0,0 +1,94 @@
+/// @file leap_frame_source.h
+/// @brief frames from a Leap controller
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-25
+
+#ifndef LEAP_FRAME_SOURCE_H
+#define LEAP_FRAME_SOURCE_H
+
+#include "frame_source.h"
+#include "Leap.h"
+
+namespace soma
+{
+
+/// @brief a frame source that gets its frames from a Leap controller
+///
+/// The controller never runs out of frames, so it is never done.
+class leap_frame_source : public frame_source, private Leap::Listener
+{
+    private:
+    Leap::Controller c;
+    frame_listener *l;
+    frame f;
+    virtual void onFrame (const Leap::Controller &c)
+    {
+        assert (l);
+        // get the frame
+        f.host_ts = host_now ();
+        const Leap::Frame lf = c.frame ();
+        f.id = lf.id ();
+        f.ts = lf.timestamp ();
+        // get the sample
+        const Leap::PointableList pl = lf.pointables ();
+        f.s = hand_sample (pl);
+        // get the hands
+        const Leap::HandList hl = lf.hands ();
+        f.has_hands = true;
+        f.nhands = 0;
+        for (int i = 0; i < hl.count () && f.nhands < frame::MAX_HANDS; ++i)
+        {
+            hand &h = f.hands[f.nhands++];
+            h = hand ();
+            h.id = hl[i].id ();
+            h.palm_position = hl[i].palmPosition ();
+            h.palm_normal = hl[i].palmNormal ();
+        }
+        // say which hand each finger belongs to, fingers without a hand, or whose hand didn't fit, are left out and
+        // split_hands () gives them a hand of their own
+        for (int i = 0; i < pl.count (); ++i)
+        {
+            const Leap::Hand ph = pl[i].hand ();
+            if (!ph.isValid ())
+                continue;
+            for (size_t j = 0; j < f.s.size (); ++j)
+            {
+                if (f.s[j].id != pl[i].id ())
+                    continue;
+                for (size_t k = 0; k < f.nhands; ++k)
+                    if (f.hands[k].id == ph.id ())
+                        f.hands[k].fingers |= 1 << j;
+                break;
+            }
+        }
+        l->on_frame (f);
+    }
+    public:
+    leap_frame_source ()
+        : l (0)
+    {
+    }
+    ~leap_frame_source ()
+    {
+        stop ();
+    }
+    virtual void start (frame_listener &l)
+    {
+        assert (!this->l);
+        this->l = &l;
+        c.addListener (*this);
+        // receive frames even when you don't have focus
+        c.setPolicyFlags (Leap::Controller::POLICY_BACKGROUND_FRAMES);
+    }
+    virtual void stop ()
+    {
+        if (l)
+            c.removeListener (*this);
+        l = 0;
+    }
+};
+
+}
+
+#endif
@@ -16,11 +16,49 @@
 #error("unknown OS")
 #endif
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <stdexcept>
+#include <vector>
 
 namespace soma
 {
 
+enum class mouse_event_type : uint8_t
+{
+    move,
+    set,
+    button,
+};
+
+/// @brief something the mouse was told to do
+struct mouse_event
+{
+    /// @brief what kind of event
+    mouse_event_type type;
+    /// @brief button number for button events
+    uint8_t button;
+    /// @brief true if the button went down
+    uint8_t down;
+    uint8_t pad;
+    /// @brief relative motion for move events, position for set events
+    int32_t x;
+    int32_t y;
+};
+
+/// @brief gets told about each mouse event, after it has been sent to the X server
+class mouse_observer
+{
+    public:
+    virtual ~mouse_observer () { }
+    virtual void on_event (const mouse_event &e) = 0;
+};
+
+/// @brief move the pointer and press buttons through the X server
+///
+/// A headless mouse has no display.  It only tells its observers about events, so a recording can be replayed
+/// through the pipeline without touching the desktop, and gives the same events every time.
 class mouse
 {
     private:
@@ -28,6 +66,15 @@ class mouse
     Window root;
     int w;
     int h;
+    std::vector<mouse_observer *> observers;
+    void notify (mouse_event_type type, int button, bool down, int x, int y)
+    {
+        if (observers.empty ())
+            return;
+        const mouse_event e = { type, static_cast<uint8_t> (button), down, 0, x, y };
+        for (auto o : observers)
+            o->on_event (e);
+    }
     public:
     mouse ()
         : d (XOpenDisplay (0))
@@ -42,24 +89,70 @@ class mouse
         w = WidthOfScreen (s);
         h = HeightOfScreen (s);
     }
+    /// @brief constructor for a headless mouse
+    ///
+    /// @param w screen width in pixels
+    /// @param h screen height in pixels
+    mouse (int w, int h)
+        : d (0)
+        , root (0)
+        , w (w)
+        , h (h)
+    {
+    }
     ~mouse ()
     {
-        XCloseDisplay (d);
+        if (d)
+            XCloseDisplay (d);
+    }
+    mouse (const mouse &) = delete;
+    mouse &operator= (const mouse &) = delete;
+    /// @brief true if events only go to the observers
+    bool is_headless () const
+    {
+        return !d;
+    }
+    /// @brief add an observer that gets told about each event
+    ///
+    /// @param o the observer
+    void add_observer (mouse_observer *o)
+    {
+        assert (o);
+        observers.push_back (o);
+    }
+    /// @brief remove an observer
+    ///
+    /// @param o the observer
+    void remove_observer (mouse_observer *o)
+    {
+        observers.erase (std::remove (observers.begin (), observers.end (), o), observers.end ());
     }
     void click (int button, Bool down)
     {
-        XTestFakeButtonEvent (d, button, down, CurrentTime);
-        XFlush (d);
+        if (d)
+        {
+            XTestFakeButtonEvent (d, button, down, CurrentTime);
+            XFlush (d);
+        }
+        notify (mouse_event_type::button, button, down, 0, 0);
     }
     void move (int x, int y)
     {
-        XWarpPointer (d, None, None, 0, 0, 0, 0, x, y);
-        XFlush (d);
+        if (d)
+        {
+            XWarpPointer (d, None, None, 0, 0, 0, 0, x, y);
+            XFlush (d);
+        }
+        notify (mouse_event_type::move, 0, false, x, y);
     }
     void set (int x, int y)
     {
-        XWarpPointer (d, None, root, 0, 0, 0, 0, x, y);
-        XFlush (d);
+        if (d)
+        {
+            XWarpPointer (d, None, root, 0, 0, 0, 0, x, y);
+            XFlush (d);
+        }
+        notify (mouse_event_type::set, 0, false, x, y);
     }
     int width () const
     {
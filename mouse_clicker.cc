@@ -4,16 +4,18 @@
 /// @version 1.0
 /// @date 2013-10-17
 
+#include "event_loop.h"
+#include "frame_sources.h"
 #include "mouse.h"
 #include "mouse_clicker.h"
 #include <stdexcept>
 
 using namespace std;
 using namespace soma;
-const string usage = "usage: mouse_clicker";
+const string usage = "usage: mouse_clicker " + frame_source_usage;
 
 /// @brief grab frames and check clicks
-class grabber : public Leap::Listener
+class grabber : public frame_listener
 {
     private:
     mouse m;
@@ -23,15 +25,11 @@ class grabber : public Leap::Listener
         : mc (m)
     {
     }
-    virtual void onFrame (const Leap::Controller& c)
+    virtual void on_frame (const frame &f)
     {
-        // get the frame
-        Leap::Frame f = c.frame ();
-        uint64_t ts = f.timestamp ();
-        // get the sample
-        hand_sample hs (f.pointables ());
+        const uint64_t ts = f.ts;
         // update the clicker
-        mc.update (ts, hs);
+        mc.update (ts, f.s);
         // check states
         if (mc.did_pinch (ts))
             std::clog << "pinched" << std::endl;
@@ -54,20 +52,23 @@ int main (int argc, char **argv)
 {
     try
     {
-        if (argc != 1)
+        if (!valid_frame_source_args (argc - 1, argv + 1))
             throw runtime_error (usage);
 
+        // signals are blocked in every thread started after this
+        event_loop loop;
+
         clog << "Press CTRL-C to exit" << endl;
 
         grabber g;
-        Leap::Controller c (g);
+        unique_ptr<frame_source> src = make_frame_source (argc - 1, argv + 1);
+        loop.quit_when (src->get_done ());
+        src->start (g);
 
-        // receive frames even when you don't have focus
-        c.setPolicyFlags (Leap::Controller::POLICY_BACKGROUND_FRAMES);
+        // sleep until CTRL-C or the source runs out of frames
+        loop.run ();
 
-        // loop
-        while (1)
-            usleep (5000);
+        src->stop ();
 
         return 0;
     }
@@ -7,6 +7,7 @@
 #ifndef MOUSE_CLICKER_H
 #define MOUSE_CLICKER_H
 
+#include "frame_features.h"
 #include "hand_sample.h"
 #include "keyboard.h"
 #include "mouse.h"
@@ -16,6 +17,7 @@
 #include <cassert>
 #include <fstream>
 #include <map>
+#include <string>
 #include <unistd.h>
 #include <utility>
 
@@ -62,6 +64,25 @@ class pinch_detector
         sm.add (state::closed,          event::open,    &pinch_detector::do_nothing,    state::accepted);
     }
     // public functions
+    /// @brief get the current state, for diagnostics
+    int get_state () const
+    {
+        return static_cast<int> (sm.get_state ());
+    }
+    /// @brief get the name of a state returned by get_state ()
+    static std::string state_name (int s)
+    {
+        switch (static_cast<state> (s))
+        {
+            default: return std::string ("invalid");
+            case state::start: return std::string ("start");
+            case state::open_waiting: return std::string ("open_waiting");
+            case state::open: return std::string ("open");
+            case state::zero: return std::string ("zero");
+            case state::closed: return std::string ("closed");
+            case state::accepted: return std::string ("accepted");
+        }
+    }
     bool is_set () const
     {
         return sm.get_state () == state::accepted;
@@ -88,7 +109,7 @@ class pinch_detector
             return true;
         }
     }
-    void update (const uint64_t ts, const hand_sample &s)
+    void update (const uint64_t ts, const frame_features &ff)
     {
         if (timer1.is_set () && !timer1.is_on (ts))
         {
@@ -100,7 +121,7 @@ class pinch_detector
             timer2.reset ();
             sm.record (event::timer2, *this, ts);
         }
-        switch (s.size ())
+        switch (ff.size ())
         {
             default:
             {
@@ -116,7 +137,7 @@ class pinch_detector
             }
             case 2:
             {
-                double d = s[0].position.distanceTo (s[1].position);
+                double d = ff.distance (0, 1);
                 //dd.update (ts, d);
                 if (d > OPEN_MIN)
                 {
@@ -134,6 +155,10 @@ class pinch_detector
             }
         }
     }
+    void update (const uint64_t ts, const hand_sample &s)
+    {
+        update (ts, frame_features (s));
+    }
 };
 
 class mouse_clicker
@@ -145,15 +170,25 @@ class mouse_clicker
     keyboard k;
     mouse &m;
     public:
+    /// @brief constructor
+    ///
+    /// @param m the mouse, if it is headless the keyboard isn't read either
     mouse_clicker (mouse &m)
-        : m (m)
+        : k (m.is_headless () ? std::string () : keyboard::default_device ())
+        , m (m)
+    {
+    }
+    void update (const uint64_t ts, const frame_features &ff)
+    {
+        pd.update (ts, ff);
+    }
+    const pinch_detector &get_pinch_detector () const
     {
+        return pd;
     }
     void update (const uint64_t ts, const hand_sample &s)
     {
-        hand_sample tmp (s);
-        sort (tmp.begin (), tmp.end (), sort_left_to_right);
-        pd.update (ts, tmp);
+        update (ts, frame_features (s));
     }
     bool maybe_pinched (uint64_t ts) const
     {
@@ -221,7 +256,8 @@ class mouse_clicker
         // left click down
         m.click (1, 1);
         // wait to release
-        usleep (10000);
+        if (!m.is_headless ())
+            usleep (10000);
         // left click up
         m.click (1, 0);
     }
@@ -232,7 +268,8 @@ class mouse_clicker
         // right click down
         m.click (3, 1);
         // wait to release
-        usleep (10000);
+        if (!m.is_headless ())
+            usleep (10000);
         // right click up
         m.click (3, 0);
     }
@@ -7,7 +7,13 @@
 #ifndef MOUSE_POINTER_H
 #define MOUSE_POINTER_H
 
+#include "frame_features.h"
+#include "mouse.h"
+#include "point_delta.h"
+#include "sliding_window.h"
+#include "stats.h"
 #include "touch_port.h"
+#include <cassert>
 
 namespace soma
 {
@@ -17,23 +23,70 @@ double mm_to_pixels (const double mm)
     return mm * 3.7795;
 }
 
+/// @brief get the finger that moves the pointer
+///
+/// @param ff the frame, which must have one or two fingers
+///
+/// @return the rightmost finger
+const finger &pointer_finger (const frame_features &ff)
+{
+    assert (ff.size () == 1 || ff.size () == 2);
+    return ff.left_to_right (ff.size () - 1);
+}
+
+/// @brief smooth the pointer position over a sliding window
+class pointer_smoother
+{
+    private:
+    /// @brief x and y
+    multi_sliding_window<double, 2> sw;
+    std::array<running_mean, 2> smooth;
+    public:
+    /// @brief window duration in useconds
+    static const uint64_t DURATION = 100000;
+    pointer_smoother ()
+        : sw (DURATION)
+    {
+    }
+    void clear ()
+    {
+        sw.clear ();
+        smooth[0].reset ();
+        smooth[1].reset ();
+    }
+    /// @brief add a position
+    ///
+    /// @param ts timestamp
+    /// @param x position in mm
+    /// @param y position in mm
+    void update (const uint64_t ts, const double x, const double y)
+    {
+        const std::array<double, 2> p = {{ x, y }};
+        sw.add (ts, p, smooth);
+    }
+    /// @brief smoothed x position
+    double x () const
+    {
+        return smooth[0].get_mean ();
+    }
+    /// @brief smoothed y position
+    double y () const
+    {
+        return smooth[1].get_mean ();
+    }
+};
+
 class mouse_pointer
 {
     private:
-    static const uint64_t SW_DURATION = 100000;
-    sliding_window<double> swx;
-    sliding_window<double> swy;
-    running_mean smooth_x;
-    running_mean smooth_y;
+    pointer_smoother smooth;
     point_delta<vec3> dxy;
     mouse &m;
     touch_port tp;
     double speed;
     public:
     mouse_pointer (mouse &m, double speed)
-        : swx (SW_DURATION)
-        , swy (SW_DURATION)
-        , m (m)
+        : m (m)
         , speed (speed)
     {
         tp.set (vec3 (-200, 300, 0), vec3 (201, 310, 0),
@@ -50,30 +103,19 @@ class mouse_pointer
     }
     void clear ()
     {
-        swx.clear ();
-        swy.clear ();
-        smooth_x.reset ();
-        smooth_y.reset ();
+        smooth.clear ();
     }
-    void update (const uint64_t ts, const hand_sample &s)
+    void update (const uint64_t ts, const frame_features &ff)
     {
-        if (s.size () == 2 || s.size () == 1)
+        if (ff.size () == 2 || ff.size () == 1)
         {
             const double MIND = 40;
             const double MAXD = 100;
-            vec3 p = s[0].position;
-            double d = MIND;
-            if (s.size () == 2)
-            {
-                p = s[1].position;
-                d = s[0].position.distanceTo (s[1].position);
-            }
-            const double x = p.x;
-            const double y = p.y;
-            swx.add (ts, x, smooth_x);
-            swy.add (ts, y, smooth_y);
-            const double sx = smooth_x.get_mean ();
-            const double sy = smooth_y.get_mean ();
+            const vec3 &p = pointer_finger (ff).position;
+            const double d = ff.size () == 2 ? ff.distance (0, 1) : MIND;
+            smooth.update (ts, p.x, p.y);
+            const double sx = smooth.x ();
+            const double sy = smooth.y ();
             // get index pointer
             dxy.update (ts, vec3 (sx, sy, 0));
             const double dx = dxy.current ().x - dxy.last ().x;
@@ -7,6 +7,7 @@
 #ifndef MOUSE_SCROLLER_H
 #define MOUSE_SCROLLER_H
 
+#include "frame_features.h"
 #include "point_delta.h"
 #include "time_guard.h"
 
@@ -51,9 +52,12 @@ class mouse_scroller
         swy.clear ();
         smooth_y.reset ();
     }
-    void update (const uint64_t ts, const vec3 &pos1, const vec3 &pos2)
+    void update (const uint64_t ts, const frame_features &ff)
     {
-        double d = pos1.distanceTo (pos2);
+        assert (ff.size () >= 2);
+        // thumb on left
+        const vec3 &pos1 = ff.left_to_right (0).position;
+        double d = ff.distance (finger_order::left_to_right, 0, 1);
         // if the distance is too great, ignore it
         if (d > min_distance)
             return;
@@ -0,0 +1,102 @@
+/// @file notifier.h
+/// @brief wake a sleeping thread
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-05
+
+#ifndef NOTIFIER_H
+#define NOTIFIER_H
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace soma
+{
+
+/// @brief wake a thread that is waiting, from any thread
+///
+/// Notifications are counted by an eventfd, so a notification that arrives before the waiter gets to wait () is not
+/// lost.
+class notifier
+{
+    private:
+    int fd;
+    public:
+    notifier ()
+        : fd (eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK))
+    {
+        if (fd == -1)
+            throw std::runtime_error ("could not create eventfd");
+    }
+    ~notifier ()
+    {
+        close (fd);
+    }
+    notifier (const notifier &) = delete;
+    notifier &operator= (const notifier &) = delete;
+    /// @brief the file descriptor, readable when there are notifications
+    int get_fd () const
+    {
+        return fd;
+    }
+    /// @brief wake the waiter
+    void notify ()
+    {
+        const uint64_t one = 1;
+        // this can only fail if the count overflows, in which case the waiter will wake anyway
+        ssize_t n = write (fd, &one, sizeof (one));
+        (void) n;
+    }
+    /// @brief clear the notifications
+    ///
+    /// @return true if there were any
+    bool clear ()
+    {
+        uint64_t n;
+        return read (fd, &n, sizeof (n)) == sizeof (n);
+    }
+    /// @brief wait for a notification and clear it
+    ///
+    /// @param timeout_ms how long to wait in milliseconds, -1 waits forever
+    ///
+    /// @return false if it timed out
+    bool wait (int timeout_ms = -1)
+    {
+        pollfd p = { fd, POLLIN, 0 };
+        while (poll (&p, 1, timeout_ms) == -1)
+            if (errno != EINTR)
+                throw std::runtime_error ("could not wait for notification");
+        return clear ();
+    }
+    /// @brief wait for a notification until a deadline and clear it
+    ///
+    /// @param deadline when to give up
+    ///
+    /// @return false if it timed out
+    bool wait_until (std::chrono::steady_clock::time_point deadline)
+    {
+        pollfd p = { fd, POLLIN, 0 };
+        while (true)
+        {
+            const auto left = deadline - std::chrono::steady_clock::now ();
+            const int64_t ns = std::max (std::chrono::duration_cast<std::chrono::nanoseconds> (left).count (), int64_t (0));
+            const timespec t = { static_cast<time_t> (ns / 1000000000), static_cast<long> (ns % 1000000000) };
+            const int n = ppoll (&p, 1, &t, 0);
+            if (n != -1)
+                return n > 0 && clear ();
+            if (errno != EINTR)
+                throw std::runtime_error ("could not wait for notification");
+        }
+    }
+};
+
+}
+
+#endif
@@ -57,6 +57,22 @@ class options
     option<bool> sound;
     /// @brief change the speed of the mouse
     option<double> mouse_speed;
+    /// @brief seconds the flight recorder keeps, 0 turns it off
+    option<double> flight_seconds;
+    /// @brief when the flight recorder dumps on its own: none or click
+    option<std::string> flight_trigger;
+    /// @brief record every frame and mouse event while running
+    option<bool> record;
+    /// @brief start a new recording file after this many megabytes
+    option<double> record_mb;
+    /// @brief start a new recording file after this many minutes
+    option<double> record_minutes;
+    /// @brief which hand drives the pointer when there are two: first, right or left
+    option<std::string> pointer_hand;
+    /// @brief gaps of up to this many dropped frames are filled in, 0, the default, turns it off
+    option<int> fill_gaps;
+    /// @brief seconds without fingers before frames stop going through the pipeline, 0 turns it off
+    option<double> idle_seconds;
     public:
     /// @brief constructor
     options ()
@@ -64,6 +80,14 @@ class options
         , minor_revision (MINOR_REVISION, "minor_revision")
         , sound (false, "sound")
         , mouse_speed (1.5f, "mouse_speed")
+        , flight_seconds (10.0, "flight_seconds")
+        , flight_trigger ("none", "flight_trigger")
+        , record (false, "record")
+        , record_mb (256, "record_mb")
+        , record_minutes (60, "record_minutes")
+        , pointer_hand ("first", "pointer_hand")
+        , fill_gaps (0, "fill_gaps")
+        , idle_seconds (1.0, "idle_seconds")
     {
     }
     /// @brief option access
@@ -100,6 +124,71 @@ class options
             return;
         mouse_speed.value = s;
     }
+    /// @brief option access
+    double get_flight_seconds () const
+    {
+        return flight_seconds.value;
+    }
+    /// @brief option access
+    void set_flight_seconds (double s)
+    {
+        flight_seconds.value = s;
+    }
+    /// @brief option access
+    const std::string &get_flight_trigger () const
+    {
+        return flight_trigger.value;
+    }
+    /// @brief option access
+    bool get_record () const
+    {
+        return record.value;
+    }
+    /// @brief option access
+    void set_record (bool f)
+    {
+        record.value = f;
+    }
+    /// @brief option access
+    double get_record_mb () const
+    {
+        return record_mb.value;
+    }
+    /// @brief option access
+    double get_record_minutes () const
+    {
+        return record_minutes.value;
+    }
+    /// @brief option access
+    const std::string &get_pointer_hand () const
+    {
+        return pointer_hand.value;
+    }
+    /// @brief option access
+    void set_pointer_hand (const std::string &h)
+    {
+        pointer_hand.value = h;
+    }
+    /// @brief option access
+    int get_fill_gaps () const
+    {
+        return fill_gaps.value;
+    }
+    /// @brief option access
+    void set_fill_gaps (int n)
+    {
+        fill_gaps.value = n;
+    }
+    /// @brief option access
+    double get_idle_seconds () const
+    {
+        return idle_seconds.value;
+    }
+    /// @brief option access
+    void set_idle_seconds (double s)
+    {
+        idle_seconds.value = s;
+    }
     /// @brief i/o helper
     friend std::ostream& operator<< (std::ostream &s, const options &opts)
     {
@@ -107,6 +196,14 @@ class options
         s << opts.minor_revision.name << " " << opts.minor_revision.value << std::endl;
         s << opts.sound.name << " " << opts.sound.value << std::endl;
         s << opts.mouse_speed.name << " " << opts.mouse_speed.value << std::endl;
+        s << opts.flight_seconds.name << " " << opts.flight_seconds.value << std::endl;
+        s << opts.flight_trigger.name << " " << opts.flight_trigger.value << std::endl;
+        s << opts.record.name << " " << opts.record.value << std::endl;
+        s << opts.record_mb.name << " " << opts.record_mb.value << std::endl;
+        s << opts.record_minutes.name << " " << opts.record_minutes.value << std::endl;
+        s << opts.pointer_hand.name << " " << opts.pointer_hand.value << std::endl;
+        s << opts.fill_gaps.name << " " << opts.fill_gaps.value << std::endl;
+        s << opts.idle_seconds.name << " " << opts.idle_seconds.value << std::endl;
         return s;
     }
     /// @brief i/o helper
@@ -123,6 +220,24 @@ class options
                 throw std::runtime_error ("warning: configuration file revision number is newer than this program's revision number");
             opts.sound.parse (s);
             opts.mouse_speed.parse (s);
+            // older files don't have these, so they keep their defaults
+            if (opts.minor_revision.value >= 2)
+            {
+                opts.flight_seconds.parse (s);
+                opts.flight_trigger.parse (s);
+            }
+            if (opts.minor_revision.value >= 3)
+            {
+                opts.record.parse (s);
+                opts.record_mb.parse (s);
+                opts.record_minutes.parse (s);
+            }
+            if (opts.minor_revision.value >= 4)
+                opts.pointer_hand.parse (s);
+            if (opts.minor_revision.value >= 5)
+                opts.fill_gaps.parse (s);
+            if (opts.minor_revision.value >= 6)
+                opts.idle_seconds.parse (s);
         }
         catch (const std::exception &e)
         {
@@ -0,0 +1,548 @@
+/// @file recording.h
+/// @brief binary frame recording format
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-24
+
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include "frame_source.h"
+#include "hand_sample.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace soma
+{
+
+/// @brief recording file header
+///
+/// A recording is a header followed by frames and then an index.  Each frame is a frame_record followed by
+/// frame_record::nfingers finger structs and then frame_record::nhands hand structs, written exactly as they are laid
+/// out in memory, so a recording can be mapped and its fingers used in place.  The index is written when the
+/// recording is closed, so a recording that was not closed has no index.
+struct recording_header
+{
+    /// @brief identifies the file type
+    char magic[8];
+    /// @brief format version
+    uint32_t version;
+    /// @brief sizeof (finger) of the program that wrote the file
+    uint32_t finger_size;
+    /// @brief total frames, filled in when the recording is closed
+    uint64_t frames;
+    /// @brief file offset of the index, filled in when the recording is closed, zero if there is no index
+    uint64_t index;
+};
+
+/// @brief frame header
+struct frame_record
+{
+    /// @brief frame id
+    int64_t id;
+    /// @brief frame timestamp in useconds
+    uint64_t ts;
+    /// @brief number of finger structs that follow
+    uint32_t nfingers;
+    /// @brief number of hand structs that follow the fingers
+    uint16_t nhands;
+    /// @brief FRAME_HAS_HANDS if the fingers were grouped by hand
+    uint16_t flags;
+};
+
+/// @brief frame_record flag, set if the fingers were grouped by hand
+static const uint16_t FRAME_HAS_HANDS = 1;
+
+/// @brief index header, followed by recording_index::entries index entries
+struct recording_index
+{
+    /// @brief identifies the index
+    char magic[8];
+    /// @brief number of entries
+    uint64_t entries;
+};
+
+/// @brief an index entry, where to find a frame
+struct recording_index_entry
+{
+    /// @brief frame number, counting from zero
+    uint64_t frame;
+    /// @brief frame timestamp in useconds
+    uint64_t ts;
+    /// @brief file offset of the frame_record
+    uint64_t offset;
+};
+
+static const char RECORDING_MAGIC[8] = { 'S', 'O', 'M', 'A', 'R', 'E', 'C', 0 };
+static const char RECORDING_INDEX_MAGIC[8] = { 'S', 'O', 'M', 'A', 'I', 'D', 'X', 0 };
+/// @brief version 1 recordings have no index, and versions 1 and 2 have no hands
+static const uint32_t RECORDING_VERSION = 3;
+/// @brief frames between index entries
+static const uint64_t RECORDING_INDEX_INTERVAL = 1024;
+
+// the frame and finger records must stay 8 byte aligned when packed back to back
+static_assert (sizeof (recording_header) == 32, "unexpected recording_header size");
+static_assert (sizeof (frame_record) == 24, "unexpected frame_record size");
+static_assert (sizeof (recording_index) == 16, "unexpected recording_index size");
+static_assert (sizeof (recording_index_entry) == 24, "unexpected recording_index_entry size");
+static_assert (sizeof (finger) % 8 == 0, "finger records must keep frames aligned");
+static_assert (sizeof (hand) % 8 == 0, "hand records must keep frames aligned");
+
+/// @brief write frames to a recording file
+class recording_writer
+{
+    private:
+    /// @brief buffer size, large enough to avoid a write per frame
+    static const size_t BUFFER_SIZE = 1 << 20;
+    FILE *fp;
+    uint64_t frames;
+    uint64_t offset;
+    uint64_t index_offset;
+    std::vector<recording_index_entry> index;
+    std::vector<char> buffer;
+    bool write_header ()
+    {
+        recording_header h;
+        memset (&h, 0, sizeof (h));
+        memcpy (h.magic, RECORDING_MAGIC, sizeof (h.magic));
+        h.version = RECORDING_VERSION;
+        h.finger_size = sizeof (finger);
+        h.frames = frames;
+        h.index = index_offset;
+        return fwrite (&h, sizeof (h), 1, fp) == 1;
+    }
+    bool write_index ()
+    {
+        recording_index x;
+        memcpy (x.magic, RECORDING_INDEX_MAGIC, sizeof (x.magic));
+        x.entries = index.size ();
+        if (fwrite (&x, sizeof (x), 1, fp) != 1
+            || fwrite (index.data (), sizeof (recording_index_entry), index.size (), fp) != index.size ())
+            return false;
+        index_offset = offset;
+        return true;
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param fn recording filename
+    recording_writer (const std::string &fn)
+        : fp (fopen (fn.c_str (), "wb"))
+        , frames (0)
+        , offset (sizeof (recording_header))
+        , index_offset (0)
+        , buffer (BUFFER_SIZE)
+    {
+        if (!fp)
+            throw std::runtime_error ("could not open recording for writing");
+        setvbuf (fp, &buffer[0], _IOFBF, buffer.size ());
+        if (!write_header ())
+        {
+            fclose (fp);
+            throw std::runtime_error ("could not write recording header");
+        }
+    }
+    /// @brief destructor
+    ~recording_writer ()
+    {
+        if (fp)
+        {
+            try { close (); }
+            catch (...) { }
+        }
+    }
+    /// @brief get number of frames written
+    ///
+    /// @return the number of frames
+    uint64_t get_frames () const
+    {
+        return frames;
+    }
+    /// @brief get number of bytes written, not counting the index
+    uint64_t get_bytes () const
+    {
+        return offset;
+    }
+    /// @brief write buffered frames to the file
+    void flush ()
+    {
+        assert (fp);
+        if (fflush (fp) != 0)
+            throw std::runtime_error ("could not flush recording");
+    }
+    /// @brief write a frame
+    ///
+    /// @param id frame id
+    /// @param ts frame timestamp
+    /// @param s the frame's sample
+    /// @param has_hands true if the fingers were grouped by hand
+    /// @param h the hands
+    /// @param nhands number of hands
+    void write (int64_t id, uint64_t ts, const hand_sample &s,
+        bool has_hands = false, const hand *h = 0, size_t nhands = 0)
+    {
+        assert (fp);
+        assert (nhands == 0 || h);
+        frame_record r;
+        r.id = id;
+        r.ts = ts;
+        r.nfingers = s.size ();
+        r.nhands = nhands;
+        r.flags = has_hands ? FRAME_HAS_HANDS : 0;
+        if (fwrite (&r, sizeof (r), 1, fp) != 1
+            || fwrite (s.data (), sizeof (finger), s.size (), fp) != s.size ()
+            || (nhands && fwrite (h, sizeof (hand), nhands, fp) != nhands))
+            throw std::runtime_error ("could not write frame to recording");
+        if (frames % RECORDING_INDEX_INTERVAL == 0)
+        {
+            const recording_index_entry e = { frames, ts, offset };
+            index.push_back (e);
+        }
+        offset += sizeof (r) + s.size () * sizeof (finger) + nhands * sizeof (hand);
+        ++frames;
+    }
+    /// @brief write a frame and its hands
+    ///
+    /// @param f the frame
+    void write (const frame &f)
+    {
+        write (f.id, f.ts, f.s, f.has_hands, f.hands, f.nhands);
+    }
+    /// @brief write the index, fill in the header and close the file
+    void close ()
+    {
+        assert (fp);
+        // rewrite the header now that we know how many frames there are and where the index is
+        bool ok = write_index ()
+            && (fflush (fp) == 0)
+            && (fseek (fp, 0, SEEK_SET) == 0)
+            && write_header ();
+        ok = (fclose (fp) == 0) && ok;
+        fp = 0;
+        if (!ok)
+            throw std::runtime_error ("could not close recording");
+    }
+};
+
+/// @brief a frame as it is stored in a mapped recording
+class recorded_frame
+{
+    private:
+    const frame_record *r;
+    public:
+    /// @brief constructor
+    ///
+    /// @param r pointer to the record
+    explicit recorded_frame (const frame_record *r)
+        : r (r)
+    {
+    }
+    /// @brief frame id
+    int64_t id () const
+    {
+        return r->id;
+    }
+    /// @brief frame timestamp in useconds
+    uint64_t timestamp () const
+    {
+        return r->ts;
+    }
+    /// @brief number of fingers
+    size_t size () const
+    {
+        return r->nfingers;
+    }
+    /// @brief the fingers, left to right
+    const finger *begin () const
+    {
+        return reinterpret_cast<const finger *> (r + 1);
+    }
+    /// @brief the fingers, left to right
+    const finger *end () const
+    {
+        return begin () + size ();
+    }
+    /// @brief true if the fingers were grouped by hand
+    bool has_hands () const
+    {
+        return r->flags & FRAME_HAS_HANDS;
+    }
+    /// @brief number of hands
+    size_t hands () const
+    {
+        return r->nhands;
+    }
+    /// @brief the hands
+    const hand *hands_begin () const
+    {
+        return reinterpret_cast<const hand *> (end ());
+    }
+    /// @brief the hands
+    const hand *hands_end () const
+    {
+        return hands_begin () + hands ();
+    }
+    /// @brief size of the record in bytes, including the fingers and hands
+    size_t bytes () const
+    {
+        return sizeof (frame_record) + size () * sizeof (finger) + hands () * sizeof (hand);
+    }
+    /// @brief copy the frame
+    ///
+    /// Fingers past hand_sample::MAX_FINGERS and hands past frame::MAX_HANDS are dropped.
+    ///
+    /// @param f the frame
+    void get (frame &f) const
+    {
+        const size_t max_fingers = hand_sample::MAX_FINGERS;
+        const size_t max_hands = frame::MAX_HANDS;
+        f.id = id ();
+        f.ts = timestamp ();
+        f.host_ts = 0;
+        f.s.assign (begin (), begin () + std::min (size (), max_fingers));
+        f.has_hands = has_hands ();
+        f.nhands = std::min (hands (), max_hands);
+        std::copy (hands_begin (), hands_begin () + f.nhands, f.hands);
+    }
+};
+
+/// @brief read frames from a memory mapped recording file
+class recording_reader
+{
+    private:
+    int fd;
+    const char *base;
+    size_t length;
+    /// @brief one past the last frame byte
+    size_t last;
+    /// @brief built by scanning the frames when the file has no index
+    mutable std::vector<recording_index_entry> index_entries;
+    /// @brief set if the file's index is valid
+    bool has_index;
+    const recording_index *stored_index () const
+    {
+        return reinterpret_cast<const recording_index *> (base + last);
+    }
+    public:
+    /// @brief iterate over the frames in the recording
+    class const_iterator
+    {
+        private:
+        const char *p;
+        const char *last;
+        // stop at the end of the file or at a partially written frame, or past the end if we were sent there
+        void check ()
+        {
+            if (p > last)
+            {
+                p = last;
+                return;
+            }
+            const size_t remaining = last - p;
+            if (remaining < sizeof (frame_record)
+                || remaining < recorded_frame (reinterpret_cast<const frame_record *> (p)).bytes ())
+                p = last;
+        }
+        public:
+        const_iterator (const char *p, const char *last)
+            : p (p)
+            , last (last)
+        {
+            check ();
+        }
+        recorded_frame operator* () const
+        {
+            return recorded_frame (reinterpret_cast<const frame_record *> (p));
+        }
+        const_iterator &operator++ ()
+        {
+            p += (**this).bytes ();
+            check ();
+            return *this;
+        }
+        bool operator== (const const_iterator &i) const
+        {
+            return p == i.p;
+        }
+        bool operator!= (const const_iterator &i) const
+        {
+            return p != i.p;
+        }
+    };
+    /// @brief constructor
+    ///
+    /// @param fn recording filename
+    recording_reader (const std::string &fn)
+        : fd (open (fn.c_str (), O_RDONLY))
+        , base (0)
+        , length (0)
+        , last (0)
+        , has_index (false)
+    {
+        if (fd == -1)
+            throw std::runtime_error ("could not open recording for reading");
+        struct stat sb;
+        if (fstat (fd, &sb) == -1 || static_cast<size_t> (sb.st_size) < sizeof (recording_header))
+        {
+            ::close (fd);
+            throw std::runtime_error ("recording is too short");
+        }
+        length = sb.st_size;
+        void *p = mmap (0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            ::close (fd);
+            throw std::runtime_error ("could not map recording");
+        }
+        base = static_cast<const char *> (p);
+        // we are usually going to read it front to back
+        madvise (p, length, MADV_SEQUENTIAL);
+        const recording_header &h = header ();
+        if (memcmp (h.magic, RECORDING_MAGIC, sizeof (h.magic)) != 0
+            || h.version < 1 || h.version > RECORDING_VERSION
+            || h.finger_size != sizeof (finger))
+        {
+            munmap (p, length);
+            ::close (fd);
+            throw std::runtime_error ("unrecognized recording format");
+        }
+        // the frames stop where the index starts
+        last = length;
+        if (h.version >= 2
+            && h.index >= sizeof (recording_header)
+            && h.index <= length - sizeof (recording_index))
+        {
+            // if the index is damaged the frames still stop there, but it will be rebuilt
+            last = h.index;
+            const recording_index &x = *stored_index ();
+            has_index = memcmp (x.magic, RECORDING_INDEX_MAGIC, sizeof (x.magic)) == 0
+                && x.entries <= (length - last - sizeof (recording_index)) / sizeof (recording_index_entry);
+            // the entries have to point at the frames, in order
+            const recording_index_entry *e = reinterpret_cast<const recording_index_entry *> (stored_index () + 1);
+            for (uint64_t i = 0; has_index && i < x.entries; ++i)
+                has_index = e[i].offset >= sizeof (recording_header)
+                    && e[i].offset < last
+                    && (i == 0 || (e[i].frame > e[i - 1].frame
+                        && e[i].ts >= e[i - 1].ts
+                        && e[i].offset > e[i - 1].offset));
+        }
+    }
+    /// @brief destructor
+    ~recording_reader ()
+    {
+        munmap (const_cast<char *> (base), length);
+        ::close (fd);
+    }
+    recording_reader (const recording_reader &) = delete;
+    recording_reader &operator= (const recording_reader &) = delete;
+    /// @brief the file header
+    const recording_header &header () const
+    {
+        return *reinterpret_cast<const recording_header *> (base);
+    }
+    /// @brief first frame
+    const_iterator begin () const
+    {
+        return const_iterator (base + sizeof (recording_header), base + last);
+    }
+    /// @brief one past the last frame
+    const_iterator end () const
+    {
+        return const_iterator (base + last, base + last);
+    }
+    /// @brief get the index entries
+    ///
+    /// If the recording was not closed, or was written before recordings had an index, the index is built by
+    /// scanning the frame headers the first time it is needed.
+    ///
+    /// @return pointer to the first entry, the entries are in frame order
+    const recording_index_entry *index_begin () const
+    {
+        if (has_index)
+            return reinterpret_cast<const recording_index_entry *> (stored_index () + 1);
+        if (index_entries.empty ())
+        {
+            uint64_t n = 0;
+            for (auto i = begin (); i != end (); ++i, ++n)
+            {
+                if (n % RECORDING_INDEX_INTERVAL != 0)
+                    continue;
+                const recording_index_entry e = { n, (*i).timestamp (), offset (i) };
+                index_entries.push_back (e);
+            }
+        }
+        return index_entries.data ();
+    }
+    /// @brief one past the last index entry
+    const recording_index_entry *index_end () const
+    {
+        return index_begin () + (has_index ? stored_index ()->entries : index_entries.size ());
+    }
+    /// @brief get the file offset of a frame
+    uint64_t offset (const const_iterator &i) const
+    {
+        return reinterpret_cast<const char *> ((*i).begin ()) - sizeof (frame_record) - base;
+    }
+    /// @brief find the first frame at or after a time
+    ///
+    /// Timestamps must increase through the recording, as they do for frames from the controller.
+    ///
+    /// @param ts timestamp in useconds
+    ///
+    /// @return the frame, or end () if every frame is earlier
+    const_iterator seek (uint64_t ts) const
+    {
+        // start from the last indexed frame before ts
+        const recording_index_entry *e = std::upper_bound (index_begin (), index_end (), ts,
+            [] (uint64_t t, const recording_index_entry &x) { return t <= x.ts; });
+        const_iterator i = e == index_begin () ? begin () : const_iterator (base + (e - 1)->offset, base + last);
+        while (i != end () && (*i).timestamp () < ts)
+            ++i;
+        return i;
+    }
+    /// @brief find a frame by number
+    ///
+    /// @param n frame number, counting from zero
+    ///
+    /// @return the frame, or end () if there are not that many frames
+    const_iterator seek_frame (uint64_t n) const
+    {
+        const recording_index_entry *e = std::upper_bound (index_begin (), index_end (), n,
+            [] (uint64_t f, const recording_index_entry &x) { return f < x.frame; });
+        const_iterator i = begin ();
+        uint64_t j = 0;
+        if (e != index_begin ())
+        {
+            i = const_iterator (base + (e - 1)->offset, base + last);
+            j = (e - 1)->frame;
+        }
+        for (; i != end () && j < n; ++j)
+            ++i;
+        return i;
+    }
+    /// @brief find where to start replaying so that windowed stages have warmed up by a given time
+    ///
+    /// A stage whose state only depends on the frames in a window that is at most warm_up useconds long will be in
+    /// the same state at ts after replaying from here as it would be after replaying the whole recording.
+    ///
+    /// @param ts timestamp in useconds
+    /// @param warm_up longest window duration in useconds
+    ///
+    /// @return the first frame to replay
+    const_iterator warm_up (uint64_t ts, uint64_t warm_up) const
+    {
+        return seek (ts > warm_up ? ts - warm_up : 0);
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,113 @@
+/// @file recording_codec.cc
+/// @brief compress and decompress recordings
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-01
+
+#include "recording.h"
+#include "recording_codec.h"
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: recording_codec compress recording compressed [position_step [velocity_step [direction_step]]]\n"
+    "       recording_codec decompress compressed recording\n"
+    "       recording_codec bench compressed";
+
+void compress (int argc, char **argv)
+{
+    if (argc < 4 || argc > 7)
+        throw runtime_error (usage);
+    codec_parameters p;
+    if (argc > 4)
+        p.position_step = atof (argv[4]);
+    if (argc > 5)
+        p.velocity_step = atof (argv[5]);
+    if (argc > 6)
+        p.direction_step = atof (argv[6]);
+    if (p.position_step <= 0 || p.velocity_step <= 0 || p.direction_step <= 0)
+        throw runtime_error ("quantization steps must be positive");
+    recording_reader r (argv[2]);
+    compressed_writer w (argv[3], p);
+    frame f;
+    uint64_t raw = sizeof (recording_header);
+    for (auto i : r)
+    {
+        i.get (f);
+        w.write (f);
+        raw += i.bytes ();
+    }
+    w.close ();
+    clog << w.get_frames () << " frames" << endl;
+    clog << raw << " raw bytes" << endl;
+    clog << w.get_bytes () << " compressed bytes" << endl;
+    if (w.get_bytes ())
+        clog << static_cast<double> (raw) / w.get_bytes () << " compression ratio" << endl;
+}
+
+void decompress (int argc, char **argv)
+{
+    if (argc != 4)
+        throw runtime_error (usage);
+    compressed_reader r (argv[2]);
+    recording_writer w (argv[3]);
+    vector<frame> frames;
+    for (size_t b = 0; b < r.size (); ++b)
+    {
+        frames.resize (r.block_frames (b));
+        r.decode (b, &frames[0]);
+        for (const auto &f : frames)
+            w.write (f);
+    }
+    w.close ();
+    clog << w.get_frames () << " frames" << endl;
+}
+
+void bench (int argc, char **argv)
+{
+    if (argc != 3)
+        throw runtime_error (usage);
+    compressed_reader r (argv[2]);
+    clog << r.frames () << " frames in " << r.size () << " blocks" << endl;
+    vector<frame> frames (r.frames ());
+    if (frames.empty ())
+        return;
+    // one core
+    auto start = chrono::steady_clock::now ();
+    for (size_t b = 0; b < r.size (); ++b)
+        r.decode (b, &frames[r.first_frame (b)]);
+    double secs = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+    clog << "serial" << '\t' << frames.size () / secs << " frames/sec" << endl;
+    // all cores
+    start = chrono::steady_clock::now ();
+    r.decode (&frames[0]);
+    secs = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+    clog << "parallel" << '\t' << frames.size () / secs << " frames/sec" << endl;
+}
+
+int main (int argc, char **argv)
+{
+    try
+    {
+        if (argc < 2)
+            throw runtime_error (usage);
+
+        const string cmd (argv[1]);
+        if (cmd == "compress")
+            compress (argc, argv);
+        else if (cmd == "decompress")
+            decompress (argc, argv);
+        else if (cmd == "bench")
+            bench (argc, argv);
+        else
+            throw runtime_error (usage);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
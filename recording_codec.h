@@ -0,0 +1,777 @@
+/// @file recording_codec.h
+/// @brief compressed recording format for long term captures
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-01
+
+#ifndef RECORDING_CODEC_H
+#define RECORDING_CODEC_H
+
+#include "frame_source.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief zigzag encode a signed integer so that small magnitudes become small unsigned integers
+inline uint64_t zigzag (int64_t x)
+{
+    return (static_cast<uint64_t> (x) << 1) ^ static_cast<uint64_t> (x >> 63);
+}
+
+/// @brief undo zigzag ()
+inline int64_t unzigzag (uint64_t x)
+{
+    return static_cast<int64_t> (x >> 1) ^ -static_cast<int64_t> (x & 1);
+}
+
+/// @brief append a varint
+///
+/// @param x the value
+/// @param p where to write, must have room for 10 bytes
+///
+/// @return one past the last byte written
+inline uint8_t *put_varint (uint64_t x, uint8_t *p)
+{
+    while (x >= 0x80)
+    {
+        *p++ = static_cast<uint8_t> (x) | 0x80;
+        x >>= 7;
+    }
+    *p++ = static_cast<uint8_t> (x);
+    return p;
+}
+
+/// @brief read a varint
+///
+/// @param p where to read
+/// @param end one past the last byte that can be read
+/// @param x the value
+///
+/// @return one past the last byte read
+inline const uint8_t *get_varint (const uint8_t *p, const uint8_t *end, uint64_t &x)
+{
+    if (p >= end)
+        throw std::runtime_error ("corrupt compressed block");
+    // most values fit in one byte
+    if (*p < 0x80)
+    {
+        x = *p;
+        return p + 1;
+    }
+    x = 0;
+    // a 64 bit value takes at most 10 bytes
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        if (p >= end)
+            throw std::runtime_error ("corrupt compressed block");
+        const uint8_t b = *p++;
+        x |= static_cast<uint64_t> (b & 0x7f) << shift;
+        if (b < 0x80)
+            return p;
+    }
+    throw std::runtime_error ("corrupt compressed block");
+}
+
+/// @brief compression parameters
+struct codec_parameters
+{
+    /// @brief position quantization step in mm
+    float position_step;
+    /// @brief velocity quantization step in mm/sec
+    float velocity_step;
+    /// @brief direction quantization step, directions are unit vectors
+    float direction_step;
+    /// @brief frames per block, blocks can be decoded independently
+    uint32_t block_frames;
+    codec_parameters ()
+        : position_step (0.05f)
+        , velocity_step (1.0f)
+        , direction_step (0.002f)
+        , block_frames (4096)
+    {
+    }
+};
+
+/// @brief compressed recording file header
+struct codec_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t block_frames;
+    float position_step;
+    float velocity_step;
+    float direction_step;
+    uint32_t reserved;
+    /// @brief total frames, filled in when the file is closed
+    uint64_t frames;
+};
+
+/// @brief compressed block header
+///
+/// Each block starts from scratch, so blocks can be decoded in any order and on any thread.
+struct codec_block
+{
+    /// @brief number of frames in the block
+    uint32_t frames;
+    /// @brief number of bytes of encoded frames that follow
+    uint32_t bytes;
+};
+
+static const char CODEC_MAGIC[8] = { 'S', 'O', 'M', 'A', 'Z', 'I', 'P', 0 };
+/// @brief version 1 files have no hands
+static const uint32_t CODEC_VERSION = 2;
+
+static_assert (sizeof (codec_header) == 40, "unexpected codec_header size");
+static_assert (sizeof (codec_block) == 8, "unexpected codec_block size");
+
+/// @brief delta coding state, the last frame's quantized fingers and hands
+///
+/// A frame is coded as deltas from the previous frame.  Each finger is coded as the difference between it and the
+/// previous frame's finger with the same id, or from zero if there isn't one, and hands are coded the same way.
+///
+/// Frame layout:
+///
+///     varint  zigzag (id - last id - 1)
+///     varint  zigzag (timestamp delta - last timestamp delta)
+///     varint  number of fingers
+///     fingers
+///     varint  number of hands + 1, or 0 if the fingers are not grouped by hand, only in version 2 and later
+///     hands
+///
+/// Finger layout:
+///
+///     byte    tag, two bits for each of the position, velocity and direction groups giving the width of its
+///             deltas, and a bit that is set when the id differs from the id at the same place in the last frame
+///     varint  zigzag (id - last id at this place), only when the tag bit is set
+///     groups  the zigzagged deltas for each group of three values, packed according to the group's width
+///
+/// A group whose deltas are all zero takes no bytes, which is common for directions, and noisy positions usually take
+/// one or two bytes, so a finger is typically a handful of bytes instead of 40.
+///
+/// Hand layout:
+///
+///     byte    tag, like a finger's but with groups for the palm position and palm normal
+///     varint  zigzag (id - last id at this place), only when the tag bit is set
+///     varint  which fingers belong to the hand
+///     groups  the zigzagged deltas for each group
+class codec_state
+{
+    public:
+    /// @brief number of quantized values per finger
+    static const size_t VALUES = 9;
+    /// @brief number of quantized values per hand
+    static const size_t HAND_VALUES = 6;
+    private:
+    static const size_t MAXF = hand_sample::MAX_FINGERS;
+    static const size_t MAXH = frame::MAX_HANDS;
+    static const size_t GROUPS = VALUES / 3;
+    static const uint8_t ID_CHANGED = 0x40;
+    /// @brief group widths
+    enum { ZERO, NIBBLES, BYTES, VARINTS };
+    const uint32_t version;
+    float steps[VALUES];
+    float inverse_steps[VALUES];
+    float hand_steps[HAND_VALUES];
+    float inverse_hand_steps[HAND_VALUES];
+    size_t n;
+    int32_t ids[MAXF];
+    int32_t q[MAXF][VALUES];
+    size_t nh;
+    int32_t hand_ids[MAXH];
+    int32_t hq[MAXH][HAND_VALUES];
+    int64_t last_id;
+    uint64_t last_ts;
+    int64_t last_dt;
+    /// @brief find the previous finger with the given id, try the one at the same position first
+    const int32_t *match (int32_t id, size_t i) const
+    {
+        if (i < n && ids[i] == id)
+            return q[i];
+        for (size_t j = 0; j < n; ++j)
+            if (ids[j] == id)
+                return q[j];
+        return 0;
+    }
+    /// @brief find the previous hand with the given id
+    const int32_t *match_hand (int32_t id, size_t i) const
+    {
+        if (i < nh && hand_ids[i] == id)
+            return hq[i];
+        for (size_t j = 0; j < nh; ++j)
+            if (hand_ids[j] == id)
+                return hq[j];
+        return 0;
+    }
+    static void unpack (const finger &f, float *v)
+    {
+        v[0] = f.position.x; v[1] = f.position.y; v[2] = f.position.z;
+        v[3] = f.velocity.x; v[4] = f.velocity.y; v[5] = f.velocity.z;
+        v[6] = f.direction.x; v[7] = f.direction.y; v[8] = f.direction.z;
+    }
+    static void pack (const float *v, finger &f)
+    {
+        f.position = vec3 (v[0], v[1], v[2]);
+        f.velocity = vec3 (v[3], v[4], v[5]);
+        f.direction = vec3 (v[6], v[7], v[8]);
+    }
+    static void unpack (const hand &h, float *v)
+    {
+        v[0] = h.palm_position.x; v[1] = h.palm_position.y; v[2] = h.palm_position.z;
+        v[3] = h.palm_normal.x; v[4] = h.palm_normal.y; v[5] = h.palm_normal.z;
+    }
+    static void pack (const float *v, hand &h)
+    {
+        h.palm_position = vec3 (v[0], v[1], v[2]);
+        h.palm_normal = vec3 (v[3], v[4], v[5]);
+    }
+    static unsigned width (const uint64_t *z)
+    {
+        const uint64_t m = z[0] | z[1] | z[2];
+        return m == 0 ? ZERO : m < 0x10 ? NIBBLES : m < 0x100 ? BYTES : VARINTS;
+    }
+    static uint8_t *put_group (unsigned w, const uint64_t *z, uint8_t *p)
+    {
+        switch (w)
+        {
+            default: assert (0); // logic error
+            case ZERO:
+            break;
+            case NIBBLES:
+            *p++ = z[0] | (z[1] << 4);
+            *p++ = z[2];
+            break;
+            case BYTES:
+            *p++ = z[0];
+            *p++ = z[1];
+            *p++ = z[2];
+            break;
+            case VARINTS:
+            p = put_varint (z[2], put_varint (z[1], put_varint (z[0], p)));
+            break;
+        }
+        return p;
+    }
+    static const uint8_t *get_group (unsigned w, const uint8_t *p, const uint8_t *end, uint64_t *z)
+    {
+        switch (w)
+        {
+            default: assert (0); // logic error
+            case ZERO:
+            z[0] = z[1] = z[2] = 0;
+            break;
+            case NIBBLES:
+            if (end - p < 2)
+                throw std::runtime_error ("corrupt compressed block");
+            z[0] = p[0] & 0x0f;
+            z[1] = p[0] >> 4;
+            z[2] = p[1];
+            p += 2;
+            break;
+            case BYTES:
+            if (end - p < 3)
+                throw std::runtime_error ("corrupt compressed block");
+            z[0] = p[0];
+            z[1] = p[1];
+            z[2] = p[2];
+            p += 3;
+            break;
+            case VARINTS:
+            p = get_varint (get_varint (get_varint (p, end, z[0]), end, z[1]), end, z[2]);
+            break;
+        }
+        return p;
+    }
+    uint8_t *encode_hands (const frame &f, uint8_t *p)
+    {
+        assert (f.nhands <= MAXH);
+        p = put_varint (f.has_hands ? f.nhands + 1 : 0, p);
+        int32_t ids1[MAXH];
+        int32_t q1[MAXH][HAND_VALUES];
+        for (size_t i = 0; i < f.nhands; ++i)
+        {
+            const hand &h = f.hands[i];
+            const int32_t *m = match_hand (h.id, i);
+            float v[HAND_VALUES];
+            unpack (h, v);
+            uint64_t z[HAND_VALUES];
+            for (size_t j = 0; j < HAND_VALUES; ++j)
+            {
+                q1[i][j] = lrintf (v[j] * inverse_hand_steps[j]);
+                z[j] = zigzag (static_cast<int64_t> (q1[i][j]) - (m ? m[j] : 0));
+            }
+            const int32_t id0 = i < nh ? hand_ids[i] : 0;
+            uint8_t &tag = *p++;
+            tag = h.id == id0 ? 0 : ID_CHANGED;
+            if (tag)
+                p = put_varint (zigzag (static_cast<int64_t> (h.id) - id0), p);
+            p = put_varint (h.fingers, p);
+            for (size_t g = 0; g < HAND_VALUES / 3; ++g)
+            {
+                const unsigned w = width (z + 3 * g);
+                tag |= w << (2 * g);
+                p = put_group (w, z + 3 * g, p);
+            }
+            ids1[i] = h.id;
+        }
+        nh = f.nhands;
+        memcpy (hand_ids, ids1, nh * sizeof (int32_t));
+        memcpy (hq, q1, nh * sizeof (hq[0]));
+        return p;
+    }
+    const uint8_t *decode_hands (const uint8_t *p, const uint8_t *end, frame &f)
+    {
+        uint64_t x;
+        p = get_varint (p, end, x);
+        if (x > MAXH + 1)
+            throw std::runtime_error ("corrupt compressed frame");
+        f.has_hands = x != 0;
+        f.nhands = x ? x - 1 : 0;
+        int32_t ids1[MAXH];
+        int32_t q1[MAXH][HAND_VALUES];
+        for (size_t i = 0; i < f.nhands; ++i)
+        {
+            if (p >= end)
+                throw std::runtime_error ("corrupt compressed block");
+            const uint8_t tag = *p++;
+            ids1[i] = i < nh ? hand_ids[i] : 0;
+            if (tag & ID_CHANGED)
+            {
+                p = get_varint (p, end, x);
+                ids1[i] += unzigzag (x);
+            }
+            hand &h = f.hands[i];
+            h = hand ();
+            p = get_varint (p, end, x);
+            h.fingers = x;
+            const int32_t *m = match_hand (ids1[i], i);
+            uint64_t z[HAND_VALUES];
+            for (size_t g = 0; g < HAND_VALUES / 3; ++g)
+                p = get_group ((tag >> (2 * g)) & 3, p, end, z + 3 * g);
+            float v[HAND_VALUES];
+            for (size_t j = 0; j < HAND_VALUES; ++j)
+            {
+                q1[i][j] = (m ? m[j] : 0) + unzigzag (z[j]);
+                v[j] = q1[i][j] * hand_steps[j];
+            }
+            h.id = ids1[i];
+            pack (v, h);
+        }
+        nh = f.nhands;
+        memcpy (hand_ids, ids1, nh * sizeof (int32_t));
+        memcpy (hq, q1, nh * sizeof (hq[0]));
+        return p;
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param p quantization parameters
+    /// @param version format version to read or write
+    codec_state (const codec_parameters &p, uint32_t version = CODEC_VERSION)
+        : version (version)
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            steps[i] = p.position_step;
+            steps[i + 3] = p.velocity_step;
+            steps[i + 6] = p.direction_step;
+        }
+        for (size_t i = 0; i < VALUES; ++i)
+        {
+            assert (steps[i] > 0.0f);
+            inverse_steps[i] = 1.0f / steps[i];
+        }
+        for (size_t i = 0; i < 3; ++i)
+        {
+            hand_steps[i] = p.position_step;
+            hand_steps[i + 3] = p.direction_step;
+        }
+        for (size_t i = 0; i < HAND_VALUES; ++i)
+            inverse_hand_steps[i] = 1.0f / hand_steps[i];
+        reset ();
+    }
+    /// @brief start a new block
+    void reset ()
+    {
+        n = 0;
+        nh = 0;
+        last_id = -1;
+        last_ts = 0;
+        last_dt = 0;
+    }
+    /// @brief most bytes one frame can take
+    static size_t max_frame_bytes ()
+    {
+        return 10 * 4 + MAXF * (1 + 10 * (1 + VALUES)) + MAXH * (1 + 10 * (2 + HAND_VALUES));
+    }
+    /// @brief encode a frame
+    ///
+    /// @param f the frame
+    /// @param p where to write, must have room for max_frame_bytes ()
+    ///
+    /// @return one past the last byte written
+    uint8_t *encode (const frame &f, uint8_t *p)
+    {
+        const int64_t dt = f.ts - last_ts;
+        p = put_varint (zigzag (f.id - last_id - 1), p);
+        p = put_varint (zigzag (dt - last_dt), p);
+        p = put_varint (f.s.size (), p);
+        int32_t ids1[MAXF];
+        int32_t q1[MAXF][VALUES];
+        for (size_t i = 0; i < f.s.size (); ++i)
+        {
+            const finger &fi = f.s[i];
+            const int32_t *m = match (fi.id, i);
+            float v[VALUES];
+            unpack (fi, v);
+            uint64_t z[VALUES];
+            for (size_t j = 0; j < VALUES; ++j)
+            {
+                q1[i][j] = lrintf (v[j] * inverse_steps[j]);
+                z[j] = zigzag (static_cast<int64_t> (q1[i][j]) - (m ? m[j] : 0));
+            }
+            const int32_t id0 = i < n ? ids[i] : 0;
+            uint8_t &tag = *p++;
+            tag = fi.id == id0 ? 0 : ID_CHANGED;
+            if (tag)
+                p = put_varint (zigzag (static_cast<int64_t> (fi.id) - id0), p);
+            for (size_t g = 0; g < GROUPS; ++g)
+            {
+                const unsigned w = width (z + 3 * g);
+                tag |= w << (2 * g);
+                p = put_group (w, z + 3 * g, p);
+            }
+            ids1[i] = fi.id;
+        }
+        n = f.s.size ();
+        memcpy (ids, ids1, n * sizeof (int32_t));
+        memcpy (q, q1, n * sizeof (q[0]));
+        if (version >= 2)
+            p = encode_hands (f, p);
+        last_id = f.id;
+        last_ts = f.ts;
+        last_dt = dt;
+        return p;
+    }
+    /// @brief decode a frame
+    ///
+    /// @param p where to read
+    /// @param end one past the last byte of the block
+    /// @param f the frame
+    ///
+    /// @return one past the last byte read
+    const uint8_t *decode (const uint8_t *p, const uint8_t *end, frame &f)
+    {
+        uint64_t x;
+        p = get_varint (p, end, x);
+        f.id = last_id + 1 + unzigzag (x);
+        p = get_varint (p, end, x);
+        const int64_t dt = last_dt + unzigzag (x);
+        f.ts = last_ts + dt;
+        p = get_varint (p, end, x);
+        if (x > MAXF)
+            throw std::runtime_error ("corrupt compressed frame");
+        const size_t nf = x;
+        f.s.resize (nf);
+        int32_t ids1[MAXF];
+        int32_t q1[MAXF][VALUES];
+        for (size_t i = 0; i < nf; ++i)
+        {
+            if (p >= end)
+                throw std::runtime_error ("corrupt compressed block");
+            const uint8_t tag = *p++;
+            ids1[i] = i < n ? ids[i] : 0;
+            if (tag & ID_CHANGED)
+            {
+                p = get_varint (p, end, x);
+                ids1[i] += unzigzag (x);
+            }
+            const int32_t *m = match (ids1[i], i);
+            uint64_t z[VALUES];
+            for (size_t g = 0; g < GROUPS; ++g)
+                p = get_group ((tag >> (2 * g)) & 3, p, end, z + 3 * g);
+            float v[VALUES];
+            for (size_t j = 0; j < VALUES; ++j)
+            {
+                q1[i][j] = (m ? m[j] : 0) + unzigzag (z[j]);
+                v[j] = q1[i][j] * steps[j];
+            }
+            finger &fi = f.s[i];
+            fi.id = ids1[i];
+            pack (v, fi);
+        }
+        n = nf;
+        memcpy (ids, ids1, n * sizeof (int32_t));
+        memcpy (q, q1, n * sizeof (q[0]));
+        if (version >= 2)
+            p = decode_hands (p, end, f);
+        else
+        {
+            f.has_hands = false;
+            f.nhands = 0;
+        }
+        last_id = f.id;
+        last_ts = f.ts;
+        last_dt = dt;
+        return p;
+    }
+};
+
+/// @brief write frames to a compressed recording
+class compressed_writer
+{
+    private:
+    FILE *fp;
+    codec_parameters p;
+    codec_state state;
+    std::vector<uint8_t> block;
+    size_t bytes;
+    uint32_t block_count;
+    uint64_t frames;
+    uint64_t file_bytes;
+    bool write_header ()
+    {
+        codec_header h;
+        memset (&h, 0, sizeof (h));
+        memcpy (h.magic, CODEC_MAGIC, sizeof (h.magic));
+        h.version = CODEC_VERSION;
+        h.block_frames = p.block_frames;
+        h.position_step = p.position_step;
+        h.velocity_step = p.velocity_step;
+        h.direction_step = p.direction_step;
+        h.frames = frames;
+        return fwrite (&h, sizeof (h), 1, fp) == 1;
+    }
+    void flush_block ()
+    {
+        if (block_count == 0)
+            return;
+        codec_block b;
+        b.frames = block_count;
+        b.bytes = bytes;
+        if (fwrite (&b, sizeof (b), 1, fp) != 1 || fwrite (&block[0], 1, bytes, fp) != bytes)
+            throw std::runtime_error ("could not write compressed block");
+        file_bytes += sizeof (b) + bytes;
+        block_count = 0;
+        bytes = 0;
+        state.reset ();
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param fn filename
+    /// @param p compression parameters
+    compressed_writer (const std::string &fn, const codec_parameters &p = codec_parameters ())
+        : fp (fopen (fn.c_str (), "wb"))
+        , p (p)
+        , state (p)
+        , block (p.block_frames * codec_state::max_frame_bytes ())
+        , bytes (0)
+        , block_count (0)
+        , frames (0)
+        , file_bytes (sizeof (codec_header))
+    {
+        if (!fp)
+            throw std::runtime_error ("could not open compressed recording for writing");
+        if (p.block_frames == 0 || !write_header ())
+        {
+            fclose (fp);
+            throw std::runtime_error ("could not write compressed recording header");
+        }
+    }
+    /// @brief destructor
+    ~compressed_writer ()
+    {
+        if (fp)
+        {
+            try { close (); }
+            catch (...) { }
+        }
+    }
+    /// @brief number of frames written
+    uint64_t get_frames () const
+    {
+        return frames;
+    }
+    /// @brief number of bytes written to the file so far
+    uint64_t get_bytes () const
+    {
+        return file_bytes;
+    }
+    /// @brief write a frame
+    ///
+    /// @param f the frame
+    void write (const frame &f)
+    {
+        assert (fp);
+        bytes = state.encode (f, &block[bytes]) - &block[0];
+        ++frames;
+        if (++block_count == p.block_frames)
+            flush_block ();
+    }
+    /// @brief flush the last block, fill in the frame count and close the file
+    void close ()
+    {
+        assert (fp);
+        bool ok = true;
+        try { flush_block (); }
+        catch (...) { ok = false; }
+        ok = ok && (fflush (fp) == 0)
+            && (fseek (fp, 0, SEEK_SET) == 0)
+            && write_header ();
+        ok = (fclose (fp) == 0) && ok;
+        fp = 0;
+        if (!ok)
+            throw std::runtime_error ("could not close compressed recording");
+    }
+};
+
+/// @brief read a memory mapped compressed recording
+class compressed_reader
+{
+    private:
+    int fd;
+    const uint8_t *base;
+    size_t length;
+    uint32_t version;
+    codec_parameters p;
+    /// @brief where each block starts
+    std::vector<const codec_block *> blocks;
+    /// @brief index of the first frame in each block, plus the total
+    std::vector<uint64_t> first_frames;
+    public:
+    /// @brief constructor
+    ///
+    /// @param fn filename
+    compressed_reader (const std::string &fn)
+        : fd (open (fn.c_str (), O_RDONLY))
+        , base (0)
+        , length (0)
+        , version (0)
+    {
+        if (fd == -1)
+            throw std::runtime_error ("could not open compressed recording for reading");
+        struct stat sb;
+        if (fstat (fd, &sb) == -1 || static_cast<size_t> (sb.st_size) < sizeof (codec_header))
+        {
+            ::close (fd);
+            throw std::runtime_error ("compressed recording is too short");
+        }
+        length = sb.st_size;
+        void *m = mmap (0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED)
+        {
+            ::close (fd);
+            throw std::runtime_error ("could not map compressed recording");
+        }
+        base = static_cast<const uint8_t *> (m);
+        const codec_header &h = *reinterpret_cast<const codec_header *> (base);
+        if (memcmp (h.magic, CODEC_MAGIC, sizeof (h.magic)) != 0 || h.version < 1 || h.version > CODEC_VERSION)
+        {
+            munmap (m, length);
+            ::close (fd);
+            throw std::runtime_error ("unrecognized compressed recording format");
+        }
+        version = h.version;
+        p.block_frames = h.block_frames;
+        p.position_step = h.position_step;
+        p.velocity_step = h.velocity_step;
+        p.direction_step = h.direction_step;
+        // find the blocks, ignoring a partially written one at the end, and stopping at one that claims more frames
+        // than it has bytes, since every frame takes at least a byte
+        first_frames.push_back (0);
+        for (size_t off = sizeof (codec_header); off + sizeof (codec_block) <= length; )
+        {
+            const codec_block *b = reinterpret_cast<const codec_block *> (base + off);
+            off += sizeof (codec_block) + b->bytes;
+            if (off > length || b->frames > b->bytes)
+                break;
+            blocks.push_back (b);
+            first_frames.push_back (first_frames.back () + b->frames);
+        }
+    }
+    /// @brief destructor
+    ~compressed_reader ()
+    {
+        munmap (const_cast<uint8_t *> (base), length);
+        ::close (fd);
+    }
+    compressed_reader (const compressed_reader &) = delete;
+    compressed_reader &operator= (const compressed_reader &) = delete;
+    /// @brief the parameters the file was written with
+    const codec_parameters &parameters () const
+    {
+        return p;
+    }
+    /// @brief number of blocks
+    size_t size () const
+    {
+        return blocks.size ();
+    }
+    /// @brief total number of frames
+    uint64_t frames () const
+    {
+        return first_frames.back ();
+    }
+    /// @brief number of frames in a block
+    size_t block_frames (size_t b) const
+    {
+        assert (b < blocks.size ());
+        return blocks[b]->frames;
+    }
+    /// @brief index of the first frame in a block
+    uint64_t first_frame (size_t b) const
+    {
+        assert (b < blocks.size ());
+        return first_frames[b];
+    }
+    /// @brief decode one block
+    ///
+    /// @param b the block
+    /// @param f where to put the frames, must have room for block_frames (b) frames
+    void decode (size_t b, frame *f) const
+    {
+        assert (b < blocks.size ());
+        codec_state state (p, version);
+        const uint8_t *q = reinterpret_cast<const uint8_t *> (blocks[b] + 1);
+        const uint8_t *end = q + blocks[b]->bytes;
+        for (size_t i = 0; i < blocks[b]->frames; ++i)
+        {
+            if (q >= end)
+                throw std::runtime_error ("corrupt compressed block");
+            q = state.decode (q, end, f[i]);
+        }
+        if (q != end)
+            throw std::runtime_error ("corrupt compressed block");
+    }
+    /// @brief decode every block, in parallel
+    ///
+    /// @param f where to put the frames, must have room for frames () frames
+    void decode (frame *f) const
+    {
+        std::atomic<bool> ok (true);
+#pragma omp parallel for schedule(dynamic)
+        for (size_t b = 0; b < blocks.size (); ++b)
+        {
+            try { decode (b, f + first_frames[b]); }
+            catch (...) { ok = false; }
+        }
+        if (!ok)
+            throw std::runtime_error ("corrupt compressed recording");
+    }
+};
+
+}
+
+#endif
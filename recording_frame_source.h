@@ -0,0 +1,51 @@
+/// @file recording_frame_source.h
+/// @brief frames from a recording
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-25
+
+#ifndef RECORDING_FRAME_SOURCE_H
+#define RECORDING_FRAME_SOURCE_H
+
+#include "frame_source.h"
+#include "recording.h"
+#include <string>
+
+namespace soma
+{
+
+/// @brief a frame source that replays a recording
+class recording_frame_source : public paced_frame_source
+{
+    private:
+    recording_reader r;
+    recording_reader::const_iterator i;
+    protected:
+    virtual bool next (frame &f)
+    {
+        if (i == r.end ())
+            return false;
+        (*i).get (f);
+        ++i;
+        return true;
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param fn recording filename
+    /// @param speed replay speed
+    recording_frame_source (const std::string &fn, double speed = 1.0)
+        : paced_frame_source (speed)
+        , r (fn)
+        , i (r.begin ())
+    {
+    }
+    ~recording_frame_source ()
+    {
+        stop ();
+    }
+};
+
+}
+
+#endif
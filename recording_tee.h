@@ -0,0 +1,309 @@
+/// @file recording_tee.h
+/// @brief record frames and mouse events on a background thread
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-04
+
+#ifndef RECORDING_TEE_H
+#define RECORDING_TEE_H
+
+#include "event_log.h"
+#include "frame_source.h"
+#include "notifier.h"
+#include "recording.h"
+#include "spsc_ring.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace soma
+{
+
+/// @brief recording tee parameters
+struct tee_parameters
+{
+    /// @brief start a new file when the current one gets this big
+    uint64_t max_file_bytes;
+    /// @brief start a new file when the current one covers this many useconds
+    uint64_t max_file_duration;
+    /// @brief memory used for records that are waiting to be written
+    size_t memory_budget;
+    tee_parameters ()
+        : max_file_bytes (256 << 20)
+        , max_file_duration (3600ULL * 1000000)
+        , memory_budget (16 << 20)
+    {
+    }
+};
+
+/// @brief copy frames and mouse events to disk without holding up the caller
+///
+/// write () and on_event () copy the record into a lock-free ring and return.  A background thread writes the
+/// records out through buffered writers, so the disk sees large writes.  If the ring fills up, because the disk
+/// can't keep up, records are dropped and counted rather than making the caller wait.
+///
+/// Frames go to prefix-NNNN.soma and events to prefix-NNNN.events.  A new pair of files is started when the
+/// current pair gets too big or covers too much time.
+class recording_tee : public mouse_observer
+{
+    private:
+    struct record
+    {
+        bool is_event;
+        frame f;
+        event_record e;
+    };
+    const std::string prefix;
+    const tee_parameters p;
+    spsc_ring<record> ring;
+    std::thread t;
+    std::atomic<bool> stopping;
+    std::atomic<bool> sleeping;
+    notifier wakeup;
+    // producer state
+    int64_t last_id;
+    uint64_t last_ts;
+    std::atomic<uint64_t> dropped_frames;
+    std::atomic<uint64_t> dropped_events;
+    std::atomic<size_t> max_occupancy;
+    // writer state
+    std::unique_ptr<recording_writer> rw;
+    std::unique_ptr<event_log_writer> ew;
+    uint64_t file_start_ts;
+    std::atomic<uint64_t> frames;
+    std::atomic<uint64_t> events;
+    std::atomic<uint64_t> files;
+    std::atomic<uint64_t> errors;
+    static size_t ring_size (size_t budget)
+    {
+        // largest power of 2 that fits in the budget
+        size_t n = 1;
+        while (n * 2 * sizeof (record) <= budget)
+            n *= 2;
+        return n;
+    }
+    void close_files ()
+    {
+        if (rw)
+            rw->close ();
+        if (ew)
+            ew->close ();
+        rw.reset ();
+        ew.reset ();
+    }
+    void open_files (uint64_t ts)
+    {
+        close_files ();
+        char n[16];
+        snprintf (n, sizeof (n), "-%04llu", static_cast<unsigned long long> (files.load ()));
+        rw.reset (new recording_writer (prefix + n + ".soma"));
+        ew.reset (new event_log_writer (prefix + n + ".events"));
+        file_start_ts = ts;
+        ++files;
+    }
+    void write_record (const record &r)
+    {
+        if (r.is_event)
+        {
+            if (!ew)
+                open_files (r.e.ts);
+            ew->write (r.e);
+            ++events;
+            return;
+        }
+        if (!rw
+            || rw->get_bytes () + ew->get_bytes () >= p.max_file_bytes
+            || r.f.ts - file_start_ts >= p.max_file_duration)
+            open_files (r.f.ts);
+        rw->write (r.f);
+        ++frames;
+    }
+    void run ()
+    {
+        typedef std::chrono::steady_clock clock;
+        // how often buffered records are flushed when there is nothing else to do
+        const std::chrono::seconds flush_interval (1);
+        clock::time_point last_flush = clock::now ();
+        bool dirty = false;
+        while (true)
+        {
+            record *r = ring.front ();
+            if (!r)
+            {
+                if (stopping)
+                    break;
+                // nothing to do, so this is a good time to push buffered records to the file
+                if (dirty && clock::now () - last_flush > flush_interval)
+                {
+                    try
+                    {
+                        if (rw)
+                            rw->flush ();
+                        if (ew)
+                            ew->flush ();
+                    }
+                    catch (...) { ++errors; }
+                    last_flush = clock::now ();
+                    dirty = false;
+                }
+                // sleep until there is something to write, waking to flush if anything is buffered
+                sleeping = true;
+                std::atomic_thread_fence (std::memory_order_seq_cst);
+                if (ring.empty () && !stopping)
+                {
+                    const auto left = flush_interval - (clock::now () - last_flush);
+                    const int ms = std::chrono::duration_cast<std::chrono::milliseconds> (left).count () + 1;
+                    wakeup.wait (dirty ? ms : -1);
+                }
+                sleeping = false;
+                continue;
+            }
+            try { write_record (*r); }
+            catch (...) { ++errors; }
+            ring.pop ();
+            dirty = true;
+        }
+        try { close_files (); }
+        catch (...) { ++errors; }
+    }
+    template<typename F>
+    bool push (F fill)
+    {
+        record *r = ring.prepare ();
+        if (!r)
+            return false;
+        fill (*r);
+        ring.commit ();
+        const size_t n = ring.size ();
+        if (n > max_occupancy)
+            max_occupancy = n;
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+        if (sleeping)
+            wakeup.notify ();
+        return true;
+    }
+    public:
+    /// @brief constructor
+    ///
+    /// @param prefix filename prefix
+    /// @param p parameters
+    recording_tee (const std::string &prefix, const tee_parameters &p = tee_parameters ())
+        : prefix (prefix)
+        , p (p)
+        , ring (ring_size (p.memory_budget))
+        , stopping (false)
+        , sleeping (false)
+        , last_id (0)
+        , last_ts (0)
+        , dropped_frames (0)
+        , dropped_events (0)
+        , max_occupancy (0)
+        , file_start_ts (0)
+        , frames (0)
+        , events (0)
+        , files (0)
+        , errors (0)
+    {
+        t = std::thread (&recording_tee::run, this);
+    }
+    /// @brief destructor
+    ~recording_tee ()
+    {
+        stop ();
+    }
+    /// @brief write what is queued, close the files and stop the writer thread
+    void stop ()
+    {
+        stopping = true;
+        wakeup.notify ();
+        if (t.joinable ())
+            t.join ();
+    }
+    /// @brief queue a frame
+    ///
+    /// @param f the frame
+    void write (const frame &f)
+    {
+        last_id = f.id;
+        last_ts = f.ts;
+        if (!push ([&] (record &r) { r.is_event = false; r.f = f; }))
+            ++dropped_frames;
+    }
+    /// @brief queue a mouse event, it is stamped with the last frame written
+    virtual void on_event (const mouse_event &e)
+    {
+        if (!push ([&] (record &r)
+            {
+                r.is_event = true;
+                r.e.ts = last_ts;
+                r.e.id = last_id;
+                r.e.e = e;
+                r.e.pad = 0;
+            }))
+            ++dropped_events;
+    }
+    /// @brief number of records that can be queued
+    size_t capacity () const
+    {
+        return ring.capacity ();
+    }
+    /// @brief most records that have been waiting at once
+    size_t get_max_occupancy () const
+    {
+        return max_occupancy;
+    }
+    /// @brief number of frames written
+    uint64_t get_frames () const
+    {
+        return frames;
+    }
+    /// @brief number of events written
+    uint64_t get_events () const
+    {
+        return events;
+    }
+    /// @brief number of frames dropped because the ring was full
+    uint64_t get_dropped_frames () const
+    {
+        return dropped_frames;
+    }
+    /// @brief number of events dropped because the ring was full
+    uint64_t get_dropped_events () const
+    {
+        return dropped_events;
+    }
+    /// @brief number of pairs of files started
+    uint64_t get_files () const
+    {
+        return files;
+    }
+    /// @brief number of records that could not be written
+    uint64_t get_errors () const
+    {
+        return errors;
+    }
+};
+
+/// @brief print tee statistics
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param t the tee
+template<typename S>
+void print_stats (S &s, const recording_tee &t)
+{
+    s << t.get_frames () << " frames recorded" << std::endl;
+    s << t.get_events () << " events recorded" << std::endl;
+    s << t.get_dropped_frames () << " frames dropped" << std::endl;
+    s << t.get_dropped_events () << " events dropped" << std::endl;
+    s << t.get_errors () << " write errors" << std::endl;
+    s << t.get_files () << " files" << std::endl;
+    s << t.get_max_occupancy () << "/" << t.capacity () << " max tee occupancy" << std::endl;
+}
+
+}
+
+#endif
@@ -1,88 +1,88 @@
 /// @file sample_dumper.cc
-/// @brief get samples and dump to cout
+/// @brief get samples and dump them to a recording
 /// @author Jeff Perry <jeffsp@gmail.com>
 /// @version 1.0
 /// @date 2013-09-06
 
+#include "event_loop.h"
 #include "frame_counter.h"
-#include "Leap.h"
+#include "frame_sources.h"
+#include "recording.h"
 #include <stdexcept>
 
 using namespace std;
 using namespace soma;
-const string usage = "usage: sample_dumper";
+const string usage = "usage: sample_dumper recording " + frame_source_usage;
 
-/// @brief dump samples to cout
-class sample_dumper : public Leap::Listener
+/// @brief dump samples to a recording
+class sample_dumper : public frame_listener
 {
     private:
-    bool done;
+    done_flag done;
     frame_counter frc;
-    uint64_t start_ts;
+    recording_writer w;
     public:
     /// @brief constructor
-    sample_dumper ()
-        : done (false)
-        , start_ts (0)
+    ///
+    /// @param fn recording filename
+    sample_dumper (const string &fn)
+        : w (fn)
     {
     }
-    /// @brief check if we have exited
-    ///
-    /// @return true is exited
-    bool is_done () const
+    /// @brief destructor
+    ~sample_dumper ()
+    {
+        clog << w.get_frames () << " frames recorded" << endl;
+    }
+    /// @brief get the flag that is set when the user quits
+    done_flag &get_done ()
     {
         return done;
     }
     /// @brief get a frame and dump its contents
     ///
-    /// @param c leap controller
-    virtual void onFrame(const Leap::Controller& c)
+    /// @param f the frame
+    virtual void on_frame (const frame &f)
     {
-        if (done)
+        if (done.is_set ())
             return;
-        const Leap::Frame &f = c.frame ();
-        uint64_t ts = f.timestamp ();
-        if (start_ts == 0)
-            start_ts = ts;
-        frc.update (ts);
-        Leap::PointableList p = f.pointables ();
-        if (p.count () == 6)
+        frc.update (f.ts);
+        if (f.s.size () == 6)
         {
             // we are done
-            done = true;
-        }
-        else if (p.count () == 1)
-        {
-            cout << p[0].tipPosition () << std::endl;
-        }
-        else if (p.count () == 2)
-        {
-            // dump the samples
-            cout << ts - start_ts;
-            double d = p[0].tipPosition ().distanceTo (p[1].tipPosition ());
-            cout << ' ' << d << endl;
-            if (!(frc.get_frames () % 100))
-                std::clog << frc.fps () << "fps" << std::endl;
+            done.set ();
+            return;
         }
+        // dump every frame
+        w.write (f);
+        if (!(frc.get_frames () % 1000))
+            std::clog << frc.fps () << "fps" << std::endl;
     }
 };
 
-int main (int argc, char **)
+int main (int argc, char **argv)
 {
     try
     {
-        if (argc != 1)
+        if (argc < 2 || !valid_frame_source_args (argc - 2, argv + 2))
             throw runtime_error (usage);
 
-        sample_dumper sd;
-        Leap::Controller c (sd);
+        // signals are blocked in every thread started after this
+        event_loop loop;
+
+        sample_dumper sd (argv[1]);
+        unique_ptr<frame_source> src = make_frame_source (argc - 2, argv + 2);
+        loop.quit_when (sd.get_done ());
+        loop.quit_when (src->get_done ());
+        src->start (sd);
 
         clog << "6 fingers = quit" << endl;
         clog << "dumping..." << endl;
 
-        while (!sd.is_done ())
-        {
-        }
+        // sleep until the user quits, the source runs out of frames, or a signal arrives
+        loop.run ();
+
+        src->stop ();
 
         return 0;
     }
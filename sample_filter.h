@@ -0,0 +1,112 @@
+/// @file sample_filter.h
+/// @brief reject hand samples that disagree with the recent samples, one frame at a time
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-08
+
+#ifndef SAMPLE_FILTER_H
+#define SAMPLE_FILTER_H
+
+#include "hand_sample.h"
+#include "sliding_window.h"
+#include "stats.h"
+#include <cstdint>
+
+namespace soma
+{
+
+/// @brief the streaming version of filter ()
+///
+/// A sample is good if its number of fingers is the mode of the number of fingers in the window, and each of its
+/// finger ids is the mode of the ids at that position among the window's samples with that many fingers.  That is
+/// the test filter () applies to a batch of samples, but here the modes are kept up to date as samples enter and
+/// leave the window, so each frame costs the same no matter how long the window is.
+///
+/// When two values are tied for the mode, the one that has been the mode longest wins, where filter () picks the
+/// one that reached the count first in the batch.
+class sample_filter
+{
+    private:
+    /// @brief keeps the modes up to date as samples enter and leave the window
+    struct modes
+    {
+        bounded_running_mode<hand_sample::MAX_FINGERS + 1> sizes;
+        /// @brief ids[n][j] is the distribution of ids at position j of samples with n fingers
+        running_mode ids[hand_sample::MAX_FINGERS + 1][hand_sample::MAX_FINGERS];
+        void add (const hand_sample &s)
+        {
+            sizes.add (s.size ());
+            for (size_t j = 0; j < s.size (); ++j)
+                ids[s.size ()][j].add (s[j].id);
+        }
+        void remove (const hand_sample &s)
+        {
+            sizes.remove (s.size ());
+            for (size_t j = 0; j < s.size (); ++j)
+                ids[s.size ()][j].remove (s[j].id);
+        }
+    };
+    sliding_window<hand_sample> w;
+    modes m;
+    public:
+    /// @brief constructor
+    ///
+    /// @param duration window duration in useconds
+    sample_filter (uint64_t duration)
+        : w (duration)
+    {
+    }
+    /// @brief add a sample to the window
+    ///
+    /// @param ts timestamp in useconds
+    /// @param s the sample
+    void add (uint64_t ts, const hand_sample &s)
+    {
+        w.add (ts, s, m);
+    }
+    /// @brief check a sample against the samples in the window
+    ///
+    /// @param s the sample
+    ///
+    /// @return true if filter () would keep it
+    bool is_good (const hand_sample &s) const
+    {
+        if (w.size () == 0 || static_cast<int> (s.size ()) != m.sizes.get_mode ())
+            return false;
+        for (size_t j = 0; j < s.size (); ++j)
+            if (s[j].id != m.ids[s.size ()][j].get_mode ())
+                return false;
+        return true;
+    }
+    /// @brief add a sample to the window and check it
+    ///
+    /// @param ts timestamp in useconds
+    /// @param s the sample
+    ///
+    /// @return true if the sample agrees with the window, including itself
+    bool update (uint64_t ts, const hand_sample &s)
+    {
+        add (ts, s);
+        return is_good (s);
+    }
+    /// @brief the most common number of fingers in the window
+    size_t get_num_fingers () const
+    {
+        return m.sizes.get_mode ();
+    }
+    /// @brief number of samples in the window
+    size_t size () const
+    {
+        return w.size ();
+    }
+    /// @brief remove all samples from the window
+    void clear ()
+    {
+        w.clear ();
+        m = modes ();
+    }
+};
+
+}
+
+#endif
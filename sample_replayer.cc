@@ -0,0 +1,78 @@
+/// @file sample_replayer.cc
+/// @brief replay a recording through the classifiers as fast as possible
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-24
+
+#include "hand_shape_classifier.h"
+#include "mouse_clicker.h"
+#include "recording.h"
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: sample_replayer recording [verbose]";
+
+int main (int argc, char **argv)
+{
+    try
+    {
+        if (argc != 2 && argc != 3)
+            throw runtime_error (usage);
+
+        const bool verbose = (argc == 3);
+        recording_reader r (argv[1]);
+
+        static const uint64_t WINDOW_DURATION = 200000;
+        hand_shape_classifier hsc (WINDOW_DURATION);
+        pinch_detector pd;
+        uint64_t frames = 0;
+        uint64_t shape_changes = 0;
+        uint64_t pinches = 0;
+        uint64_t first_ts = 0;
+        uint64_t last_ts = 0;
+
+        auto start = chrono::steady_clock::now ();
+        for (auto f : r)
+        {
+            const uint64_t ts = f.timestamp ();
+            if (frames++ == 0)
+                first_ts = ts;
+            last_ts = ts;
+            // the fingers are used straight from the mapped file
+            hand_sample s (f.begin (), f.end ());
+            hsc.add (ts, s);
+            if (hsc.has_changed ())
+            {
+                ++shape_changes;
+                if (verbose)
+                    clog << ts - first_ts << '\t' << to_string (hsc.get_shape ()) << endl;
+            }
+            pd.update (ts, s);
+            if (pd.is_set ())
+            {
+                ++pinches;
+                if (verbose)
+                    clog << ts - first_ts << "\tpinch" << endl;
+                pd.reset ();
+            }
+        }
+        auto secs = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+
+        clog << frames << " frames" << endl;
+        clog << (last_ts - first_ts) / 1000000.0 << " recorded seconds" << endl;
+        clog << shape_changes << " shape changes" << endl;
+        clog << pinches << " pinches" << endl;
+        clog << secs << " replay seconds" << endl;
+        if (secs > 0.0)
+            clog << frames / secs << " frames/sec" << endl;
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,90 @@
+/// @file sample_seeker.cc
+/// @brief replay a window of a recording around a time or frame
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-02
+
+#include "hand_shape_classifier.h"
+#include "mouse_clicker.h"
+#include "mouse_pointer.h"
+#include "recording.h"
+#include <stdexcept>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: sample_seeker recording seconds|#frame [before [after [warm_up]]]";
+
+int main (int argc, char **argv)
+{
+    try
+    {
+        if (argc < 3 || argc > 6)
+            throw runtime_error (usage);
+
+        recording_reader r (argv[1]);
+        if (r.begin () == r.end ())
+            throw runtime_error ("the recording is empty");
+        const uint64_t first_ts = (*r.begin ()).timestamp ();
+
+        // find the frame of interest
+        const string pos (argv[2]);
+        recording_reader::const_iterator i = pos[0] == '#'
+            ? r.seek_frame (atol (pos.c_str () + 1))
+            : r.seek (first_ts + atof (pos.c_str ()) * 1000000);
+        if (i == r.end ())
+            throw runtime_error ("the recording ends before " + pos);
+        const uint64_t ts = (*i).timestamp ();
+        const uint64_t before = (argc > 3 ? atof (argv[3]) : 1.0) * 1000000;
+        const uint64_t after = (argc > 4 ? atof (argv[4]) : 5.0) * 1000000;
+        const uint64_t start_ts = ts > before ? ts - before : 0;
+        const uint64_t end_ts = ts + after;
+
+        // the stages have to see the frames leading up to the window to be in the same state they would be in
+        // after a full replay
+        static const uint64_t WINDOW_DURATION = 200000;
+        const uint64_t SMOOTHER_DURATION = pointer_smoother::DURATION;
+        const uint64_t warm_up = argc > 5 ? atof (argv[5]) * 1000000 : max (WINDOW_DURATION, SMOOTHER_DURATION);
+        hand_shape_classifier hsc (WINDOW_DURATION);
+        pointer_smoother ps;
+        pinch_detector pd;
+
+        clog << "replaying " << (start_ts - first_ts) / 1000000.0
+            << " to " << (end_ts - first_ts) / 1000000.0
+            << " seconds, warming up from " << (start_ts > warm_up + first_ts ? start_ts - warm_up - first_ts : 0) / 1000000.0
+            << endl;
+        cout << "seconds\tid\tfingers\tshape\tx\ty\tpinch" << endl;
+        for (auto j = r.warm_up (start_ts, warm_up); j != r.end () && (*j).timestamp () <= end_ts; ++j)
+        {
+            const recorded_frame f = *j;
+            hand_sample s (f.begin (), f.end ());
+            frame_features ff (s);
+            hsc.add (f.timestamp (), ff);
+            if (ff.size () == 1 || ff.size () == 2)
+                ps.update (f.timestamp (), pointer_finger (ff).position.x, pointer_finger (ff).position.y);
+            else
+                ps.clear ();
+            pd.update (f.timestamp (), ff);
+            const bool pinched = pd.is_set ();
+            if (pinched)
+                pd.reset ();
+            if (f.timestamp () < start_ts)
+                continue;
+            cout << (f.timestamp () - first_ts) / 1000000.0
+                << '\t' << f.id ()
+                << '\t' << ff.size ()
+                << '\t' << to_string (hsc.get_shape ())
+                << '\t' << (ff.size () == 1 || ff.size () == 2 ? ps.x () : 0.0)
+                << '\t' << (ff.size () == 1 || ff.size () == 2 ? ps.y () : 0.0)
+                << '\t' << (pinched ? "pinch" : "")
+                << (f.timestamp () == ts ? "\t<--" : "")
+                << endl;
+        }
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,76 @@
+/// @file session_analyzer.cc
+/// @brief summarize finger distances, speeds and counts over many recordings
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-11
+
+#include "session_store.h"
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: session_analyzer [-o store] recording|store [recording|store ...]";
+
+int main (int argc, char **argv)
+{
+    try
+    {
+        string output;
+        int first = 1;
+        if (argc > 2 && string (argv[1]) == "-o")
+        {
+            output = argv[2];
+            first = 3;
+        }
+        if (first >= argc)
+            throw runtime_error (usage);
+
+        session_store s;
+        for (int i = first; i < argc; ++i)
+        {
+            if (is_session_store (argv[i]))
+            {
+                session_store t;
+                t.load (argv[i]);
+                s.add (t);
+            }
+            else
+            {
+                recording_reader r (argv[i]);
+                s.add (r);
+            }
+        }
+        clog << s.frames () << " frames, " << s.fingers () << " fingers" << endl;
+        if (!output.empty ())
+        {
+            clog << "writing " << output << endl;
+            s.save (output);
+        }
+
+        const vector<uint32_t> c = finger_counts (s);
+        cout << "fingers per frame: ";
+        print_stats (cout, summarize (c));
+        print_histogram (cout, histogram (c, 0.0, 1.0, hand_sample::MAX_FINGERS + 1), 0.0, 1.0);
+        const uint64_t changes = count_changes (c);
+        cout << "finger count changes: " << changes
+            << " (" << 100.0 * changes / max<size_t> (1, s.frames ()) << "% of frames)" << endl;
+
+        const vector<float> v = finger_speeds (s);
+        cout << "finger speed, mm/s: ";
+        print_stats (cout, summarize (v));
+        print_histogram (cout, histogram (v, 0.0, 50.0, 40), 0.0, 50.0);
+
+        const vector<float> d = finger_distances (s, select_frames (s, 2));
+        cout << "two finger distance, mm: ";
+        print_stats (cout, summarize (d));
+        print_histogram (cout, histogram (d, 0.0, 5.0, 40), 0.0, 5.0);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
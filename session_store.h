@@ -0,0 +1,665 @@
+/// @file session_store.h
+/// @brief frames stored column by column for offline analysis
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-11
+
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#include "frame_source.h"
+#include "recording.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <omp.h>
+#include <sys/stat.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace soma
+{
+
+/// @brief session store file header
+///
+/// The header is followed by the columns, one after another, in the order they are listed in session_store.  Each
+/// column is written exactly as it is laid out in memory.
+struct session_store_header
+{
+    /// @brief identifies the file type
+    char magic[8];
+    /// @brief format version
+    uint32_t version;
+    /// @brief unused, must be zero
+    uint32_t reserved;
+    /// @brief number of frames
+    uint64_t frames;
+    /// @brief number of fingers in all of the frames
+    uint64_t fingers;
+};
+
+static const char SESSION_STORE_MAGIC[8] = { 'S', 'O', 'M', 'A', 'C', 'O', 'L', 0 };
+static const uint32_t SESSION_STORE_VERSION = 1;
+
+static_assert (sizeof (session_store_header) == 32, "unexpected session_store_header size");
+
+/// @brief frames from one or more sessions, stored by column
+///
+/// A recording keeps each frame's fingers together, which is what replaying needs.  Analyses that look at one
+/// value across millions of fingers, like the distribution of finger speeds, only need one or two columns, and
+/// contiguous columns are what the compiler can vectorize and what OpenMP can split across cores.
+///
+/// Frame i's fingers are at offsets[i] up to offsets[i + 1] in the finger columns.
+class session_store
+{
+    private:
+    // frame columns
+    std::vector<int64_t> frame_ids;
+    std::vector<uint64_t> timestamps;
+    std::vector<uint64_t> offsets;
+    // finger columns
+    std::vector<int32_t> ids;
+    std::vector<float> x, y, z;
+    std::vector<float> vx, vy, vz;
+    template<typename T>
+    static bool write_column (FILE *fp, const std::vector<T> &c)
+    {
+        return c.empty () || fwrite (&c[0], sizeof (T), c.size (), fp) == c.size ();
+    }
+    template<typename T>
+    static bool read_column (FILE *fp, std::vector<T> &c, uint64_t n)
+    {
+        c.resize (n);
+        return c.empty () || fread (&c[0], sizeof (T), c.size (), fp) == c.size ();
+    }
+    public:
+    session_store ()
+        : offsets (1, 0)
+    {
+    }
+    /// @brief forget everything
+    void clear ()
+    {
+        frame_ids.clear ();
+        timestamps.clear ();
+        offsets.assign (1, 0);
+        ids.clear ();
+        x.clear (); y.clear (); z.clear ();
+        vx.clear (); vy.clear (); vz.clear ();
+    }
+    /// @brief add a frame
+    ///
+    /// @tparam T finger iterator type
+    /// @param id frame id
+    /// @param ts frame timestamp in useconds
+    /// @param begin first finger
+    /// @param end one past the last finger
+    template<typename T>
+    void add (int64_t id, uint64_t ts, T begin, T end)
+    {
+        frame_ids.push_back (id);
+        timestamps.push_back (ts);
+        for (T i = begin; i != end; ++i)
+        {
+            ids.push_back (i->id);
+            x.push_back (i->position.x);
+            y.push_back (i->position.y);
+            z.push_back (i->position.z);
+            vx.push_back (i->velocity.x);
+            vy.push_back (i->velocity.y);
+            vz.push_back (i->velocity.z);
+        }
+        offsets.push_back (ids.size ());
+    }
+    /// @brief add a frame
+    ///
+    /// @param f the frame
+    void add (const frame &f)
+    {
+        add (f.id, f.ts, f.s.begin (), f.s.end ());
+    }
+    /// @brief add all of the frames in a recording
+    ///
+    /// @param r the recording
+    void add (const recording_reader &r)
+    {
+        for (auto i = r.begin (); i != r.end (); ++i)
+        {
+            const recorded_frame f = *i;
+            add (f.id (), f.timestamp (), f.begin (), f.end ());
+        }
+    }
+    /// @brief add all of the frames in another store
+    ///
+    /// @param s the store
+    void add (const session_store &s)
+    {
+        const uint64_t n = ids.size ();
+        frame_ids.insert (frame_ids.end (), s.frame_ids.begin (), s.frame_ids.end ());
+        timestamps.insert (timestamps.end (), s.timestamps.begin (), s.timestamps.end ());
+        for (size_t i = 1; i < s.offsets.size (); ++i)
+            offsets.push_back (n + s.offsets[i]);
+        ids.insert (ids.end (), s.ids.begin (), s.ids.end ());
+        x.insert (x.end (), s.x.begin (), s.x.end ());
+        y.insert (y.end (), s.y.begin (), s.y.end ());
+        z.insert (z.end (), s.z.begin (), s.z.end ());
+        vx.insert (vx.end (), s.vx.begin (), s.vx.end ());
+        vy.insert (vy.end (), s.vy.begin (), s.vy.end ());
+        vz.insert (vz.end (), s.vz.begin (), s.vz.end ());
+    }
+    /// @brief number of frames
+    size_t frames () const
+    {
+        return frame_ids.size ();
+    }
+    /// @brief number of fingers in all of the frames
+    size_t fingers () const
+    {
+        return ids.size ();
+    }
+    /// @brief number of fingers in a frame
+    ///
+    /// @param i frame number
+    size_t fingers (size_t i) const
+    {
+        assert (i < frames ());
+        return offsets[i + 1] - offsets[i];
+    }
+    /// @brief frame ids
+    const std::vector<int64_t> &get_frame_ids () const
+    {
+        return frame_ids;
+    }
+    /// @brief frame timestamps in useconds
+    const std::vector<uint64_t> &get_timestamps () const
+    {
+        return timestamps;
+    }
+    /// @brief where each frame's fingers start, with one more entry for the end of the last frame
+    const std::vector<uint64_t> &get_offsets () const
+    {
+        return offsets;
+    }
+    /// @brief finger ids
+    const std::vector<int32_t> &get_ids () const
+    {
+        return ids;
+    }
+    /// @brief finger x positions in mm
+    const std::vector<float> &get_x () const
+    {
+        return x;
+    }
+    /// @brief finger y positions in mm
+    const std::vector<float> &get_y () const
+    {
+        return y;
+    }
+    /// @brief finger z positions in mm
+    const std::vector<float> &get_z () const
+    {
+        return z;
+    }
+    /// @brief finger x velocities in mm/s
+    const std::vector<float> &get_vx () const
+    {
+        return vx;
+    }
+    /// @brief finger y velocities in mm/s
+    const std::vector<float> &get_vy () const
+    {
+        return vy;
+    }
+    /// @brief finger z velocities in mm/s
+    const std::vector<float> &get_vz () const
+    {
+        return vz;
+    }
+    /// @brief write the store to a file
+    ///
+    /// @param fn filename
+    void save (const std::string &fn) const
+    {
+        FILE *fp = fopen (fn.c_str (), "wb");
+        if (!fp)
+            throw std::runtime_error ("could not open session store for writing");
+        session_store_header h;
+        memset (&h, 0, sizeof (h));
+        memcpy (h.magic, SESSION_STORE_MAGIC, sizeof (h.magic));
+        h.version = SESSION_STORE_VERSION;
+        h.frames = frames ();
+        h.fingers = fingers ();
+        bool ok = fwrite (&h, sizeof (h), 1, fp) == 1
+            && write_column (fp, frame_ids)
+            && write_column (fp, timestamps)
+            && write_column (fp, offsets)
+            && write_column (fp, ids)
+            && write_column (fp, x) && write_column (fp, y) && write_column (fp, z)
+            && write_column (fp, vx) && write_column (fp, vy) && write_column (fp, vz);
+        ok = (fclose (fp) == 0) && ok;
+        if (!ok)
+            throw std::runtime_error ("could not write session store");
+    }
+    /// @brief read a store from a file, replacing what is in this one
+    ///
+    /// @param fn filename
+    void load (const std::string &fn)
+    {
+        FILE *fp = fopen (fn.c_str (), "rb");
+        if (!fp)
+            throw std::runtime_error ("could not open session store for reading");
+        struct stat sb;
+        session_store_header h;
+        if (fstat (fileno (fp), &sb) == -1
+            || fread (&h, sizeof (h), 1, fp) != 1
+            || memcmp (h.magic, SESSION_STORE_MAGIC, sizeof (h.magic)) != 0
+            || h.version != SESSION_STORE_VERSION)
+        {
+            fclose (fp);
+            throw std::runtime_error ("unrecognized session store format");
+        }
+        // the columns have to fill the rest of the file exactly, which also keeps a damaged header from making us
+        // allocate more than the file holds
+        const uint64_t frame_bytes = sizeof (int64_t) + sizeof (uint64_t) + sizeof (uint64_t);
+        const uint64_t finger_bytes = sizeof (int32_t) + 6 * sizeof (float);
+        const uint64_t size = sb.st_size;
+        const uint64_t fixed = sizeof (h) + sizeof (uint64_t);
+        if (size < fixed
+            || h.frames > (size - fixed) / frame_bytes
+            || h.fingers > (size - fixed - h.frames * frame_bytes) / finger_bytes
+            || fixed + h.frames * frame_bytes + h.fingers * finger_bytes != size)
+        {
+            fclose (fp);
+            clear ();
+            throw std::runtime_error ("session store is damaged");
+        }
+        bool ok = false;
+        try
+        {
+            ok = read_column (fp, frame_ids, h.frames)
+                && read_column (fp, timestamps, h.frames)
+                && read_column (fp, offsets, h.frames + 1)
+                && read_column (fp, ids, h.fingers)
+                && read_column (fp, x, h.fingers) && read_column (fp, y, h.fingers) && read_column (fp, z, h.fingers)
+                && read_column (fp, vx, h.fingers) && read_column (fp, vy, h.fingers) && read_column (fp, vz, h.fingers)
+                && offsets.front () == 0 && offsets.back () == h.fingers
+                && std::is_sorted (offsets.begin (), offsets.end ());
+        }
+        catch (...)
+        {
+            fclose (fp);
+            clear ();
+            throw;
+        }
+        fclose (fp);
+        if (!ok)
+        {
+            clear ();
+            throw std::runtime_error ("session store is damaged");
+        }
+    }
+};
+
+/// @brief check if a file is a session store
+///
+/// @param fn filename
+///
+/// @return true if the file starts with a session store header
+bool is_session_store (const std::string &fn)
+{
+    FILE *fp = fopen (fn.c_str (), "rb");
+    if (!fp)
+        return false;
+    char magic[sizeof (SESSION_STORE_MAGIC)];
+    const bool ok = fread (magic, sizeof (magic), 1, fp) == 1
+        && memcmp (magic, SESSION_STORE_MAGIC, sizeof (magic)) == 0;
+    fclose (fp);
+    return ok;
+}
+
+// The kernels below run over whole columns, split across cores with OpenMP.  With the release flags gcc doesn't
+// vectorize loops that call sqrt or reduce floating point numbers, so those kernels use SSE2 themselves, four
+// fingers or frames at a time, like frame_features does.
+
+/// @brief the number of fingers in each frame
+///
+/// @param s the store
+///
+/// @return one count per frame
+std::vector<uint32_t> finger_counts (const session_store &s)
+{
+    const std::vector<uint64_t> &o = s.get_offsets ();
+    std::vector<uint32_t> c (s.frames ());
+    const long n = c.size ();
+#pragma omp parallel for
+    for (long i = 0; i < n; ++i)
+        c[i] = o[i + 1] - o[i];
+    return c;
+}
+
+/// @brief the speed of each finger
+///
+/// @param s the store
+///
+/// @return one speed per finger in mm/s
+std::vector<float> finger_speeds (const session_store &s)
+{
+    const float *vx = s.get_vx ().data ();
+    const float *vy = s.get_vy ().data ();
+    const float *vz = s.get_vz ().data ();
+    std::vector<float> v (s.fingers ());
+    float *p = v.data ();
+    const long n = v.size ();
+    long i0 = 0;
+#ifdef __SSE2__
+    const long blocks = n / 4;
+#pragma omp parallel for
+    for (long b = 0; b < blocks; ++b)
+    {
+        const long i = 4 * b;
+        const __m128 x = _mm_loadu_ps (vx + i);
+        const __m128 y = _mm_loadu_ps (vy + i);
+        const __m128 z = _mm_loadu_ps (vz + i);
+        const __m128 v2 = _mm_add_ps (_mm_add_ps (_mm_mul_ps (x, x), _mm_mul_ps (y, y)), _mm_mul_ps (z, z));
+        _mm_storeu_ps (p + i, _mm_sqrt_ps (v2));
+    }
+    i0 = 4 * blocks;
+#endif
+#pragma omp parallel for
+    for (long i = i0; i < n; ++i)
+        p[i] = std::sqrt (vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+    return v;
+}
+
+/// @brief find the frames that have a number of fingers
+///
+/// Each thread counts the matching frames in its part of the column, the counts tell each thread where its frames
+/// go, and then each thread copies its frames out.
+///
+/// @param s the store
+/// @param n the number of fingers
+///
+/// @return frame numbers, in order
+std::vector<uint64_t> select_frames (const session_store &s, size_t n)
+{
+    const uint64_t *o = s.get_offsets ().data ();
+    const long frames = s.frames ();
+    std::vector<uint64_t> f;
+    std::vector<size_t> counts;
+#pragma omp parallel
+    {
+        const long t = omp_get_thread_num ();
+        const long threads = omp_get_num_threads ();
+        const long b = frames * t / threads;
+        const long e = frames * (t + 1) / threads;
+        size_t c = 0;
+        for (long i = b; i < e; ++i)
+            c += o[i + 1] - o[i] == n;
+#pragma omp single
+        counts.resize (threads + 1);
+        counts[t + 1] = c;
+#pragma omp barrier
+#pragma omp single
+        {
+            for (long i = 0; i < threads; ++i)
+                counts[i + 1] += counts[i];
+            f.resize (counts[threads]);
+        }
+        uint64_t *p = f.data () + counts[t];
+        for (long i = b; i < e; ++i)
+            if (o[i + 1] - o[i] == n)
+                *p++ = i;
+    }
+    return f;
+}
+
+/// @brief the distance between the first two fingers of each frame, like pinch_detector and mouse_pointer use
+///
+/// @param s the store
+/// @param f frame numbers, which must all have at least two fingers, see select_frames ()
+///
+/// @return one distance per frame in mm
+std::vector<float> finger_distances (const session_store &s, const std::vector<uint64_t> &f)
+{
+    const std::vector<uint64_t> &o = s.get_offsets ();
+    const float *x = s.get_x ().data ();
+    const float *y = s.get_y ().data ();
+    const float *z = s.get_z ().data ();
+    std::vector<float> d (f.size ());
+    const long n = d.size ();
+    long i0 = 0;
+#ifdef __SSE2__
+    // the fingers aren't next to each other, so gather four frames' worth, then subtract and sqrt them together
+    const long blocks = n / 4;
+#pragma omp parallel for
+    for (long b = 0; b < blocks; ++b)
+    {
+        const long i = 4 * b;
+        uint64_t j[4];
+        for (int k = 0; k < 4; ++k)
+        {
+            j[k] = o[f[i + k]];
+            assert (o[f[i + k] + 1] - j[k] >= 2);
+        }
+        const __m128 dx = _mm_sub_ps (_mm_setr_ps (x[j[0] + 1], x[j[1] + 1], x[j[2] + 1], x[j[3] + 1]),
+            _mm_setr_ps (x[j[0]], x[j[1]], x[j[2]], x[j[3]]));
+        const __m128 dy = _mm_sub_ps (_mm_setr_ps (y[j[0] + 1], y[j[1] + 1], y[j[2] + 1], y[j[3] + 1]),
+            _mm_setr_ps (y[j[0]], y[j[1]], y[j[2]], y[j[3]]));
+        const __m128 dz = _mm_sub_ps (_mm_setr_ps (z[j[0] + 1], z[j[1] + 1], z[j[2] + 1], z[j[3] + 1]),
+            _mm_setr_ps (z[j[0]], z[j[1]], z[j[2]], z[j[3]]));
+        const __m128 d2 = _mm_add_ps (_mm_add_ps (_mm_mul_ps (dx, dx), _mm_mul_ps (dy, dy)), _mm_mul_ps (dz, dz));
+        _mm_storeu_ps (d.data () + i, _mm_sqrt_ps (d2));
+    }
+    i0 = 4 * blocks;
+#endif
+#pragma omp parallel for
+    for (long i = i0; i < n; ++i)
+    {
+        const uint64_t j = o[f[i]];
+        assert (o[f[i] + 1] - j >= 2);
+        const float dx = x[j + 1] - x[j];
+        const float dy = y[j + 1] - y[j];
+        const float dz = z[j + 1] - z[j];
+        d[i] = std::sqrt (dx * dx + dy * dy + dz * dz);
+    }
+    return d;
+}
+
+/// @brief count the frames whose finger count differs from the frame before
+///
+/// @param c finger counts, see finger_counts ()
+///
+/// @return number of changes
+uint64_t count_changes (const std::vector<uint32_t> &c)
+{
+    uint64_t changes = 0;
+    const long n = c.size ();
+#pragma omp parallel for reduction(+:changes)
+    for (long i = 1; i < n; ++i)
+        changes += c[i] != c[i - 1];
+    return changes;
+}
+
+/// @brief a summary of the values in a column
+struct column_summary
+{
+    uint64_t n;
+    double sum;
+    double min;
+    double max;
+    double mean () const
+    {
+        return n ? sum / n : 0.0;
+    }
+};
+
+/// @brief summarize a column
+///
+/// @tparam T value type
+/// @param v the values
+///
+/// @return count, sum, smallest and largest value
+template<typename T>
+column_summary summarize (const std::vector<T> &v)
+{
+    double sum = 0.0;
+    double lo = std::numeric_limits<double>::max ();
+    double hi = -std::numeric_limits<double>::max ();
+    const long n = v.size ();
+#pragma omp parallel for reduction(+:sum) reduction(min:lo) reduction(max:hi)
+    for (long i = 0; i < n; ++i)
+    {
+        const double x = v[i];
+        sum += x;
+        lo = x < lo ? x : lo;
+        hi = x > hi ? x : hi;
+    }
+    column_summary s = { v.size (), sum, n ? lo : 0.0, n ? hi : 0.0 };
+    return s;
+}
+
+/// @brief summarize a column of floats
+///
+/// Like summarize () for other types, but four values at a time.  The sums are kept in doubles, two to a register,
+/// and the smallest and largest values are kept as floats, since they are floats to begin with.
+///
+/// @param v the values
+///
+/// @return count, sum, smallest and largest value
+column_summary summarize (const std::vector<float> &v)
+{
+    double sum = 0.0;
+    double lo = std::numeric_limits<double>::max ();
+    double hi = -std::numeric_limits<double>::max ();
+    const float *p = v.data ();
+    const long n = v.size ();
+    long i0 = 0;
+#ifdef __SSE2__
+    const long blocks = n / 4;
+#pragma omp parallel reduction(+:sum) reduction(min:lo) reduction(max:hi)
+    {
+        __m128d s0 = _mm_setzero_pd ();
+        __m128d s1 = _mm_setzero_pd ();
+        __m128 l = _mm_set1_ps (std::numeric_limits<float>::max ());
+        __m128 h = _mm_set1_ps (-std::numeric_limits<float>::max ());
+#pragma omp for nowait
+        for (long b = 0; b < blocks; ++b)
+        {
+            const __m128 x = _mm_loadu_ps (p + 4 * b);
+            s0 = _mm_add_pd (s0, _mm_cvtps_pd (x));
+            s1 = _mm_add_pd (s1, _mm_cvtps_pd (_mm_movehl_ps (x, x)));
+            l = _mm_min_ps (l, x);
+            h = _mm_max_ps (h, x);
+        }
+        double ts[2];
+        _mm_storeu_pd (ts, _mm_add_pd (s0, s1));
+        float tl[4];
+        float th[4];
+        _mm_storeu_ps (tl, l);
+        _mm_storeu_ps (th, h);
+        sum += ts[0] + ts[1];
+        for (int k = 0; k < 4; ++k)
+        {
+            lo = tl[k] < lo ? tl[k] : lo;
+            hi = th[k] > hi ? th[k] : hi;
+        }
+    }
+    i0 = 4 * blocks;
+#endif
+    for (long i = i0; i < n; ++i)
+    {
+        const double x = p[i];
+        sum += x;
+        lo = x < lo ? x : lo;
+        hi = x > hi ? x : hi;
+    }
+    column_summary s = { v.size (), sum, n ? lo : 0.0, n ? hi : 0.0 };
+    return s;
+}
+
+/// @brief count the values in a column in equal width buckets
+///
+/// Each thread counts its part of the column into its own buckets, and the buckets are added up at the end.
+///
+/// @tparam T value type
+/// @param v the values
+/// @param lo lower edge of the first bucket
+/// @param width bucket width
+/// @param buckets number of buckets, values outside of the buckets are counted in the first or last one
+///
+/// @return the counts, bucket i holds values from lo + i * width up to lo + (i + 1) * width
+template<typename T>
+std::vector<uint64_t> histogram (const std::vector<T> &v, double lo, double width, size_t buckets)
+{
+    assert (width > 0.0);
+    assert (buckets > 0);
+    std::vector<uint64_t> counts (buckets);
+    const long n = v.size ();
+    const long last = buckets - 1;
+#pragma omp parallel
+    {
+        std::vector<uint64_t> c (buckets);
+#pragma omp for nowait
+        for (long i = 0; i < n; ++i)
+        {
+            const double b = std::floor ((v[i] - lo) / width);
+            ++c[b < 0.0 ? 0 : (b > last ? last : static_cast<long> (b))];
+        }
+#pragma omp critical
+        for (size_t i = 0; i < buckets; ++i)
+            counts[i] += c[i];
+    }
+    return counts;
+}
+
+/// @brief print a histogram's buckets that aren't empty
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param h the counts, see histogram ()
+/// @param lo lower edge of the first bucket
+/// @param width bucket width
+template<typename S>
+void print_histogram (S &s, const std::vector<uint64_t> &h, double lo, double width)
+{
+    uint64_t total = 0;
+    for (auto i : h)
+        total += i;
+    for (size_t i = 0; i < h.size (); ++i)
+    {
+        if (h[i] == 0)
+            continue;
+        s << "\t" << lo + i * width;
+        if (i + 1 < h.size ())
+            s << "-" << lo + (i + 1) * width;
+        else
+            s << "+";
+        s << "\t" << h[i] << "\t" << 100.0 * h[i] / total << "%" << std::endl;
+    }
+}
+
+/// @brief print a column summary
+///
+/// @tparam S stream type
+/// @param s stream
+/// @param c the summary
+template<typename S>
+void print_stats (S &s, const column_summary &c)
+{
+    s << c.n << " values, "
+        << c.mean () << " mean, "
+        << c.min << " min, "
+        << c.max << " max" << std::endl;
+}
+
+}
+
+#endif
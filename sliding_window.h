@@ -7,11 +7,14 @@
 #ifndef SLIDING_WINDOW_H
 #define SLIDING_WINDOW_H
 
+#include <array>
 #include <cassert>
 #include <cstdint>
+#include <cstddef>
 #include <cstdlib>
+#include <iterator>
+#include <type_traits>
 #include <vector>
-#include <deque>
 
 namespace soma
 {
@@ -27,28 +30,166 @@ struct do_nothing
 
 /// @brief A sliding window of samples
 ///
+/// The samples and their timestamps are kept in a ring buffer whose size is a power of 2.  It starts big enough to
+/// hold a full window at the highest frame rate we expect, and doubles if it ever fills up, so after the first few
+/// frames adding a sample never allocates.  Samples that slide out of the window are not destroyed, they are
+/// overwritten by later samples.
+///
 /// @tparam T sample type
 template<typename T>
 class sliding_window
 {
+    public:
+    /// @brief the highest frame rate the initial capacity allows for, in frames per second
+    static const int DEFAULT_MAX_FPS = 300;
+    /// @brief iterate over the samples, newest first
+    class const_iterator
+    {
+        private:
+        const T *base;
+        size_t mask;
+        // counts down from the newest sample's position, wrapping is taken care of by the mask
+        size_t p;
+        public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+        const_iterator ()
+            : base (0)
+            , mask (0)
+            , p (0)
+        {
+        }
+        const_iterator (const T *base, size_t mask, size_t p)
+            : base (base)
+            , mask (mask)
+            , p (p)
+        {
+        }
+        const T &operator* () const
+        {
+            return base[p & mask];
+        }
+        const T *operator-> () const
+        {
+            return base + (p & mask);
+        }
+        const_iterator &operator++ ()
+        {
+            --p;
+            return *this;
+        }
+        const_iterator operator++ (int)
+        {
+            const_iterator tmp (*this);
+            --p;
+            return tmp;
+        }
+        bool operator== (const const_iterator &j) const
+        {
+            return p == j.p;
+        }
+        bool operator!= (const const_iterator &j) const
+        {
+            return p != j.p;
+        }
+    };
     private:
     /// @brief window duration
     uint64_t duration;
-    /// @brief two deque add/remove in lock-step
-    std::deque<uint64_t> timestamps;
-    std::deque<T> samples;
+    /// @brief the ring, timestamps and samples at the same positions
+    std::vector<uint64_t> timestamps;
+    std::vector<T> samples;
+    /// @brief capacity - 1
+    size_t mask;
+    /// @brief where the next sample goes
+    size_t head;
+    /// @brief number of samples in the window
+    size_t count;
+    /// @brief ring position of the i'th newest sample
+    size_t position (size_t i) const
+    {
+        assert (i < count);
+        return (head - 1 - i) & mask;
+    }
+    /// @brief ring position of the oldest sample
+    size_t tail () const
+    {
+        return (head - count) & mask;
+    }
+    /// @brief double the capacity, moving the samples so the oldest is first
+    void grow ()
+    {
+        const size_t n = samples.size ();
+        std::vector<uint64_t> t (2 * n);
+        std::vector<T> s (2 * n);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const size_t j = (tail () + i) & mask;
+            t[i] = timestamps[j];
+            s[i] = samples[j];
+        }
+        timestamps.swap (t);
+        samples.swap (s);
+        mask = 2 * n - 1;
+        head = count;
+    }
+    /// @brief the number of oldest samples whose timestamps are at least duration before ts
+    size_t expired (uint64_t ts) const
+    {
+        // usually there are none or one, so look at the oldest two before searching
+        const size_t t = tail ();
+        size_t n = 0;
+        for (; n < count && n < 2; ++n)
+        {
+            assert (ts >= timestamps[(t + n) & mask]);
+            if (ts - timestamps[(t + n) & mask] < duration)
+                return n;
+        }
+        // the timestamps go up from oldest to newest, so the expired ones come first
+        size_t hi = count;
+        while (n < hi)
+        {
+            const size_t mid = n + (hi - n) / 2;
+            if (ts - timestamps[(t + mid) & mask] >= duration)
+                n = mid + 1;
+            else
+                hi = mid;
+        }
+        return n;
+    }
     public:
     /// @brief constructor
     ///
     /// @param duration duration of the window in useconds
-    sliding_window (uint64_t duration)
+    /// @param max_fps highest frame rate the window needs to hold without growing
+    sliding_window (uint64_t duration, int max_fps = DEFAULT_MAX_FPS)
         : duration (duration)
+        , mask (0)
+        , head (0)
+        , count (0)
     {
+        assert (max_fps > 0);
+        // one more than the most samples a window can hold, since the newest is added before the oldest leave
+        const uint64_t n = duration * max_fps / 1000000 + 2;
+        size_t c = 1;
+        while (c < n)
+            c *= 2;
+        timestamps.resize (c);
+        samples.resize (c);
+        mask = c - 1;
     }
     /// @brief size of container
     ///
     /// @return the size
     size_t size () const
+    {
+        return count;
+    }
+    /// @brief number of samples the window can hold before it has to grow
+    size_t capacity () const
     {
         return samples.size ();
     }
@@ -57,17 +198,44 @@ class sliding_window
     /// @return 0.0 for empty, 1.0 for full
     float fullness (uint64_t ts) const
     {
-        if (timestamps.empty ())
+        if (count == 0)
             return 0.0;
-        assert (ts >= timestamps.back ());
-        return static_cast<float> (ts - timestamps.back ()) / duration;
+        assert (ts >= timestamps[tail ()]);
+        return static_cast<float> (ts - timestamps[tail ()]) / duration;
+    }
+    /// @brief sample access
+    ///
+    /// @param i 0 for the newest sample, size () - 1 for the oldest
+    const T &operator[] (size_t i) const
+    {
+        return samples[position (i)];
+    }
+    /// @brief the newest sample
+    const T &front () const
+    {
+        return (*this)[0];
+    }
+    /// @brief the oldest sample
+    const T &back () const
+    {
+        return (*this)[count - 1];
+    }
+    /// @brief first sample, the newest
+    const_iterator begin () const
+    {
+        return const_iterator (samples.data (), mask, head - 1);
+    }
+    /// @brief one past the last sample, the oldest
+    const_iterator end () const
+    {
+        return const_iterator (samples.data (), mask, head - 1 - count);
     }
     /// @brief container access
     ///
-    /// @return sliding window container
-    const std::deque<T> &get_samples () const
+    /// @return the samples, newest first
+    const sliding_window &get_samples () const
     {
-        return samples;
+        return *this;
     }
     /// @brief set the window duration
     ///
@@ -79,8 +247,7 @@ class sliding_window
     /// @brief remove all samples from the window
     void clear ()
     {
-        timestamps.clear ();
-        samples.clear ();
+        head = count = 0;
     }
     /// @brief add a sample
     ///
@@ -91,28 +258,24 @@ class sliding_window
     template<typename U>
     void add (uint64_t ts, const T &s, U &obs)
     {
-        assert (timestamps.size () == samples.size ());
+        if (count == samples.size ())
+            grow ();
         // add it
-        timestamps.push_front (ts);
-        samples.push_front (s);
+        timestamps[head] = ts;
+        samples[head] = s;
+        head = (head + 1) & mask;
+        ++count;
         // signal it was added
         obs.add (s);
-        // remove samples with old timestamps
-        while (!samples.empty ())
+        // remove samples with old timestamps all at once, only visiting them if someone is watching
+        const size_t n = expired (ts);
+        if (!std::is_same<U, do_nothing>::value)
         {
-            assert (ts >= timestamps.back ());
-            // any more old samples?
-            if (ts - timestamps.back () >= duration)
-            {
-                // signal it was removed
-                obs.remove (samples.back ());
-                // remove it
-                timestamps.pop_back ();
-                samples.pop_back ();
-            }
-            else
-                break;
+            const size_t t = tail ();
+            for (size_t i = 0; i < n; ++i)
+                obs.remove (samples[(t + i) & mask]);
         }
+        count -= n;
     }
     /// @brief add a sample
     ///
@@ -125,6 +288,115 @@ class sliding_window
     }
 };
 
+/// @brief A sliding window of samples with several channels that share timestamps
+///
+/// Each sample holds a value for every channel, so there is one timestamp per sample instead of one per channel,
+/// and one pass over the timestamps evicts old samples from every channel.  Each channel has its own observer.
+///
+/// @tparam T value type
+/// @tparam N number of channels
+template<typename T, size_t N>
+class multi_sliding_window
+{
+    public:
+    /// @brief a value for each channel
+    typedef std::array<T, N> sample;
+    typedef typename sliding_window<sample>::const_iterator const_iterator;
+    private:
+    /// @brief pass each channel's values to its own observer
+    template<typename U>
+    struct channel_observers
+    {
+        std::array<U, N> &obs;
+        void add (const sample &s)
+        {
+            for (size_t i = 0; i < N; ++i)
+                obs[i].add (s[i]);
+        }
+        void remove (const sample &s)
+        {
+            for (size_t i = 0; i < N; ++i)
+                obs[i].remove (s[i]);
+        }
+    };
+    sliding_window<sample> w;
+    public:
+    /// @brief constructor
+    ///
+    /// @param duration duration of the window in useconds
+    /// @param max_fps highest frame rate the window needs to hold without growing
+    multi_sliding_window (uint64_t duration, int max_fps = sliding_window<sample>::DEFAULT_MAX_FPS)
+        : w (duration, max_fps)
+    {
+    }
+    /// @brief size of container
+    size_t size () const
+    {
+        return w.size ();
+    }
+    /// @brief number of samples the window can hold before it has to grow
+    size_t capacity () const
+    {
+        return w.capacity ();
+    }
+    /// @brief indicates how full the buffer is
+    ///
+    /// @return 0.0 for empty, 1.0 for full
+    float fullness (uint64_t ts) const
+    {
+        return w.fullness (ts);
+    }
+    /// @brief sample access
+    ///
+    /// @param i 0 for the newest sample, size () - 1 for the oldest
+    const sample &operator[] (size_t i) const
+    {
+        return w[i];
+    }
+    /// @brief first sample, the newest
+    const_iterator begin () const
+    {
+        return w.begin ();
+    }
+    /// @brief one past the last sample, the oldest
+    const_iterator end () const
+    {
+        return w.end ();
+    }
+    /// @brief set the window duration
+    ///
+    /// @param d
+    void set_duration (uint64_t d)
+    {
+        w.set_duration (d);
+    }
+    /// @brief remove all samples from the window
+    void clear ()
+    {
+        w.clear ();
+    }
+    /// @brief add a sample
+    ///
+    /// @tparam U observer type
+    /// @param ts timestamp in useconds
+    /// @param s the sample
+    /// @param obs an observer for each channel
+    template<typename U>
+    void add (uint64_t ts, const sample &s, std::array<U, N> &obs)
+    {
+        channel_observers<U> c = { obs };
+        w.add (ts, s, c);
+    }
+    /// @brief add a sample
+    ///
+    /// @param ts timestamp in useconds
+    /// @param s the sample
+    void add (uint64_t ts, const sample &s)
+    {
+        w.add (ts, s);
+    }
+};
+
 }
 
 #endif
@@ -0,0 +1,342 @@
+/// @file sliding_window_benchmark.cc
+/// @brief compare the ring buffer sliding_window with the deque version it replaced, and separate windows with
+/// one multi-channel window, min/max rescans and median sorts with running_range and running_median, and the
+/// running_mode that walked its distribution with the bucketed ones
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-13
+
+#include "mouse_pointer.h"
+#include "sliding_window.h"
+#include "stats.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: sliding_window_benchmark [frames [fps]]";
+
+/// @brief the sliding_window that kept its timestamps and samples in two deques
+template<typename T>
+class deque_sliding_window
+{
+    private:
+    uint64_t duration;
+    std::deque<uint64_t> timestamps;
+    std::deque<T> samples;
+    public:
+    deque_sliding_window (uint64_t duration)
+        : duration (duration)
+    {
+    }
+    size_t size () const
+    {
+        return samples.size ();
+    }
+    const std::deque<T> &get_samples () const
+    {
+        return samples;
+    }
+    template<typename U>
+    void add (uint64_t ts, const T &s, U &obs)
+    {
+        timestamps.push_front (ts);
+        samples.push_front (s);
+        obs.add (s);
+        while (!samples.empty () && ts - timestamps.back () >= duration)
+        {
+            obs.remove (samples.back ());
+            timestamps.pop_back ();
+            samples.pop_back ();
+        }
+    }
+};
+
+/// @brief the running_mode that walked its whole distribution when the mode was removed
+class map_running_mode
+{
+    private:
+    std::map<int,size_t> d;
+    int m;
+    size_t count;
+    public:
+    map_running_mode ()
+        : m (0)
+        , count (0)
+    {
+    }
+    void add (const int x)
+    {
+        ++d[x];
+        if (d[x] > count)
+        {
+            m = x;
+            count = d[x];
+        }
+    }
+    void remove (const int x)
+    {
+        auto i = d.find (x);
+        if (--i->second == 0)
+            d.erase (i);
+        if (m == x)
+        {
+            --count;
+            for (auto i : d)
+            {
+                if (i.second > count)
+                {
+                    m = i.first;
+                    count = i.second;
+                }
+            }
+            if (count == 0)
+                m = 0;
+        }
+    }
+    int get_mode () const
+    {
+        return m;
+    }
+};
+
+/// @brief add samples to a window, then walk the window, and report the time per frame
+///
+/// @tparam W window type
+/// @tparam T sample type
+/// @tparam U observer type
+template<typename W, typename T, typename U>
+double run (W &w, U &obs, const vector<uint64_t> &ts, const vector<T> &x)
+{
+    T sum = T ();
+    auto start = chrono::steady_clock::now ();
+    for (size_t i = 0; i < ts.size (); ++i)
+    {
+        w.add (ts[i], x[i], obs);
+        for (auto j : w.get_samples ())
+            sum += j;
+    }
+    const double secs = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+    // so the loop can't be optimized away
+    if (sum == T (-1))
+        clog << sum << endl;
+    return secs * 1e9 / ts.size ();
+}
+
+template<typename T, typename U>
+void compare (const string &name, uint64_t duration, const vector<uint64_t> &ts, const vector<T> &x)
+{
+    U a;
+    deque_sliding_window<T> d (duration);
+    const double dt = run (d, a, ts, x);
+    U b;
+    sliding_window<T> r (duration);
+    const double rt = run (r, b, ts, x);
+    clog << name << "\t" << duration / 1000 << "ms\t"
+        << dt << "ns deque\t"
+        << rt << "ns ring\t"
+        << dt / rt << "x" << endl;
+}
+
+/// @brief time x and y in two windows against x and y in one two channel window
+void compare_channels (const string &name, uint64_t duration, const vector<uint64_t> &ts, const vector<double> &x)
+{
+    double sum = 0.0;
+    auto start = chrono::steady_clock::now ();
+    {
+        sliding_window<double> wx (duration);
+        sliding_window<double> wy (duration);
+        running_mean mx;
+        running_mean my;
+        for (size_t i = 0; i < ts.size (); ++i)
+        {
+            wx.add (ts[i], x[i], mx);
+            wy.add (ts[i], -x[i], my);
+            sum += mx.get_mean () + my.get_mean ();
+        }
+    }
+    const double st = chrono::duration<double> (chrono::steady_clock::now () - start).count () * 1e9 / ts.size ();
+    start = chrono::steady_clock::now ();
+    {
+        multi_sliding_window<double, 2> w (duration);
+        array<running_mean, 2> m;
+        for (size_t i = 0; i < ts.size (); ++i)
+        {
+            const array<double, 2> p = {{ x[i], -x[i] }};
+            w.add (ts[i], p, m);
+            sum += m[0].get_mean () + m[1].get_mean ();
+        }
+    }
+    const double mt = chrono::duration<double> (chrono::steady_clock::now () - start).count () * 1e9 / ts.size ();
+    // so the loops can't be optimized away
+    if (sum == -1.0)
+        clog << sum << endl;
+    clog << name << "\t" << duration / 1000 << "ms\t"
+        << st << "ns 2 windows\t"
+        << mt << "ns 2 channels\t"
+        << st / mt << "x" << endl;
+}
+
+/// @brief time the range of a window found by rescanning it against the range kept by running_range
+void compare_range (const string &name, uint64_t duration, const vector<uint64_t> &ts, const vector<double> &x)
+{
+    double sum = 0.0;
+    auto start = chrono::steady_clock::now ();
+    {
+        sliding_window<double> w (duration);
+        for (size_t i = 0; i < ts.size (); ++i)
+        {
+            w.add (ts[i], x[i]);
+            const auto m = minmax_element (w.begin (), w.end ());
+            sum += *m.second - *m.first;
+        }
+    }
+    const double st = chrono::duration<double> (chrono::steady_clock::now () - start).count () * 1e9 / ts.size ();
+    start = chrono::steady_clock::now ();
+    {
+        sliding_window<double> w (duration);
+        running_range<double> r;
+        for (size_t i = 0; i < ts.size (); ++i)
+        {
+            w.add (ts[i], x[i], r);
+            sum += r.get_range ();
+        }
+    }
+    const double rt = chrono::duration<double> (chrono::steady_clock::now () - start).count () * 1e9 / ts.size ();
+    // so the loops can't be optimized away
+    if (sum == -1.0)
+        clog << sum << endl;
+    clog << name << "\t" << duration / 1000 << "ms\t"
+        << st << "ns rescan\t"
+        << rt << "ns running_range\t"
+        << st / rt << "x" << endl;
+}
+
+/// @brief time the median of a window found by sorting a copy of it against the median kept by running_median
+void compare_median (const string &name, uint64_t duration, const vector<uint64_t> &ts, const vector<double> &x)
+{
+    double sum = 0.0;
+    auto start = chrono::steady_clock::now ();
+    {
+        sliding_window<double> w (duration);
+        vector<double> v;
+        for (size_t i = 0; i < ts.size (); ++i)
+        {
+            w.add (ts[i], x[i]);
+            v.assign (w.begin (), w.end ());
+            sort (v.begin (), v.end ());
+            const size_t n = v.size ();
+            sum += n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+        }
+    }
+    const double st = chrono::duration<double> (chrono::steady_clock::now () - start).count () * 1e9 / ts.size ();
+    start = chrono::steady_clock::now ();
+    {
+        sliding_window<double> w (duration);
+        running_median m;
+        for (size_t i = 0; i < ts.size (); ++i)
+        {
+            w.add (ts[i], x[i], m);
+            sum += m.get_median ();
+        }
+    }
+    const double mt = chrono::duration<double> (chrono::steady_clock::now () - start).count () * 1e9 / ts.size ();
+    // so the loops can't be optimized away
+    if (sum == -1.0)
+        clog << sum << endl;
+    clog << name << "\t" << duration / 1000 << "ms\t"
+        << st << "ns sort\t"
+        << mt << "ns running_median\t"
+        << st / mt << "x" << endl;
+}
+
+/// @brief time a mode observer
+template<typename U>
+double run_mode (uint64_t duration, const vector<uint64_t> &ts, const vector<int> &x)
+{
+    sliding_window<int> w (duration);
+    U m;
+    int sum = 0;
+    auto start = chrono::steady_clock::now ();
+    for (size_t i = 0; i < ts.size (); ++i)
+    {
+        w.add (ts[i], x[i], m);
+        sum += m.get_mode ();
+    }
+    const double secs = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+    // so the loop can't be optimized away
+    if (sum == -1)
+        clog << sum << endl;
+    return secs * 1e9 / ts.size ();
+}
+
+int main (int argc, char **argv)
+{
+    try
+    {
+        if (argc > 3)
+            throw runtime_error (usage);
+
+        const size_t N = argc > 1 ? atol (argv[1]) : 1000000;
+        const double fps = argc > 2 ? atof (argv[2]) : 115.0;
+        if (fps <= 0.0)
+            throw runtime_error (usage);
+
+        vector<uint64_t> ts (N);
+        vector<double> x (N);
+        vector<int> n (N);
+        vector<int> ids (N);
+        for (size_t i = 0; i < N; ++i)
+        {
+            ts[i] = i * 1000000 / fps;
+            x[i] = i % 100;
+            n[i] = i % 5;
+            // finger ids, that keep going up as fingers come and go
+            ids[i] = i / 7 + i % 3;
+        }
+
+        // the windows, and the observers, that the pipeline uses: the pointer smoother, the scroller, and the
+        // finger counter in soma_mouse's hand shape classifiers
+        const uint64_t POINTER_DURATION = pointer_smoother::DURATION;
+        const uint64_t SCROLLER_DURATION = 50000;
+        const uint64_t COUNTER_DURATION = 200000;
+        clog << N << " frames at " << fps << "fps, time per frame" << endl;
+        compare<double, running_mean> ("mouse_pointer", POINTER_DURATION, ts, x);
+        compare<double, running_mean> ("mouse_scroller", SCROLLER_DURATION, ts, x);
+        compare<int, running_mode> ("finger_counter", COUNTER_DURATION, ts, n);
+        compare_channels ("pointer_smoother", POINTER_DURATION, ts, x);
+        compare_range ("finger_distance", POINTER_DURATION, ts, x);
+        compare_range ("finger_distance", 1000000, ts, x);
+        compare_median ("mouse_pointer", POINTER_DURATION, ts, x);
+        compare_median ("mouse_pointer", 1000000, ts, x);
+        {
+            const double mt = run_mode<map_running_mode> (COUNTER_DURATION, ts, n);
+            const double rt = run_mode<running_mode> (COUNTER_DURATION, ts, n);
+            const double bt = run_mode<bounded_running_mode<hand_sample::MAX_FINGERS + 1>> (COUNTER_DURATION, ts, n);
+            clog << "finger_counter\t" << COUNTER_DURATION / 1000 << "ms\t"
+                << mt << "ns map\t"
+                << rt << "ns running_mode\t"
+                << bt << "ns bounded_running_mode\t"
+                << mt / bt << "x" << endl;
+        }
+        {
+            const double mt = run_mode<map_running_mode> (COUNTER_DURATION, ts, ids);
+            const double rt = run_mode<running_mode> (COUNTER_DURATION, ts, ids);
+            clog << "finger_id_tracker\t" << COUNTER_DURATION / 1000 << "ms\t"
+                << mt << "ns map\t"
+                << rt << "ns running_mode\t"
+                << mt / rt << "x" << endl;
+        }
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -7,18 +7,36 @@
 #ifndef SOMA_H
 #define SOMA_H
 
+#include "clock_mapper.h"
+#include "event_diff.h"
+#include "event_log.h"
+#include "event_loop.h"
 #include "finger_counter.h"
 #include "finger_id_tracker.h"
+#include "flight_recorder.h"
 #include "frame_counter.h"
+#include "frame_features.h"
+#include "frame_gaps.h"
+#include "frame_source.h"
+#include "fused_frame_source.h"
 #include "hand_sample.h"
 #include "hand_shape_classifier.h"
+#include "hand_tracker.h"
 #include "hand_traits.h"
+#include "idle_detector.h"
 #include "keyboard.h"
+#include "latency_monitor.h"
 #include "mouse.h"
 #include "mouse_clicker.h"
 #include "mouse_scroller.h"
 #include "mouse_pointer.h"
+#include "notifier.h"
 #include "point_delta.h"
+#include "recording.h"
+#include "recording_codec.h"
+#include "recording_tee.h"
+#include "sample_filter.h"
+#include "session_store.h"
 #include "sliding_window.h"
 #include "stats.h"
 #include "time_guard.h"
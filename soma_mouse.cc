@@ -4,17 +4,21 @@
 /// @version 1.0
 /// @date 2013-08-30
 
+#include "async_frame_listener.h"
+#include "event_loop.h"
+#include "frame_sources.h"
 #include "soma_mouse.h"
+#include <cstring>
 
 using namespace std;
 using namespace soma;
-const string usage = "usage: soma_mouse";
+const string usage = "usage: soma_mouse " + frame_source_usage;
 
 int main (int argc, char **argv)
 {
     try
     {
-        if (argc != 1)
+        if (!valid_frame_source_args (argc - 1, argv + 1))
             throw runtime_error (usage);
 
         // options get saved here
@@ -43,22 +47,44 @@ int main (int argc, char **argv)
                 read (opts, config_fn);
         }
 
+        // signals are blocked in every thread started after this, so the recording tee, the frame listener and the
+        // frame source threads are created after the event loop
+        event_loop loop;
+
         soma_mouse sm (opts);
-        Leap::Controller c (sm);
+        if (sm.get_flight_recorder ())
+        {
+            sm.get_flight_recorder ()->install_signal_handlers ();
+            clog << "kill -USR1 " << getpid () << " dumps the last "
+                << opts.get_flight_seconds () << " seconds to " << get_config_dir () << endl;
+        }
+        // process frames on their own thread so the frame source is never held up
+        async_frame_listener async (sm);
+        // while the mouse is idle, empty frames don't need to wake the processing thread
+        async.set_can_wait ([&sm] (const frame &f) { return sm.can_wait (f); });
+        unique_ptr<frame_source> src = make_frame_source (argc - 1, argv + 1);
+        // a replay can wait for the pipeline to catch up instead of losing frames
+        async.set_wait_for_room (!src->is_live ());
+        loop.quit_when (sm.get_done ());
+        loop.quit_when (src->get_done ());
+        src->start (async);
 
-        clog << "7 fingers = quit" << endl;
+        clog << "two open hands = quit" << endl;
 
-        // receive frames even when you don't have focus
-        c.setPolicyFlags (Leap::Controller::POLICY_BACKGROUND_FRAMES);
+        // sleep until the user quits, the source runs out of frames, or a signal arrives
+        loop.run ();
+        if (loop.get_signal ())
+            clog << strsignal (loop.get_signal ()) << endl;
 
-        // loop
-        while (!sm.is_done ())
-            usleep (5000);
+        src->stop ();
+        async.stop ();
+        print_stats (clog, async);
+        const fused_frame_source *fused = dynamic_cast<const fused_frame_source *> (src.get ());
+        if (fused)
+            print_stats (clog, *fused);
 
         clog << "done" << endl;
 
-        usleep (1000000);
-
         return 0;
     }
     catch (const exception &e)
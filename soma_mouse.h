@@ -9,29 +9,96 @@
 
 /// @brief version info
 const int MAJOR_REVISION = 0;
-const int MINOR_REVISION = 1;
+const int MINOR_REVISION = 6;
 
+#include "event_log.h"
+#include "flight_recorder.h"
+#include "frame_gaps.h"
+#include "frame_source.h"
+#include "hand_tracker.h"
+#include "idle_detector.h"
+#include "latency_monitor.h"
 #include "options.h"
+#include "recording_tee.h"
+#include "sample_filter.h"
 #include "soma.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <ctime>
+#include <string>
 #include <unistd.h>
 
 namespace soma
 {
 
-class soma_mouse : public Leap::Listener
+/// @brief decide when the flight recorder dumps on its own
+///
+/// @param name none, or click for any left or right button press
+///
+/// @return the trigger
+std::function<bool (const flight_record &)> make_flight_trigger (const std::string &name)
+{
+    if (name == "none")
+        return std::function<bool (const flight_record &)> ();
+    if (name == "click")
+        return [] (const flight_record &r)
+        {
+            for (size_t i = 0; i < r.nevents && i < flight_record::MAX_EVENTS; ++i)
+                if (r.events[i].type == mouse_event_type::button && r.events[i].down
+                    && (r.events[i].button == 1 || r.events[i].button == 3))
+                    return true;
+            return false;
+        };
+    throw std::runtime_error ("unknown flight recorder trigger: " + name);
+}
+
+class soma_mouse : public frame_listener
 {
     private:
     static const uint64_t CENTER_DELAY_DURATION = 500000;
-    bool done;
+    /// @brief how long a hand keeps its classifier, and keeps the pointer, after it goes out of view
+    static const uint64_t HAND_LINGER_DURATION = 500000;
+    /// @brief how far back a hand's samples go when checking its finger count and ids
+    static const uint64_t SAMPLE_FILTER_DURATION = 100000;
+    /// @brief how often dropped frames are reported, in useconds
+    static const uint64_t GAP_REPORT_INTERVAL = 10000000;
+    /// @brief screen size of a headless mouse, fixed so replays give the same events on any machine
+    static const int HEADLESS_WIDTH = 1920;
+    static const int HEADLESS_HEIGHT = 1080;
+    /// @brief what is kept for each hand
+    struct hand_state
+    {
+        hand_shape_classifier hsc;
+        sample_filter sf;
+        hand_state ()
+            : hsc (200000)
+            , sf (SAMPLE_FILTER_DURATION)
+        {
+        }
+    };
+    done_flag done;
     const options &opts;
-    hand_shape_classifier hsc;
-    mouse m;
+    hand_tracker<hand_state> hands;
+    std::unique_ptr<flight_recorder> fr;
+    std::unique_ptr<recording_tee> tee;
+    std::unique_ptr<event_log_observer> el;
+    latency_monitor lm;
+    std::unique_ptr<mouse> m;
     mouse_pointer mp;
     mouse_clicker mc;
     mouse_scroller ms;
     frame_counter fc;
+    frame_gap_detector gaps;
+    idle_detector idle;
+    /// @brief set while frames without fingers are being skipped, read on the frame source's thread
+    std::atomic<bool> is_idle;
+    /// @brief the last frame that went through the pipeline
+    frame last;
+    uint64_t last_report_ts;
+    uint64_t last_report_lost;
     time_guard is_centering;
-    void update (uint64_t ts, const hand_shape shape, const hand_sample &s)
+    void update (uint64_t ts, const hand_shape shape, const frame_features &ff)
     {
         // if we are centering
         if (is_centering.is_on (ts))
@@ -54,18 +121,13 @@ class soma_mouse : public Leap::Listener
                     mc.left_click (ts);
                     return;
                 }
-                mp.update (ts, s);
+                mp.update (ts, ff);
             }
             break;
             case hand_shape::scrolling:
             {
-                if (s.size () == 3)
-                {
-                    // thumb on left
-                    hand_sample tmp (s);
-                    sort (tmp.begin (), tmp.end (), sort_left_to_right);
-                    ms.update (ts, tmp[0].position, tmp[1].position);
-                }
+                if (ff.size () == 3)
+                    ms.update (ts, ff);
                 mp.clear ();
             }
             return;
@@ -77,45 +139,202 @@ class soma_mouse : public Leap::Listener
             return;
         }
     }
+    /// @brief run a frame through the pipeline
+    void process (const frame &f)
+    {
+        const uint64_t ts = f.ts;
+        lm.begin (f);
+        if (fr)
+            fr->begin (f);
+        if (el)
+            el->begin (f.ts, f.id);
+        // each hand has its own classifier, so a second hand can't change the first hand's finger count
+        hand h[MAX_SPLIT_HANDS];
+        hand_sample s[MAX_SPLIT_HANDS];
+        const size_t n = split_hands (f, h, s);
+        const int d = hands.update (ts, h, n);
+        size_t open = 0;
+        bool good[MAX_SPLIT_HANDS];
+        for (size_t i = 0; i < n; ++i)
+        {
+            hand_state &hs = hands.get (h[i].id);
+            hs.hsc.add (ts, s[i]);
+            if (hs.hsc.get_count () >= 4)
+                ++open;
+            good[i] = hs.sf.update (ts, s[i]);
+        }
+        // quit?  both hands open, or more than 6 fingers if the source doesn't know about hands
+        if (open == 2 || (!f.has_hands && f.s.size () > 6))
+            done.set ();
+        else if (d == -1)
+        {
+            // the pointer hand is out of view for now
+            mp.clear ();
+        }
+        else
+        {
+            // don't let the pointer jump when a different hand takes over
+            if (hands.has_changed ())
+                mp.clear ();
+            // a sample whose finger count or ids disagree with the last few samples is a tracking glitch, so it
+            // doesn't get to move the mouse
+            if (good[d])
+            {
+                // everyone shares the same per frame features
+                frame_features ff (s[d]);
+                // update the mouse
+                update (ts, hands.get (h[d].id).hsc.get_shape (), ff);
+            }
+        }
+        if (fr)
+        {
+            hand_shape shape = hand_shape::unknown;
+            int count = -1;
+            if (d != -1)
+            {
+                shape = hands.get (h[d].id).hsc.get_shape ();
+                count = hands.get (h[d].id).hsc.get_count ();
+            }
+            fr->set_state (static_cast<int> (shape), count, mc.get_pinch_detector ().get_state ());
+            fr->end ();
+        }
+    }
+    /// @brief say how many frames have gone missing, if any more have since the last report
+    void report_gaps (uint64_t ts)
+    {
+        if (ts - last_report_ts < GAP_REPORT_INTERVAL)
+            return;
+        last_report_ts = ts;
+        const uint64_t lost = gaps.get_dropped () + gaps.get_duplicates () + gaps.get_out_of_order ();
+        if (lost == last_report_lost)
+            return;
+        last_report_lost = lost;
+        std::clog << fc.fps () << "fps, ";
+        print_stats (std::clog, gaps);
+    }
     public:
-    soma_mouse (const options &opts)
-        : done (false)
-        , opts (opts)
-        , hsc (200000)
-        , mp (m, opts.get_mouse_speed ())
-        , mc (m)
-        , ms (m)
+    /// @brief constructor
+    ///
+    /// @param opts options
+    /// @param headless if true, the mouse and keyboard aren't touched, see mouse
+    soma_mouse (const options &opts, bool headless = false)
+        : opts (opts)
+        , hands (hand_state (), HAND_LINGER_DURATION, to_hand_policy (opts.get_pointer_hand ()))
+        , m (headless ? new mouse (HEADLESS_WIDTH, HEADLESS_HEIGHT) : new mouse ())
+        , mp (*m, opts.get_mouse_speed ())
+        , mc (*m)
+        , ms (*m)
+        , idle (static_cast<uint64_t> (std::max (0.0, opts.get_idle_seconds ()) * 1000000))
+        , is_idle (false)
+        , last_report_ts (0)
+        , last_report_lost (0)
     {
+        m->add_observer (&lm);
+        if (opts.get_flight_seconds () > 0.0)
+        {
+            fr.reset (new flight_recorder (opts.get_flight_seconds (), get_config_dir ()));
+            fr->set_trigger (make_flight_trigger (opts.get_flight_trigger ()));
+            m->add_observer (fr.get ());
+        }
+        if (opts.get_record ())
+        {
+            tee_parameters p;
+            p.max_file_bytes = opts.get_record_mb () * (1 << 20);
+            p.max_file_duration = opts.get_record_minutes () * 60 * 1000000;
+            const std::string prefix = get_config_dir () + "/session-" + std::to_string (time (0));
+            std::clog << "recording to " << prefix << "-*" << std::endl;
+            tee.reset (new recording_tee (prefix, p));
+            m->add_observer (tee.get ());
+        }
     }
     ~soma_mouse ()
     {
         std::clog << fc.fps () << "fps" << std::endl;
+        print_stats (std::clog, gaps);
+        print_stats (std::clog, idle);
+        print_stats (std::clog, lm);
+        if (tee)
+        {
+            tee->stop ();
+            print_stats (std::clog, *tee);
+        }
     }
-    bool is_done () const
+    /// @brief get the flag that is set when the user quits
+    done_flag &get_done ()
     {
         return done;
     }
-    virtual void onFrame (const Leap::Controller& c)
+    /// @brief get the flight recorder, 0 if it is turned off
+    flight_recorder *get_flight_recorder ()
     {
-        if (done)
+        return fr.get ();
+    }
+    /// @brief write each mouse event to an event log, with the frame it came from
+    ///
+    /// This must be called before frames start arriving.
+    ///
+    /// @param fn filename
+    void log_events (const std::string &fn)
+    {
+        assert (!el);
+        el.reset (new event_log_observer (fn));
+        m->add_observer (el.get ());
+    }
+    /// @brief get the event log, 0 if events aren't being logged
+    event_log_observer *get_event_log ()
+    {
+        return el.get ();
+    }
+    /// @brief true if a frame can wait to be processed, see async_frame_listener
+    ///
+    /// This is called on the frame source's thread.
+    ///
+    /// @param f the frame
+    bool can_wait (const frame &f) const
+    {
+        return is_idle && f.s.empty ();
+    }
+    virtual void on_frame (const frame &f)
+    {
+        if (done.is_set ())
+            return;
+        // repeated and late frames would send time backwards
+        const frame_status status = gaps.update (f);
+        if (status == frame_status::duplicate || status == frame_status::out_of_order)
             return;
-        // get the frame
-        Leap::Frame f = c.frame ();
-        uint64_t ts = f.timestamp ();
         // update frame counter
-        fc.update (ts);
-        // get the sample
-        hand_sample s (f.pointables ());
-        // quit?
-        if (s.size () > 6)
+        fc.update (f.ts);
+        report_gaps (f.ts);
+        if (tee)
+            tee->write (f);
+        // while nobody is there, looking for fingers is all there is to do
+        const bool skip = idle.update (f);
+        is_idle = idle.is_idle ();
+        if (skip)
         {
-            done = true;
+            last = f;
             return;
         }
-        // add it to the classifier
-        hsc.add (ts, s);
-        // update the mouse
-        update (ts, hsc.get_shape (), s);
+        // fill short gaps, so the pointer keeps moving instead of stalling and then jumping
+        const uint64_t missing = gaps.get_missing ();
+        if (status == frame_status::gap
+            && missing <= static_cast<uint64_t> (std::max (0, opts.get_fill_gaps ()))
+            && f.ts > last.ts + missing)
+        {
+            frame g;
+            for (uint64_t k = 1; k <= missing && !done.is_set (); ++k)
+            {
+                interpolate (last, f, k, missing, g);
+                process (g);
+            }
+        }
+        if (!done.is_set ())
+        {
+            const uint64_t cpu = thread_cpu_now ();
+            process (f);
+            idle.add_cost (f, thread_cpu_now () - cpu);
+        }
+        last = f;
     }
 };
 
@@ -0,0 +1,121 @@
+/// @file spsc_ring.h
+/// @brief lock-free single producer, single consumer ring buffer
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-28
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace soma
+{
+
+/// @brief a lock-free ring buffer with one producer thread and one consumer thread
+///
+/// The slots are allocated once, up front.  Elements are written and read in place, so after the slots have been
+/// filled once, a type like std::vector reuses the memory it already has.
+///
+/// @tparam T element type
+template<typename T>
+class spsc_ring
+{
+    private:
+    /// @brief keep the producer's and consumer's indexes on separate cache lines
+    static const size_t CACHE_LINE = 64;
+    std::vector<T> slots;
+    size_t mask;
+    char pad0[CACHE_LINE];
+    /// @brief next slot to write, only written by the producer
+    std::atomic<size_t> head;
+    char pad1[CACHE_LINE - sizeof (std::atomic<size_t>)];
+    /// @brief next slot to read, only written by the consumer
+    std::atomic<size_t> tail;
+    char pad2[CACHE_LINE - sizeof (std::atomic<size_t>)];
+    public:
+    /// @brief constructor
+    ///
+    /// @param capacity number of slots, must be a power of 2
+    spsc_ring (size_t capacity)
+        : slots (capacity)
+        , mask (capacity - 1)
+        , head (0)
+        , tail (0)
+    {
+        assert (capacity > 0);
+        assert ((capacity & mask) == 0);
+    }
+    /// @brief get the number of slots
+    size_t capacity () const
+    {
+        return slots.size ();
+    }
+    /// @brief get the number of elements in the ring
+    ///
+    /// This is exact only when called from the producer or consumer thread.
+    size_t size () const
+    {
+        return head.load (std::memory_order_acquire) - tail.load (std::memory_order_acquire);
+    }
+    /// @brief check if the ring is empty
+    bool empty () const
+    {
+        return size () == 0;
+    }
+    /// @brief producer: get the slot to write the next element into
+    ///
+    /// @return the slot, or 0 if the ring is full
+    T *prepare ()
+    {
+        const size_t h = head.load (std::memory_order_relaxed);
+        if (h - tail.load (std::memory_order_acquire) == slots.size ())
+            return 0;
+        return &slots[h & mask];
+    }
+    /// @brief producer: publish the slot returned by prepare ()
+    void commit ()
+    {
+        const size_t h = head.load (std::memory_order_relaxed);
+        assert (h - tail.load (std::memory_order_acquire) < slots.size ());
+        head.store (h + 1, std::memory_order_seq_cst);
+    }
+    /// @brief producer: copy an element into the ring
+    ///
+    /// @param x the element
+    ///
+    /// @return false if the ring is full
+    bool push (const T &x)
+    {
+        T *p = prepare ();
+        if (!p)
+            return false;
+        *p = x;
+        commit ();
+        return true;
+    }
+    /// @brief consumer: get the oldest element
+    ///
+    /// @return the element, or 0 if the ring is empty
+    T *front ()
+    {
+        const size_t t = tail.load (std::memory_order_relaxed);
+        if (head.load (std::memory_order_acquire) == t)
+            return 0;
+        return &slots[t & mask];
+    }
+    /// @brief consumer: release the element returned by front ()
+    void pop ()
+    {
+        const size_t t = tail.load (std::memory_order_relaxed);
+        assert (head.load (std::memory_order_acquire) != t);
+        tail.store (t + 1, std::memory_order_release);
+    }
+};
+
+}
+
+#endif
@@ -8,9 +8,19 @@
 #define STATS_H
 
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <numeric>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 namespace soma
 {
@@ -65,15 +75,18 @@ double variance (const T beg, const T end)
     size_t sz = end - beg;
     if (sz == 0)
         return 0.0;
-    double sum2 = 0.0;
-    double sum = 0.0;
+    // Welford's method, E[x^2]-E[x]^2 loses everything to cancellation when the mean is large compared to the
+    // spread, like positions far from the origin
+    double m = 0.0;
+    double m2 = 0.0;
+    size_t n = 0;
     for (T i = beg; i != end; ++i)
     {
-        sum2 += (*i * *i);
-        sum += *i;
+        const double d = *i - m;
+        m += d / ++n;
+        m2 += d * (*i - m);
     }
-    // var = E[x^2]-E[x]^2
-    return (sum2 / sz) - (sum / sz) * (sum / sz);
+    return m2 / sz;
 }
 
 /// @brief get the variance of a container of numbers
@@ -88,24 +101,74 @@ double variance (const T &x)
     return variance (x.begin (), x.end ());
 }
 
+/// @brief a sum that you can add and remove numbers from without the rounding errors piling up
+///
+/// Each addition's rounding error is kept in a second sum, using Neumaier's variant of Kahan summation, so the
+/// error stays about the same as one rounding no matter how many numbers went through it.
+class compensated_sum
+{
+    private:
+    double sum;
+    /// @brief the rounding errors
+    double c;
+    public:
+    /// @brief contructor
+    compensated_sum ()
+        : sum (0)
+        , c (0)
+    {
+    }
+    /// @brief reset to zero
+    void reset ()
+    {
+        sum = c = 0;
+    }
+    /// @brief add a number
+    ///
+    /// @param x number to add
+    void add (const double x)
+    {
+        const double t = sum + x;
+        // the low order bits of the smaller one were lost
+        if (std::fabs (sum) >= std::fabs (x))
+            c += (sum - t) + x;
+        else
+            c += (x - t) + sum;
+        sum = t;
+    }
+    /// @brief remove a number
+    ///
+    /// @param x number to remove
+    void remove (const double x)
+    {
+        add (-x);
+    }
+    /// @brief get the sum
+    double get_sum () const
+    {
+        return sum + c;
+    }
+};
+
 /// @brief keep a running sum and total that you can add and remove numbers from
+///
+/// The sum is compensated, and starts over when the last number is removed, so it doesn't drift over a long session.
 class running_mean
 {
     private:
     size_t total;
-    double sum;
+    compensated_sum sum;
     public:
     /// @brief contructor
     running_mean ()
         : total (0)
-        , sum (0)
     {
     }
     /// @brief reset to zero
     void reset ()
     {
         total = 0;
-        sum = 0;
+        sum.reset ();
     }
     /// @brief add a number to the running sum and total
     ///
@@ -113,7 +176,7 @@ class running_mean
     void add (const double x)
     {
         ++total;
-        sum += x;
+        sum.add (x);
     }
     /// @brief remove a number from the running sum and total
     ///
@@ -121,24 +184,128 @@ class running_mean
     void remove (const double x)
     {
         assert (total > 0);
-        --total;
-        sum -= x;
+        if (--total == 0)
+            sum.reset ();
+        else
+            sum.remove (x);
+    }
+    /// @brief start over from the numbers that are in the window
+    ///
+    /// @tparam T iterator type
+    /// @param beg first number
+    /// @param end one past the last number
+    template<typename T>
+    void recompute (const T beg, const T end)
+    {
+        reset ();
+        for (T i = beg; i != end; ++i)
+            add (*i);
     }
     /// @brief get the current mean
     ///
     /// @return the mean
     double get_mean () const
     {
-        return sum / total;
+        return sum.get_sum () / total;
+    }
+};
+
+/// @brief keep a running mean and variance that you can add and remove numbers from
+///
+/// Welford's method, run backwards to remove a number.  Updating the mean a little at a time lets its rounding
+/// errors wander, and every update of the sum of squares picks them up, so the mean comes from a compensated sum
+/// instead, and the sum of squares is compensated too.  Like variance (), the variance is the population variance.
+class running_variance
+{
+    private:
+    size_t total;
+    compensated_sum sum;
+    /// @brief sum of squared differences from the mean
+    compensated_sum m2;
+    public:
+    /// @brief contructor
+    running_variance ()
+        : total (0)
+    {
+    }
+    /// @brief reset to zero
+    void reset ()
+    {
+        total = 0;
+        sum.reset ();
+        m2.reset ();
+    }
+    /// @brief add a number
+    ///
+    /// @param x number to add
+    void add (const double x)
+    {
+        const double m = get_mean ();
+        ++total;
+        sum.add (x);
+        m2.add ((x - m) * (x - get_mean ()));
+    }
+    /// @brief remove a number
+    ///
+    /// @param x number to remove
+    void remove (const double x)
+    {
+        assert (total > 0);
+        if (--total == 0)
+        {
+            reset ();
+            return;
+        }
+        const double m = sum.get_sum () / (total + 1);
+        sum.remove (x);
+        m2.remove ((x - m) * (x - get_mean ()));
+    }
+    /// @brief start over from the numbers that are in the window
+    ///
+    /// @tparam T iterator type
+    /// @param beg first number
+    /// @param end one past the last number
+    template<typename T>
+    void recompute (const T beg, const T end)
+    {
+        reset ();
+        for (T i = beg; i != end; ++i)
+            add (*i);
+    }
+    /// @brief get the current mean
+    double get_mean () const
+    {
+        return total == 0 ? 0.0 : sum.get_sum () / total;
+    }
+    /// @brief get the current variance
+    double get_variance () const
+    {
+        // rounding can leave it a hair below zero when all the numbers left are the same
+        return total == 0 ? 0.0 : std::max (m2.get_sum (), 0.0) / total;
+    }
+    /// @brief get the current standard deviation
+    double get_stddev () const
+    {
+        return std::sqrt (get_variance ());
     }
 };
 
 /// @brief keep a running distribution that you can add and remove numbers from
+///
+/// Besides the count of each number, it keeps how many numbers have each count, so when the mode is removed it can
+/// tell in O(1) whether another number is tied with it, and only has to look through the distribution when one is.
+/// Numbers whose counts drop to zero are forgotten, so the distribution doesn't grow without bound when the numbers
+/// are ids.
+///
+/// When two numbers are tied for the mode, the mode doesn't change until its count drops, and then it goes to the
+/// smallest number that still has the old count.
 class running_mode
 {
     private:
     /// @brief the distribution
-    std::map<int,size_t> d;
+    std::unordered_map<int,size_t> d;
+    /// @brief n[c] is how many numbers have count c
+    std::vector<size_t> n;
     /// @brief the mode
     int m;
     /// @brief count of the mode
@@ -154,6 +321,7 @@ class running_mode
     void reset ()
     {
         d.clear ();
+        n.clear ();
         count = 0;
     }
     /// @brief add a number to the running distribution
@@ -162,12 +330,17 @@ class running_mode
     void add (const int x)
     {
         // update the distribution
-        ++d[x];
+        const size_t c = ++d[x];
+        if (n.size () <= c)
+            n.resize (c + 1);
+        if (c > 1)
+            --n[c - 1];
+        ++n[c];
         // if this count is greater than the mode's count, change the mode
-        if (d[x] > count)
+        if (c > count)
         {
             m = x;
-            count = d[x];
+            count = c;
         }
     }
     /// @brief remove a number from the running distribution
@@ -177,24 +350,116 @@ class running_mode
     {
         assert (!d.empty ());
         assert (count > 0);
-        assert (d[x] != 0);
-        // update the count
-        --d[x];
+        assert (d.find (x) != d.end ());
+        // update the count, forgetting numbers that are no longer in the distribution
+        auto i = d.find (x);
+        const size_t c = i->second;
+        --n[c];
+        if (--i->second == 0)
+            d.erase (i);
+        else
+            ++n[c - 1];
         // if this number was the mode, then the mode may have changed,
         // otherwise it could not have changed
         if (m == x)
         {
-            // x is the mode, so mode's count gets decremented
-            --count;
-            // check all counts
-            for (auto i : d)
+            assert (c == count);
+            if (n[c] != 0)
             {
-                if (i.second > count)
-                {
-                    m = i.first;
-                    count = i.second;
-                }
+                // another number had the same count, it becomes the mode
+                m = std::numeric_limits<int>::max ();
+                for (auto j : d)
+                    if (j.second == c && j.first < m)
+                        m = j.first;
             }
+            else
+            {
+                // x is still the mode
+                --count;
+            }
+            // set mode to some default when the dist is empty
+            if (count == 0)
+                m = 0;
+        }
+    }
+    /// @brief get the current mode
+    ///
+    /// @return the mode
+    int get_mode () const
+    {
+        return m;
+    }
+    /// @brief get the current mode's count
+    ///
+    /// @return the mode
+    int get_count () const
+    {
+        return count;
+    }
+};
+
+/// @brief a running_mode for numbers from 0 to N - 1
+///
+/// The distribution is an array, so nothing is allocated, and finding the next mode is a walk over N counts.  It
+/// picks the same mode as running_mode.
+///
+/// @tparam N one more than the largest number
+template<size_t N>
+class bounded_running_mode
+{
+    private:
+    /// @brief the distribution
+    std::array<size_t, N> d;
+    /// @brief the mode
+    int m;
+    /// @brief count of the mode
+    size_t count;
+    public:
+    /// @brief contructor
+    bounded_running_mode ()
+        : m (0)
+        , count (0)
+    {
+        d.fill (0);
+    }
+    /// @brief reset to zero
+    void reset ()
+    {
+        d.fill (0);
+        count = 0;
+    }
+    /// @brief add a number to the running distribution
+    ///
+    /// @param x number to add
+    void add (const int x)
+    {
+        assert (x >= 0 && static_cast<size_t> (x) < N);
+        const size_t c = ++d[x];
+        if (c > count)
+        {
+            m = x;
+            count = c;
+        }
+    }
+    /// @brief remove a number from the running distribution
+    ///
+    /// @param x number to remove
+    void remove (const int x)
+    {
+        assert (x >= 0 && static_cast<size_t> (x) < N);
+        assert (count > 0);
+        assert (d[x] > 0);
+        --d[x];
+        if (m == x)
+        {
+            // the smallest number that still has the old count, otherwise x is still the mode
+            size_t i = 0;
+            while (i < N && d[i] != count)
+                ++i;
+            if (i < N)
+                m = i;
+            else
+                --count;
             // set mode to some default when the dist is empty
             if (count == 0)
                 m = 0;
@@ -216,6 +481,348 @@ class running_mode
     }
 };
 
+/// @brief keep the extreme of a window of numbers that are removed in the same order they were added
+///
+/// Only numbers that could still become the extreme are kept: when a number is added, the numbers before it that
+/// it beats can never be the extreme again, since they will be removed before it is.  The kept numbers are then
+/// ordered from the extreme to the least extreme, and adding and removing are O(1) amortized.
+///
+/// @tparam T number type
+/// @tparam C comparison, std::less for the minimum, std::greater for the maximum
+template<typename T, typename C>
+class running_extreme
+{
+    private:
+    /// @brief the candidates, oldest and most extreme first
+    std::deque<T> d;
+    C before;
+    public:
+    /// @brief reset to empty
+    void reset ()
+    {
+        d.clear ();
+    }
+    /// @brief true if no numbers have been added
+    bool empty () const
+    {
+        return d.empty ();
+    }
+    /// @brief add a number
+    ///
+    /// @param x number to add
+    void add (const T x)
+    {
+        // equal numbers stay, so each one can be removed on its own
+        while (!d.empty () && before (x, d.back ()))
+            d.pop_back ();
+        d.push_back (x);
+    }
+    /// @brief remove the oldest number
+    ///
+    /// @param x number to remove
+    void remove (const T x)
+    {
+        assert (!d.empty ());
+        // if it isn't the extreme, it was already dropped when something more extreme was added
+        if (!before (d.front (), x))
+            d.pop_front ();
+    }
+    /// @brief get the current extreme
+    ///
+    /// @return the extreme, or 0 when empty
+    T get () const
+    {
+        return d.empty () ? T () : d.front ();
+    }
+};
+
+/// @brief keep a running minimum of a sliding window of numbers
+template<typename T = double>
+class running_min
+{
+    private:
+    running_extreme<T, std::less<T>> e;
+    public:
+    /// @brief reset to empty
+    void reset ()
+    {
+        e.reset ();
+    }
+    /// @brief add a number to the window
+    ///
+    /// @param x number to add
+    void add (const T x)
+    {
+        e.add (x);
+    }
+    /// @brief remove the oldest number from the window
+    ///
+    /// @param x number to remove
+    void remove (const T x)
+    {
+        e.remove (x);
+    }
+    /// @brief get the current minimum
+    ///
+    /// @return the minimum
+    T get_min () const
+    {
+        return e.get ();
+    }
+};
+
+/// @brief keep a running maximum of a sliding window of numbers
+template<typename T = double>
+class running_max
+{
+    private:
+    running_extreme<T, std::greater<T>> e;
+    public:
+    /// @brief reset to empty
+    void reset ()
+    {
+        e.reset ();
+    }
+    /// @brief add a number to the window
+    ///
+    /// @param x number to add
+    void add (const T x)
+    {
+        e.add (x);
+    }
+    /// @brief remove the oldest number from the window
+    ///
+    /// @param x number to remove
+    void remove (const T x)
+    {
+        e.remove (x);
+    }
+    /// @brief get the current maximum
+    ///
+    /// @return the maximum
+    T get_max () const
+    {
+        return e.get ();
+    }
+};
+
+/// @brief keep the running minimum and maximum of a sliding window of numbers
+///
+/// The range, max - min, bounds how much a value jittered over the window.
+template<typename T = double>
+class running_range
+{
+    private:
+    running_min<T> lo;
+    running_max<T> hi;
+    public:
+    /// @brief reset to empty
+    void reset ()
+    {
+        lo.reset ();
+        hi.reset ();
+    }
+    /// @brief add a number to the window
+    ///
+    /// @param x number to add
+    void add (const T x)
+    {
+        lo.add (x);
+        hi.add (x);
+    }
+    /// @brief remove the oldest number from the window
+    ///
+    /// @param x number to remove
+    void remove (const T x)
+    {
+        lo.remove (x);
+        hi.remove (x);
+    }
+    /// @brief get the current minimum
+    T get_min () const
+    {
+        return lo.get_min ();
+    }
+    /// @brief get the current maximum
+    T get_max () const
+    {
+        return hi.get_max ();
+    }
+    /// @brief get the current maximum - minimum
+    T get_range () const
+    {
+        return hi.get_max () - lo.get_min ();
+    }
+};
+
+/// @brief keep a running quantile of a window of numbers that you can add and remove numbers from
+///
+/// The numbers are kept sorted in a multiset, with an iterator to the one at the quantile's position, so adding and
+/// removing are O(log n) and the iterator only ever has to step over one or two numbers to catch up.  Between
+/// positions the quantile is interpolated, so the 0.5 quantile of an even count is the mean of the middle two.
+class running_quantile
+{
+    private:
+    /// @brief which quantile, between 0.0 and 1.0
+    double q;
+    /// @brief the numbers, sorted
+    std::multiset<double> s;
+    /// @brief the number at the quantile's position
+    std::multiset<double>::iterator i;
+    /// @brief the index of i
+    size_t pos;
+    /// @brief move i to the quantile's position
+    void update ()
+    {
+        if (s.empty ())
+            return;
+        const size_t k = static_cast<size_t> (q * (s.size () - 1));
+        for (; pos < k; ++pos)
+            ++i;
+        for (; pos > k; --pos)
+            --i;
+    }
+    public:
+    /// @brief contructor
+    ///
+    /// @param q which quantile, 0.5 for the median
+    running_quantile (const double q)
+        : q (q)
+        , i (s.end ())
+        , pos (0)
+    {
+        assert (q >= 0.0 && q <= 1.0);
+    }
+    /// @brief copy constructor, i has to point into our own copy of the numbers
+    running_quantile (const running_quantile &r)
+        : q (r.q)
+        , s (r.s)
+        , i (s.begin ())
+        , pos (r.pos)
+    {
+        std::advance (i, s.empty () ? 0 : pos);
+    }
+    /// @brief assignment
+    running_quantile &operator= (const running_quantile &r)
+    {
+        q = r.q;
+        s = r.s;
+        pos = r.pos;
+        i = s.begin ();
+        std::advance (i, s.empty () ? 0 : pos);
+        return *this;
+    }
+    /// @brief reset to empty
+    void reset ()
+    {
+        s.clear ();
+        i = s.end ();
+        pos = 0;
+    }
+    /// @brief add a number to the window
+    ///
+    /// @param x number to add
+    void add (const double x)
+    {
+        if (s.empty ())
+        {
+            i = s.insert (x);
+            pos = 0;
+            return;
+        }
+        // equal numbers go after the ones already there, so they don't move i
+        s.insert (x);
+        if (x < *i)
+            ++pos;
+        update ();
+    }
+    /// @brief remove a number from the window
+    ///
+    /// @param x number to remove
+    void remove (const double x)
+    {
+        assert (!s.empty ());
+        assert (s.find (x) != s.end ());
+        if (x < *i)
+        {
+            s.erase (s.find (x));
+            --pos;
+        }
+        else if (*i < x)
+        {
+            s.erase (s.find (x));
+        }
+        else
+        {
+            // remove the one i points to, the next one takes its place
+            i = s.erase (i);
+            if (i == s.end () && !s.empty ())
+            {
+                --i;
+                --pos;
+            }
+        }
+        update ();
+    }
+    /// @brief get the current quantile
+    ///
+    /// @return the quantile, or 0 when empty
+    double get_quantile () const
+    {
+        if (s.empty ())
+            return 0.0;
+        const double h = q * (s.size () - 1);
+        const double f = h - pos;
+        if (f == 0.0)
+            return *i;
+        auto j = i;
+        ++j;
+        assert (j != s.end ());
+        return *i + f * (*j - *i);
+    }
+};
+
+/// @brief keep a running median of a window of numbers
+///
+/// Unlike running_mean, a few wild numbers in the window barely move it.
+class running_median
+{
+    private:
+    running_quantile m;
+    public:
+    /// @brief contructor
+    running_median ()
+        : m (0.5)
+    {
+    }
+    /// @brief reset to empty
+    void reset ()
+    {
+        m.reset ();
+    }
+    /// @brief add a number to the window
+    ///
+    /// @param x number to add
+    void add (const double x)
+    {
+        m.add (x);
+    }
+    /// @brief remove a number from the window
+    ///
+    /// @param x number to remove
+    void remove (const double x)
+    {
+        m.remove (x);
+    }
+    /// @brief get the current median
+    ///
+    /// @return the median
+    double get_median () const
+    {
+        return m.get_quantile ();
+    }
+};
+
 }
 
 #endif
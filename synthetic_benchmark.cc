@@ -0,0 +1,171 @@
+/// @file synthetic_benchmark.cc
+/// @brief load and latency test using synthetic hand motion
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-26
+
+#include "finger_id_tracker.h"
+#include "hand_motion_generator.h"
+#include "mouse_clicker.h"
+#include <chrono>
+#include <map>
+#include <stdexcept>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: synthetic_benchmark [frames [fps [noise [flicker]]]]";
+
+/// @brief time a function over all the frames
+template<typename F>
+void time_stage (const string &name, const vector<frame> &frames, F f)
+{
+    auto start = chrono::steady_clock::now ();
+    for (const auto &i : frames)
+        f (i);
+    double secs = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+    clog << name << '\t' << frames.size () / secs << " frames/sec" << endl;
+}
+
+/// @brief decision latency for one kind of gesture
+struct latency
+{
+    size_t onsets;
+    size_t missed;
+    uint64_t total;
+    uint64_t worst;
+    latency ()
+        : onsets (0)
+        , missed (0)
+        , total (0)
+        , worst (0)
+    {
+    }
+};
+
+int main (int argc, char **argv)
+{
+    try
+    {
+        if (argc > 5)
+            throw runtime_error (usage);
+
+        const size_t N = argc > 1 ? atol (argv[1]) : 1000000;
+        hand_motion_parameters p;
+        if (argc > 2)
+            p.fps = atof (argv[2]);
+        if (argc > 3)
+            p.noise = atof (argv[3]);
+        if (argc > 4)
+            p.flicker = atof (argv[4]);
+        if (p.fps <= 0.0)
+            throw runtime_error ("fps must be positive");
+
+        // generate the frames up front so that generating them is not part of the timings
+        clog << "generating " << N << " frames at " << p.fps << "fps" << endl;
+        hand_motion_generator g (p);
+        vector<frame> frames (N);
+        vector<gesture_label> labels (N);
+        auto start = chrono::steady_clock::now ();
+        for (size_t i = 0; i < N; ++i)
+            g.next (frames[i], labels[i]);
+        double secs = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+        clog << "generator" << '\t' << N / secs << " frames/sec" << endl;
+
+        // throughput of each stage
+        static const uint64_t WINDOW_DURATION = 200000;
+        {
+            finger_counter fc (WINDOW_DURATION);
+            time_stage ("finger_counter", frames, [&] (const frame &f) { fc.add (f.ts, f.s.size ()); });
+        }
+        {
+            finger_id_tracker fit (WINDOW_DURATION);
+            finger_ids ids;
+            time_stage ("finger_id_tracker", frames, [&] (const frame &f)
+            {
+                ids.resize (f.s.size ());
+                for (size_t j = 0; j < ids.size (); ++j)
+                    ids[j] = f.s[j].id;
+                fit.add (f.ts, ids);
+            });
+        }
+        {
+            hand_shape_classifier hsc (WINDOW_DURATION);
+            time_stage ("hand_shape_classifier", frames, [&] (const frame &f) { hsc.add (f.ts, f.s); });
+        }
+        {
+            pinch_detector pd;
+            time_stage ("pinch_detector", frames, [&] (const frame &f)
+            {
+                pd.update (f.ts, f.s);
+                if (pd.is_set ())
+                    pd.reset ();
+            });
+        }
+
+        // time from gesture onset until the classifier agrees with the ground truth
+        hand_shape_classifier hsc (WINDOW_DURATION);
+        pinch_detector pd;
+        map<gesture,latency> latencies;
+        bool waiting = false;
+        size_t pinches = 0;
+        size_t pinch_cycles = 0;
+        for (size_t i = 0; i < N; ++i)
+        {
+            const frame &f = frames[i];
+            const gesture_label &l = labels[i];
+            latency &lat = latencies[l.g];
+            if (l.onset)
+            {
+                if (waiting)
+                    ++latencies[labels[i - 1].g].missed;
+                ++lat.onsets;
+                waiting = true;
+            }
+            hsc.add (f.ts, f.s);
+            if (waiting && hsc.get_shape () == expected_shape (l.g))
+            {
+                const uint64_t d = f.ts - l.onset_ts;
+                lat.total += d;
+                lat.worst = max (lat.worst, d);
+                waiting = false;
+            }
+            if (l.g == gesture::pinching)
+            {
+                // count open to closed transitions in the ground truth
+                if (i > 0 && labels[i - 1].g == gesture::pinching
+                    && f.s.size () == 2 && frames[i - 1].s.size () == 2
+                    && f.s[0].position.distanceTo (f.s[1].position) < 50
+                    && frames[i - 1].s[0].position.distanceTo (frames[i - 1].s[1].position) > 50)
+                    ++pinch_cycles;
+                pd.update (f.ts, f.s);
+                if (pd.is_set ())
+                {
+                    ++pinches;
+                    pd.reset ();
+                }
+            }
+            else
+                pd.reset ();
+        }
+        clog << "gesture\tonsets\tmissed\tmean latency\tworst latency" << endl;
+        for (auto i : latencies)
+        {
+            const latency &lat = i.second;
+            const size_t found = lat.onsets - lat.missed;
+            clog << to_string (i.first)
+                << '\t' << lat.onsets
+                << '\t' << lat.missed
+                << '\t' << (found ? lat.total / found / 1000.0 : 0.0) << "ms"
+                << '\t' << lat.worst / 1000.0 << "ms"
+                << endl;
+        }
+        clog << pinches << " pinches detected in " << pinch_cycles << " pinch cycles" << endl;
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -4,34 +4,29 @@
 /// @version 1.0
 /// @date 2013-010-22
 
+#include "frame_sources.h"
 #include "soma.h"
 #include <unistd.h>
 
 using namespace std;
 using namespace soma;
-const string usage = "usage: test1";
+const string usage = "usage: test1 " + frame_source_usage;
 
 enum class point_mode { fast, slow };
 
-class test1 : public Leap::Listener
+class test1 : public frame_listener
 {
     private:
     static const uint64_t SW_DURATION = 100000;
     static const uint64_t SWS_DURATION = 200000;
-    sliding_window<double> swx;
-    sliding_window<double> swy;
-    sliding_window<double> swx2;
-    sliding_window<double> swy2;
-    sliding_window<double> swdx;
-    sliding_window<double> swdy;
-    running_mean smooth_x;
-    running_mean smooth_y;
-    running_mean smooth_x2;
-    running_mean smooth_y2;
-    running_mean smooth_dx;
-    running_mean smooth_dy;
+    // x, y, x^2, y^2
+    multi_sliding_window<double, 4> sw;
+    // dx, dy
+    multi_sliding_window<double, 2> sws;
+    std::array<running_mean, 4> smooth;
+    std::array<running_mean, 2> smooth_d;
     static const uint64_t FINGER_COUNTER_WINDOW_DURATION = 200000;
-    bool done;
+    done_flag done;
     finger_counter fc;
     mouse m;
     point_mode pm;
@@ -70,16 +65,14 @@ class test1 : public Leap::Listener
             //std::clog << zy_slope << std::endl;
             double x = mapx (zx_slope);
             double y = mapy (zy_slope);
-            swx.add (ts, x, smooth_x);
-            swy.add (ts, y, smooth_y);
-            swx2.add (ts, x * x, smooth_x2);
-            swy2.add (ts, y * y, smooth_y2);
-            const double sx = smooth_x.get_mean ();
-            const double sy = smooth_y.get_mean ();
+            const std::array<double, 4> p = {{ x, y, x * x, y * y }};
+            sw.add (ts, p, smooth);
+            const double sx = smooth[0].get_mean ();
+            const double sy = smooth[1].get_mean ();
             const double dx = dd.current ().x - dd.last ().x;
             const double dy = dd.last ().y - dd.current ().y;
-            swdx.add (ts, dx, smooth_dx);
-            swdy.add (ts, dy, smooth_dy);
+            const std::array<double, 2> d = {{ dx, dy }};
+            sws.add (ts, d, smooth_d);
             std::clog << dx << '\t' << dy << std::endl;
             if (dx < 0.1 && dy < 0.1)
                 pm = point_mode::slow;
@@ -90,7 +83,7 @@ class test1 : public Leap::Listener
                 default: assert (0); // logic error
                 case point_mode::slow:
                 {
-                    m.move (5 * smooth_dx.get_mean (), 5 * smooth_dy.get_mean ());
+                    m.move (5 * smooth_d[0].get_mean (), 5 * smooth_d[1].get_mean ());
                     break;
                 }
                 case point_mode::fast:
@@ -103,13 +96,8 @@ class test1 : public Leap::Listener
     }
     public:
     test1 ()
-        : swx (SW_DURATION)
-        , swy (SW_DURATION)
-        , swx2 (SW_DURATION)
-        , swy2 (SW_DURATION)
-        , swdx (SWS_DURATION)
-        , swdy (SWS_DURATION)
-        , done (false)
+        : sw (SW_DURATION)
+        , sws (SWS_DURATION)
         , fc (FINGER_COUNTER_WINDOW_DURATION)
         , pm (point_mode::slow)
     {
@@ -117,23 +105,21 @@ class test1 : public Leap::Listener
     ~test1 ()
     {
     }
-    bool is_done () const
+    /// @brief get the flag that is set when the user quits
+    done_flag &get_done ()
     {
         return done;
     }
-    virtual void onFrame (const Leap::Controller& c)
+    virtual void on_frame (const frame &f)
     {
-        if (done)
+        if (done.is_set ())
             return;
-        // get the frame
-        Leap::Frame f = c.frame ();
-        uint64_t ts = f.timestamp ();
-        // get the sample
-        hand_sample s (f.pointables ());
+        const uint64_t ts = f.ts;
+        const hand_sample &s = f.s;
         // quit?
         if (s.size () > 6)
         {
-            done = true;
+            done.set ();
             return;
         }
         hand_sample tmp (s);
@@ -146,25 +132,27 @@ int main (int argc, char **argv)
 {
     try
     {
-        if (argc != 1)
+        if (!valid_frame_source_args (argc - 1, argv + 1))
             throw runtime_error (usage);
 
+        // signals are blocked in every thread started after this
+        event_loop loop;
+
         test1 t;
-        Leap::Controller c (t);
+        unique_ptr<frame_source> src = make_frame_source (argc - 1, argv + 1);
+        loop.quit_when (t.get_done ());
+        loop.quit_when (src->get_done ());
+        src->start (t);
 
         clog << "7 fingers = quit" << endl;
 
-        // receive frames even when you don't have focus
-        c.setPolicyFlags (Leap::Controller::POLICY_BACKGROUND_FRAMES);
+        // sleep until the user quits, the source runs out of frames, or a signal arrives
+        loop.run ();
 
-        // loop
-        while (!t.is_done ())
-            usleep (5000);
+        src->stop ();
 
         clog << "done" << endl;
 
-        usleep (1000000);
-
         return 0;
     }
     catch (const exception &e)
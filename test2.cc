@@ -4,25 +4,25 @@
 /// @version 1.0
 /// @date 2013-010-22
 
+#include "frame_sources.h"
 #include "soma.h"
 #include <unistd.h>
 
 using namespace std;
 using namespace soma;
-const string usage = "usage: test2";
+const string usage = "usage: test2 " + frame_source_usage;
 
 enum class point_mode { fast, slow };
 
-class test2 : public Leap::Listener
+class test2 : public frame_listener
 {
     private:
     static const uint64_t SW_DURATION = 50000;
-    sliding_window<double> swx;
-    sliding_window<double> swy;
-    running_mean smooth_x;
-    running_mean smooth_y;
+    // x, y
+    multi_sliding_window<double, 2> sw;
+    std::array<running_mean, 2> smooth;
     static const uint64_t FINGER_COUNTER_WINDOW_DURATION = 200000;
-    bool done;
+    done_flag done;
     finger_counter fc;
     mouse m;
     point_delta<vec3> dd;
@@ -43,10 +43,10 @@ class test2 : public Leap::Listener
             }
             const double x = p.x;
             const double y = p.y;
-            swx.add (ts, x, smooth_x);
-            swy.add (ts, y, smooth_y);
-            const double sx = smooth_x.get_mean ();
-            const double sy = smooth_y.get_mean ();
+            const std::array<double, 2> xy = {{ x, y }};
+            sw.add (ts, xy, smooth);
+            const double sx = smooth[0].get_mean ();
+            const double sy = smooth[1].get_mean ();
             // get index pointer
             dd.update (ts, vec3 (sx, sy, 0));
             const double dx = dd.current ().x - dd.last ().x;
@@ -73,32 +73,28 @@ class test2 : public Leap::Listener
     }
     public:
     test2 ()
-        : swx (SW_DURATION)
-        , swy (SW_DURATION)
-        , done (false)
+        : sw (SW_DURATION)
         , fc (FINGER_COUNTER_WINDOW_DURATION)
     {
     }
     ~test2 ()
     {
     }
-    bool is_done () const
+    /// @brief get the flag that is set when the user quits
+    done_flag &get_done ()
     {
         return done;
     }
-    virtual void onFrame (const Leap::Controller& c)
+    virtual void on_frame (const frame &f)
     {
-        if (done)
+        if (done.is_set ())
             return;
-        // get the frame
-        Leap::Frame f = c.frame ();
-        uint64_t ts = f.timestamp ();
-        // get the sample
-        hand_sample s (f.pointables ());
+        const uint64_t ts = f.ts;
+        const hand_sample &s = f.s;
         // quit?
         if (s.size () > 6)
         {
-            done = true;
+            done.set ();
             return;
         }
         hand_sample tmp (s);
@@ -111,25 +107,27 @@ int main (int argc, char **argv)
 {
     try
     {
-        if (argc != 1)
+        if (!valid_frame_source_args (argc - 1, argv + 1))
             throw runtime_error (usage);
 
+        // signals are blocked in every thread started after this
+        event_loop loop;
+
         test2 t;
-        Leap::Controller c (t);
+        unique_ptr<frame_source> src = make_frame_source (argc - 1, argv + 1);
+        loop.quit_when (t.get_done ());
+        loop.quit_when (src->get_done ());
+        src->start (t);
 
         clog << "7 fingers = quit" << endl;
 
-        // receive frames even when you don't have focus
-        c.setPolicyFlags (Leap::Controller::POLICY_BACKGROUND_FRAMES);
+        // sleep until the user quits, the source runs out of frames, or a signal arrives
+        loop.run ();
 
-        // loop
-        while (!t.is_done ())
-            usleep (5000);
+        src->stop ();
 
         clog << "done" << endl;
 
-        usleep (1000000);
-
         return 0;
     }
     catch (const exception &e)
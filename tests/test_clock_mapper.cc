@@ -0,0 +1,114 @@
+/// @file test_clock_mapper.cc
+/// @brief test clock_mapper and latency_monitor classes
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-09
+
+#include "../clock_mapper.h"
+#include "../latency_monitor.h"
+#include "verify.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_clock_mapper [verbose]";
+
+void test_mapping (const bool verbose)
+{
+    // a device whose clock runs 50ppm slow and started 1000 seconds after the host's, sending frames at 100fps
+    // that take at least 2ms and usually a bit more to get here
+    mt19937 rng (1);
+    exponential_distribution<double> delay (1.0 / 1500);
+    const double drift = 50e-6;
+    const uint64_t start = 1000000000;
+    clock_mapper cm;
+    VERIFY (!cm.is_ready ());
+    double max_error = 0.0;
+    for (uint64_t t = 0; t < 120000000; t += 10000)
+    {
+        const uint64_t device_ts = t - static_cast<uint64_t> (t * drift);
+        const uint64_t host_ts = start + t + 2000 + static_cast<uint64_t> (delay (rng));
+        cm.add (device_ts, host_ts);
+        VERIFY (cm.is_ready ());
+        // after the first window, captures map to within a little of the fastest arrival
+        if (t > 30000000)
+            max_error = max (max_error, fabs (static_cast<double> (cm.to_host (device_ts)) - (start + t + 2000)));
+    }
+    if (verbose)
+    {
+        clog << cm.get_drift () << "ppm drift" << endl;
+        clog << cm.get_offset () << "us offset" << endl;
+        clog << max_error << "us largest error" << endl;
+    }
+    VERIFY (fabs (cm.get_drift () - 50.0) < 2.0);
+    VERIFY (max_error < 100.0);
+    // the device restarts
+    cm.add (500, start + 130000000);
+    VERIFY (cm.to_host (500) == start + 130000000);
+    VERIFY (cm.get_drift () == 0.0);
+}
+
+void test_histogram (const bool verbose)
+{
+    latency_histogram h (100, 10);
+    VERIFY (h.quantile (0.5) == 0);
+    for (uint64_t i = 0; i < 100; ++i)
+        h.add (i * 10);
+    h.add (5000);
+    if (verbose)
+        print_stats (clog, h);
+    VERIFY (h.size () == 101);
+    VERIFY (h.get_max () == 5000);
+    VERIFY (h.get_counts ()[0] == 10);
+    VERIFY (h.get_counts ()[10] == 1);
+    VERIFY (h.quantile (0.5) == 600);
+    VERIFY (h.quantile (0.9) == 1000);
+    VERIFY (h.quantile (1.0) == 5000);
+    VERIFY (fabs (h.mean () - (49500.0 + 5000.0) / 101) < 1e-9);
+}
+
+void test_monitor (const bool verbose)
+{
+    latency_monitor m;
+    mouse_event e = { mouse_event_type::move, 0, 0, 0, 1, 1 };
+    // frames without host times aren't timed
+    frame f;
+    f.ts = 1000;
+    m.begin (f);
+    m.on_event (e);
+    VERIFY (m.get_capture_latency ().size () == 0);
+    // a frame that arrived 1ms ago
+    f.ts = 2000;
+    f.host_ts = host_now () - 1000;
+    m.begin (f);
+    this_thread::sleep_for (chrono::milliseconds (2));
+    m.on_event (e);
+    m.on_event (e);
+    if (verbose)
+        print_stats (clog, m);
+    VERIFY (m.get_capture_latency ().size () == 2);
+    VERIFY (m.get_processing_latency ().size () == 2);
+    VERIFY (m.get_processing_latency ().get_max () >= 3000);
+    VERIFY (m.get_processing_latency ().get_max () < 1000000);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_mapping (verbose);
+        test_histogram (verbose);
+        test_monitor (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
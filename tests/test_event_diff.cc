@@ -0,0 +1,132 @@
+/// @file test_event_diff.cc
+/// @brief test the headless mouse, event_log_observer and compare_events
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-12
+
+#include "../event_diff.h"
+#include "verify.h"
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_event_diff [verbose]";
+const string fn ("/tmp/test_event_diff.events");
+
+event_record make_event (int64_t id, mouse_event_type type, int x, int y, int button = 0, bool down = false)
+{
+    const mouse_event e = { type, static_cast<uint8_t> (button), down, 0, x, y };
+    const event_record r = { static_cast<uint64_t> (id) * 10000, id, e, 0 };
+    return r;
+}
+
+void test_headless (const bool verbose)
+{
+    {
+        mouse m (1920, 1080);
+        VERIFY (m.is_headless ());
+        VERIFY (m.width () == 1920);
+        VERIFY (m.height () == 1080);
+        event_log_observer o (fn);
+        m.add_observer (&o);
+        o.begin (10000, 1);
+        m.move (3, -4);
+        o.begin (20000, 2);
+        m.click (1, true);
+        m.click (1, false);
+        m.set (960, 540);
+        VERIFY (o.get_events () == 4);
+        o.close ();
+    }
+    const vector<event_record> e = read_event_log (fn);
+    if (verbose)
+        for (auto i : e)
+        {
+            print_event (clog, i);
+            clog << endl;
+        }
+    VERIFY (e.size () == 4);
+    VERIFY (e[0].id == 1);
+    VERIFY (e[0].ts == 10000);
+    VERIFY (e[0].e.type == mouse_event_type::move);
+    VERIFY (e[0].e.y == -4);
+    VERIFY (e[1].id == 2);
+    VERIFY (e[1].e.button == 1 && e[1].e.down);
+    VERIFY (e[2].e.button == 1 && !e[2].e.down);
+    VERIFY (e[3].e.type == mouse_event_type::set);
+    VERIFY (e[3].e.x == 960);
+    unlink (fn.c_str ());
+}
+
+void test_compare (const bool verbose)
+{
+    vector<event_record> a;
+    for (int i = 0; i < 10; ++i)
+        a.push_back (make_event (i, mouse_event_type::move, 10 * i, -10 * i));
+    a.push_back (make_event (10, mouse_event_type::button, 0, 0, 1, true));
+    a.push_back (make_event (10, mouse_event_type::button, 0, 0, 1, false));
+    for (int i = 11; i < 20; ++i)
+        a.push_back (make_event (i, mouse_event_type::move, 1, 1));
+    // the same
+    VERIFY (compare_events (a, a).empty ());
+    // small changes are within tolerance
+    vector<event_record> b = a;
+    b[3].e.x += 1;
+    b[5].id += 1;
+    VERIFY (compare_events (a, b).size () == 2);
+    event_tolerance t;
+    t.pixels = 1;
+    t.frames = 1;
+    VERIFY (compare_events (a, b, t).empty ());
+    // a big change
+    b[3].e.x += 10;
+    vector<event_difference> d = compare_events (a, b, t);
+    if (verbose)
+        for (auto i : d)
+            print_difference (clog, i, a, b);
+    VERIFY (d.size () == 1);
+    VERIFY (d[0].change == event_change::changed);
+    VERIFY (d[0].a == 3 && d[0].b == 3);
+    // a click that went missing, and a move that wasn't there before
+    b = a;
+    b.erase (b.begin () + 10, b.begin () + 12);
+    b.insert (b.begin () + 2, make_event (1, mouse_event_type::move, 50, 50));
+    d = compare_events (a, b);
+    if (verbose)
+        for (auto i : d)
+            print_difference (clog, i, a, b);
+    VERIFY (d.size () == 3);
+    VERIFY (d[0].change == event_change::extra);
+    VERIFY (d[0].b == 2);
+    VERIFY (d[1].change == event_change::missing);
+    VERIFY (d[1].a == 10);
+    VERIFY (d[2].change == event_change::missing);
+    VERIFY (d[2].a == 11);
+    // one stream stops early
+    b.assign (a.begin (), a.begin () + 15);
+    d = compare_events (a, b);
+    VERIFY (d.size () == 6);
+    VERIFY (d[0].change == event_change::missing && d[0].a == 15);
+    d = compare_events (b, a);
+    VERIFY (d.size () == 6);
+    VERIFY (d[5].change == event_change::extra && d[5].b == 20);
+    VERIFY (compare_events (vector<event_record> (), vector<event_record> ()).empty ());
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_headless (verbose);
+        test_compare (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,169 @@
+/// @file test_event_loop.cc
+/// @brief test event_loop and notifier classes
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-05
+
+#include "../event_loop.h"
+#include "verify.h"
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_event_loop [verbose]";
+
+typedef chrono::steady_clock clock_type;
+
+double ms_since (clock_type::time_point start)
+{
+    return chrono::duration<double, milli> (clock_type::now () - start).count ();
+}
+
+struct counter : public frame_listener
+{
+    size_t frames;
+    counter ()
+        : frames (0)
+    {
+    }
+    virtual void on_frame (const frame &)
+    {
+        ++frames;
+    }
+};
+
+void test_notifier (const bool verbose)
+{
+    notifier n;
+    // nothing to wait for
+    VERIFY (!n.clear ());
+    VERIFY (!n.wait (0));
+    // notifications before the wait are not lost, and are all cleared at once
+    n.notify ();
+    n.notify ();
+    VERIFY (n.wait (0));
+    VERIFY (!n.wait (0));
+    // wake from another thread
+    auto start = clock_type::now ();
+    thread t ([&] () { this_thread::sleep_for (chrono::milliseconds (20)); n.notify (); });
+    VERIFY (n.wait ());
+    t.join ();
+    const double ms = ms_since (start);
+    if (verbose)
+        clog << "woke after " << ms << "ms" << endl;
+    VERIFY (ms >= 15 && ms < 1000);
+    // deadlines
+    start = clock_type::now ();
+    VERIFY (!n.wait_until (start + chrono::milliseconds (10)));
+    VERIFY (ms_since (start) >= 10);
+    n.notify ();
+    VERIFY (n.wait_until (clock_type::now () + chrono::seconds (10)));
+}
+
+void test_quit_when_done (const bool verbose)
+{
+    event_loop loop;
+    // 100 frames at 1ms each
+    size_t n = 0;
+    generated_frame_source src ([&] (frame &f)
+        {
+            if (n == 100)
+                return false;
+            f.id = n;
+            f.ts = n * 1000;
+            ++n;
+            return true;
+        }, 1.0);
+    counter c;
+    loop.quit_when (src.get_done ());
+    auto start = clock_type::now ();
+    src.start (c);
+    loop.run ();
+    const double ms = ms_since (start);
+    src.stop ();
+    if (verbose)
+        clog << c.frames << " frames in " << ms << "ms" << endl;
+    VERIFY (c.frames == 100);
+    VERIFY (src.is_done ());
+    VERIFY (loop.get_signal () == 0);
+    VERIFY (ms < 1000);
+    // a flag that is already set quits right away
+    event_loop loop2;
+    loop2.quit_when (src.get_done ());
+    loop2.run ();
+}
+
+void test_stop (const bool verbose)
+{
+    event_loop loop;
+    // a frame every 10 seconds
+    size_t n = 0;
+    generated_frame_source src ([&] (frame &f) { f.id = n; f.ts = n++ * 10000000; return true; }, 1.0);
+    counter c;
+    loop.quit_when (src.get_done ());
+    loop.add_timer (chrono::milliseconds (20), [&] () { loop.quit (); });
+    src.start (c);
+    loop.run ();
+    // stopping does not wait for the next frame
+    auto start = clock_type::now ();
+    src.stop ();
+    const double ms = ms_since (start);
+    if (verbose)
+        clog << "stopped in " << ms << "ms" << endl;
+    VERIFY (c.frames == 1);
+    VERIFY (ms < 100);
+}
+
+void test_timer (const bool verbose)
+{
+    event_loop loop;
+    size_t ticks = 0;
+    loop.add_timer (chrono::milliseconds (5), [&] ()
+        {
+            if (++ticks == 10)
+                loop.quit ();
+        });
+    auto start = clock_type::now ();
+    loop.run ();
+    const double ms = ms_since (start);
+    if (verbose)
+        clog << ticks << " ticks in " << ms << "ms" << endl;
+    VERIFY (ticks == 10);
+    VERIFY (ms >= 45);
+}
+
+void test_signal (const bool verbose)
+{
+    event_loop loop;
+    // signals sent to the process while the main thread sleeps
+    thread t ([] () { this_thread::sleep_for (chrono::milliseconds (10)); kill (getpid (), SIGTERM); });
+    loop.run ();
+    t.join ();
+    if (verbose)
+        clog << "got signal " << loop.get_signal () << endl;
+    VERIFY (loop.get_signal () == SIGTERM);
+    raise (SIGINT);
+    loop.run ();
+    VERIFY (loop.get_signal () == SIGINT);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_notifier (verbose);
+        test_quit_when_done (verbose);
+        test_stop (verbose);
+        test_timer (verbose);
+        test_signal (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
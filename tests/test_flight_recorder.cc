@@ -0,0 +1,160 @@
+/// @file test_flight_recorder.cc
+/// @brief test flight_recorder class
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-03
+
+#include "../flight_recorder.h"
+#include "../hand_motion_generator.h"
+#include "verify.h"
+#include <dirent.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_flight_recorder [verbose]";
+
+const string dir ("/tmp/test_flight_recorder_dumps");
+const string fn (dir + "/test.somf");
+
+/// @brief remove the dumps
+void clean ()
+{
+    DIR *d = opendir (dir.c_str ());
+    if (!d)
+        return;
+    while (dirent *e = readdir (d))
+        if (e->d_name[0] != '.')
+            unlink ((dir + "/" + e->d_name).c_str ());
+    closedir (d);
+    rmdir (dir.c_str ());
+}
+
+/// @brief record n frames, with a click on every 100th one
+void record (flight_recorder &fr, hand_motion_generator &g, size_t n)
+{
+    frame f;
+    gesture_label l;
+    for (size_t i = 0; i < n; ++i)
+    {
+        g.next (f, l);
+        fr.begin (f);
+        fr.set_state (1, f.s.size (), 2);
+        if (f.id % 100 == 0)
+        {
+            const mouse_event down = { mouse_event_type::button, 1, 1, 0, 0, 0 };
+            const mouse_event up = { mouse_event_type::button, 1, 0, 0, 0, 0 };
+            fr.on_event (down);
+            fr.on_event (up);
+        }
+        fr.end ();
+    }
+}
+
+void test_ring (const bool verbose)
+{
+    hand_motion_parameters p;
+    p.fps = 100;
+    hand_motion_generator g (p);
+    const double SECONDS = 2.0;
+    flight_recorder fr (SECONDS, dir);
+    // more than fits in the ring
+    record (fr, g, fr.capacity () * 3 + 7);
+    fr.dump (fn);
+    VERIFY (fr.get_dumps () == 1);
+    const vector<flight_record> r = read_flight_records (fn);
+    if (verbose)
+        clog << r.size () << " records of " << fr.get_records () << endl;
+    // at 100 fps the ring holds more than 2 seconds, but only the last 2 seconds are dumped
+    VERIFY (r.size () >= SECONDS * p.fps);
+    VERIFY (r.size () <= SECONDS * p.fps + 1);
+    VERIFY (r.back ().id == static_cast<int64_t> (fr.get_records () - 1));
+    for (size_t i = 1; i < r.size (); ++i)
+    {
+        VERIFY (r[i].id == r[i - 1].id + 1);
+        VERIFY (r[i].shape == 1);
+        VERIFY (r[i].pinch == 2);
+        VERIFY (r[i].count == static_cast<int> (r[i].nfingers));
+        if (r[i].id % 100 == 0)
+        {
+            VERIFY (r[i].nevents == 2);
+            VERIFY (r[i].events[0].type == mouse_event_type::button);
+            VERIFY (r[i].events[0].down);
+            VERIFY (!r[i].events[1].down);
+        }
+        else
+            VERIFY (r[i].nevents == 0);
+    }
+}
+
+void test_trigger (const bool verbose)
+{
+    hand_motion_generator g ((hand_motion_parameters ()));
+    flight_recorder fr (1.0, dir);
+    size_t triggered = 0;
+    fr.set_trigger ([&] (const flight_record &r) { ++triggered; return r.nevents != 0; });
+    // a click every 100 frames at 120 fps, but only one dump per second
+    record (fr, g, 1000);
+    if (verbose)
+        clog << fr.get_dumps () << " dumps" << endl;
+    VERIFY (triggered > 0);
+    VERIFY (fr.get_dumps () == 5);
+    // SIGUSR1 dumps on the next frame
+    fr.set_trigger (std::function<bool (const flight_record &)> ());
+    fr.install_signal_handlers ();
+    const uint64_t dumps = fr.get_dumps ();
+    raise (SIGUSR1);
+    record (fr, g, 1);
+    VERIFY (fr.get_dumps () == dumps + 1);
+    record (fr, g, 1);
+    VERIFY (fr.get_dumps () == dumps + 1);
+}
+
+void test_crash (const bool verbose)
+{
+    const string crash_fn = dir + "/flight-crash.somf";
+    unlink (crash_fn.c_str ());
+    const pid_t pid = fork ();
+    VERIFY (pid != -1);
+    if (pid == 0)
+    {
+        hand_motion_generator g ((hand_motion_parameters ()));
+        flight_recorder fr (1.0, dir);
+        fr.install_signal_handlers ();
+        record (fr, g, 500);
+        raise (SIGSEGV);
+        _exit (0);
+    }
+    int status = 0;
+    VERIFY (waitpid (pid, &status, 0) == pid);
+    VERIFY (WIFSIGNALED (status) && WTERMSIG (status) == SIGSEGV);
+    const vector<flight_record> r = read_flight_records (crash_fn);
+    if (verbose)
+        clog << r.size () << " records in crash dump" << endl;
+    VERIFY (!r.empty ());
+    VERIFY (r.back ().id == 499);
+    unlink (crash_fn.c_str ());
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        clean ();
+        VERIFY (mkdir (dir.c_str (), 0700) == 0);
+        test_ring (verbose);
+        test_trigger (verbose);
+        test_crash (verbose);
+        clean ();
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
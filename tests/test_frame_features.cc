@@ -0,0 +1,118 @@
+/// @file test_frame_features.cc
+/// @brief test frame_features class
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-30
+
+#include "../frame_features.h"
+#include "verify.h"
+#include <iostream>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_frame_features [verbose]";
+
+hand_sample random_sample (size_t n)
+{
+    hand_sample s;
+    for (size_t i = 0; i < n; ++i)
+    {
+        finger f;
+        f.id = rand () % 20;
+        f.position = vec3 (rand () % 200 - 100, rand () % 300, rand () % 10);
+        s.push_back (f);
+    }
+    return s;
+}
+
+void test_orders (const bool verbose)
+{
+    const finger_order orders[] = {
+        finger_order::left_to_right,
+        finger_order::top_to_bottom,
+        finger_order::back_to_front,
+        finger_order::by_id };
+    bool (*sorts[]) (const finger &, const finger &) = {
+        sort_left_to_right,
+        sort_top_to_bottom,
+        sort_back_to_front,
+        sort_by_id };
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        hand_sample s = random_sample (i % (hand_sample::MAX_FINGERS + 1));
+        frame_features ff (s);
+        VERIFY (ff.size () == s.size ());
+        for (size_t k = 0; k < 4; ++k)
+        {
+            hand_sample t (s);
+            stable_sort (t.begin (), t.end (), sorts[k]);
+            for (size_t j = 0; j < s.size (); ++j)
+            {
+                VERIFY (ff.get (orders[k], j).id == t[j].id);
+                VERIFY (ff.get (orders[k], j).position == t[j].position);
+            }
+        }
+    }
+}
+
+void test_distances (const bool verbose)
+{
+    float max_error = 0;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        hand_sample s = random_sample (i % (hand_sample::MAX_FINGERS + 1));
+        frame_features ff (s);
+        for (size_t j = 0; j < s.size (); ++j)
+        {
+            for (size_t k = 0; k < s.size (); ++k)
+            {
+                const float d = s[j].position.distanceTo (s[k].position);
+                max_error = max (max_error, fabsf (ff.distance (j, k) - d));
+            }
+            VERIFY (ff.distance (j, j) == 0);
+        }
+        if (s.size () > 1)
+        {
+            const float d = ff.left_to_right (0).position.distanceTo (ff.left_to_right (1).position);
+            VERIFY (ff.distance (finger_order::left_to_right, 0, 1) == d);
+        }
+    }
+    if (verbose)
+        clog << "max distance error " << max_error << endl;
+    VERIFY (max_error < 1e-4);
+}
+
+void test_centroid (const bool verbose)
+{
+    hand_sample s;
+    frame_features ff0 (s);
+    VERIFY (ff0.spread () == 0);
+    finger f;
+    f.position = vec3 (-10, 100, 0);
+    s.push_back (f);
+    f.position = vec3 (10, 100, 0);
+    s.push_back (f);
+    frame_features ff (s);
+    if (verbose)
+        clog << "centroid " << ff.centroid () << " spread " << ff.spread () << endl;
+    VERIFY (ff.centroid () == vec3 (0, 100, 0));
+    VERIFY (ff.spread () == 10);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_orders (verbose);
+        test_distances (verbose);
+        test_centroid (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
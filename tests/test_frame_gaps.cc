@@ -0,0 +1,116 @@
+/// @file test_frame_gaps.cc
+/// @brief test frame_gap_detector and interpolate
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-10
+
+#include "../frame_gaps.h"
+#include "verify.h"
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_frame_gaps [verbose]";
+
+frame make_frame (int64_t id)
+{
+    frame f;
+    f.id = id;
+    f.ts = id * 10000;
+    return f;
+}
+
+void test_detector (const bool verbose)
+{
+    frame_gap_detector d;
+    VERIFY (d.update (make_frame (2000)) == frame_status::first);
+    VERIFY (d.update (make_frame (2001)) == frame_status::ok);
+    VERIFY (d.update (make_frame (2001)) == frame_status::duplicate);
+    VERIFY (d.update (make_frame (2005)) == frame_status::gap);
+    VERIFY (d.get_missing () == 3);
+    VERIFY (d.update (make_frame (2004)) == frame_status::out_of_order);
+    VERIFY (d.get_missing () == 0);
+    VERIFY (d.update (make_frame (2006)) == frame_status::ok);
+    VERIFY (d.update (make_frame (2008)) == frame_status::gap);
+    VERIFY (d.get_missing () == 1);
+    // the source started over
+    VERIFY (d.update (make_frame (3)) == frame_status::first);
+    VERIFY (d.update (make_frame (4)) == frame_status::ok);
+    if (verbose)
+        print_stats (clog, d);
+    VERIFY (d.get_frames () == 7);
+    VERIFY (d.get_gaps () == 2);
+    VERIFY (d.get_dropped () == 4);
+    VERIFY (d.get_duplicates () == 1);
+    VERIFY (d.get_out_of_order () == 1);
+    VERIFY (d.get_restarts () == 1);
+    VERIFY (fabs (d.drop_rate () - 4.0 / 11.0) < 1e-12);
+}
+
+void test_interpolate (const bool verbose)
+{
+    frame a = make_frame (10);
+    frame b = make_frame (14);
+    // two fingers that cross over, and one that only b has, and a hand that has one of each
+    a.s.resize (2);
+    a.s[0].id = 1;
+    a.s[0].position = vec3 (0, 0, 0);
+    a.s[1].id = 2;
+    a.s[1].position = vec3 (50, 0, 0);
+    a.has_hands = b.has_hands = true;
+    a.nhands = b.nhands = 1;
+    a.hands[0].id = b.hands[0].id = 7;
+    a.hands[0].palm_position = vec3 (0, 0, 0);
+    b.s.resize (3);
+    b.s[0].id = 2;
+    b.s[0].position = vec3 (-30, 0, 0);
+    b.s[1].id = 1;
+    b.s[1].position = vec3 (80, 0, 0);
+    b.s[2].id = 3;
+    b.s[2].position = vec3 (100, 0, 0);
+    b.hands[0].fingers = 0x5;
+    b.hands[0].palm_position = vec3 (40, 0, 0);
+    frame f;
+    interpolate (a, b, 1, 3, f);
+    VERIFY (f.id == 11);
+    VERIFY (f.ts == 110000);
+    VERIFY (f.s.size () == 3);
+    VERIFY (f.s[0].id == 1);
+    VERIFY (f.s[0].position.x == 20);
+    VERIFY (f.s[1].id == 2);
+    VERIFY (f.s[1].position.x == 30);
+    VERIFY (f.s[2].id == 3);
+    VERIFY (f.s[2].position.x == 100);
+    VERIFY (f.hands[0].palm_position.x == 10);
+    // the hand keeps fingers 2 and 3
+    VERIFY (f.hands[0].fingers == 0x6);
+    interpolate (a, b, 3, 3, f);
+    VERIFY (f.id == 13);
+    VERIFY (f.ts == 130000);
+    VERIFY (f.s[0].id == 2);
+    VERIFY (f.s[0].position.x == -10);
+    VERIFY (f.s[1].id == 1);
+    VERIFY (f.s[1].position.x == 60);
+    VERIFY (f.hands[0].fingers == 0x5);
+    if (verbose)
+        for (auto &i : f.s)
+            clog << i.id << " " << i.position << endl;
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_detector (verbose);
+        test_interpolate (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
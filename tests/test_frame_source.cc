@@ -0,0 +1,278 @@
+/// @file test_frame_source.cc
+/// @brief test frame sources
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-25
+
+#include "../async_frame_listener.h"
+#include "../recording_frame_source.h"
+#include "verify.h"
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_frame_source [verbose]";
+
+struct counter : public frame_listener
+{
+    size_t frames;
+    size_t errors;
+    uint64_t last_ts;
+    counter ()
+        : frames (0)
+        , errors (0)
+        , last_ts (0)
+    {
+    }
+    // called on the source's thread, so just count errors
+    virtual void on_frame (const frame &f)
+    {
+        if (f.ts < last_ts
+            || f.id != static_cast<int64_t> (frames)
+            || f.s.size () != frames % 6)
+            ++errors;
+        last_ts = f.ts;
+        ++frames;
+    }
+};
+
+/// @brief generate N frames, 1ms apart
+struct generator
+{
+    size_t n;
+    size_t total;
+    generator (size_t total)
+        : n (0)
+        , total (total)
+    {
+    }
+    bool operator() (frame &f)
+    {
+        if (n == total)
+            return false;
+        f.id = n;
+        f.ts = n * 1000;
+        f.s.resize (n % 6);
+        ++n;
+        return true;
+    }
+};
+
+/// @brief generate N frames, 1ms apart, with the clock starting over from zero halfway through, like it does when
+/// the device restarts
+struct restarting_generator
+{
+    size_t n;
+    size_t total;
+    restarting_generator (size_t total)
+        : n (0)
+        , total (total)
+    {
+    }
+    bool operator() (frame &f)
+    {
+        if (n == total)
+            return false;
+        f.id = n;
+        f.ts = n < total / 2 ? 1000000000 + n * 1000 : (n - total / 2) * 1000;
+        f.s.resize (n % 6);
+        ++n;
+        return true;
+    }
+};
+
+double run (frame_source &src, counter &c)
+{
+    auto start = chrono::steady_clock::now ();
+    src.start (c);
+    while (!src.is_done ())
+        usleep (1000);
+    src.stop ();
+    return chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+}
+
+void test_generated_frame_source (const bool verbose)
+{
+    {
+        // as fast as possible
+        const size_t N = 100000;
+        generated_frame_source src (generator (N), 0.0);
+        counter c;
+        double secs = run (src, c);
+        if (verbose)
+            clog << c.frames << " frames in " << secs << " seconds" << endl;
+        VERIFY (c.frames == N);
+        VERIFY (c.errors == 0);
+    }
+    {
+        // 100ms of frames, replayed at 2x
+        const size_t N = 100;
+        generated_frame_source src (generator (N), 2.0);
+        counter c;
+        double secs = run (src, c);
+        if (verbose)
+            clog << c.frames << " frames in " << secs << " seconds" << endl;
+        VERIFY (c.frames == N);
+        VERIFY (c.errors == 0);
+        VERIFY (secs > 0.045);
+    }
+    {
+        // 100ms of frames in real time, with the clock going backwards in the middle
+        const size_t N = 100;
+        generated_frame_source src (restarting_generator (N), 1.0);
+        counter c;
+        double secs = run (src, c);
+        if (verbose)
+            clog << c.frames << " frames across a restart in " << secs << " seconds" << endl;
+        VERIFY (c.frames == N);
+        // the only frame out of order is the first one after the restart
+        VERIFY (c.errors == 1);
+        VERIFY (secs > 0.09);
+        VERIFY (secs < 1.0);
+    }
+    {
+        // stop it before it's done
+        generated_frame_source src (generator (1000000), 1.0);
+        counter c;
+        src.start (c);
+        usleep (10000);
+        src.stop ();
+        if (verbose)
+            clog << c.frames << " frames before stopping" << endl;
+        VERIFY (c.frames < 1000);
+    }
+}
+
+void test_recording_frame_source (const bool verbose)
+{
+    const string fn ("/tmp/test_frame_source.soma");
+    const size_t N = 1000;
+    {
+        recording_writer w (fn);
+        generator g (N);
+        frame f;
+        while (g (f))
+            w.write (f.id, f.ts, f.s);
+    }
+    recording_frame_source src (fn, 0.0);
+    counter c;
+    double secs = run (src, c);
+    if (verbose)
+        clog << c.frames << " frames in " << secs << " seconds" << endl;
+    VERIFY (c.frames == N);
+    VERIFY (c.errors == 0);
+    unlink (fn.c_str ());
+}
+
+/// @brief a slow listener that only checks the order of the frames
+struct slow_listener : public frame_listener
+{
+    size_t frames;
+    size_t errors;
+    int64_t last_id;
+    slow_listener ()
+        : frames (0)
+        , errors (0)
+        , last_id (-1)
+    {
+    }
+    virtual void on_frame (const frame &f)
+    {
+        if (f.id <= last_id)
+            ++errors;
+        last_id = f.id;
+        ++frames;
+        if (frames % 100 == 0)
+            usleep (1000);
+    }
+};
+
+void test_async_frame_listener (const bool verbose)
+{
+    const size_t N = 100000;
+    slow_listener l;
+    async_frame_listener a (l, 64);
+    generated_frame_source src (generator (N), 0.0);
+    src.start (a);
+    while (!src.is_done ())
+        usleep (1000);
+    src.stop ();
+    a.stop ();
+    if (verbose)
+        print_stats (clog, a);
+    VERIFY (l.errors == 0);
+    VERIFY (l.frames == a.get_processed ());
+    VERIFY (a.get_queued () == a.get_processed ());
+    VERIFY (a.get_queued () + a.get_overflows () == N);
+    VERIFY (a.get_max_occupancy () <= a.capacity ());
+    VERIFY (a.occupancy () == 0);
+}
+
+void test_wait_for_room (const bool verbose)
+{
+    // a generator isn't live, so nothing is dropped even though it is much faster than the listener
+    const size_t N = 20000;
+    slow_listener l;
+    async_frame_listener a (l, 64);
+    generated_frame_source src (generator (N), 0.0);
+    VERIFY (!src.is_live ());
+    a.set_wait_for_room (!src.is_live ());
+    src.start (a);
+    while (!src.is_done ())
+        usleep (1000);
+    src.stop ();
+    a.stop ();
+    if (verbose)
+        print_stats (clog, a);
+    VERIFY (l.errors == 0);
+    VERIFY (l.frames == N);
+    VERIFY (a.get_overflows () == 0);
+    VERIFY (a.get_processed () == N);
+    VERIFY (a.get_full_waits () > 0);
+}
+
+void test_can_wait (const bool verbose)
+{
+    // the first 150 frames can wait, so they wake the processing thread a few at a time
+    const size_t N = 200;
+    slow_listener l;
+    async_frame_listener a (l, 64);
+    a.set_can_wait ([] (const frame &f) { return f.id < 150; });
+    generated_frame_source src (generator (N), 1.0);
+    src.start (a);
+    while (!src.is_done ())
+        usleep (1000);
+    src.stop ();
+    a.stop ();
+    if (verbose)
+        print_stats (clog, a);
+    VERIFY (l.errors == 0);
+    VERIFY (a.get_processed () == N);
+    VERIFY (a.get_deferred () > 100);
+    VERIFY (a.get_deferred () < 150);
+    VERIFY (a.get_wakeups () < N - 100);
+    // the frames that were held on purpose don't count against the queueing delay
+    VERIFY (a.mean_deferred_delay () > a.mean_delay ());
+    VERIFY (a.get_max_deferred_delay () > 1000);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_generated_frame_source (verbose);
+        test_recording_frame_source (verbose);
+        test_async_frame_listener (verbose);
+        test_wait_for_room (verbose);
+        test_can_wait (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
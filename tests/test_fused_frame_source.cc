@@ -0,0 +1,182 @@
+/// @file test_fused_frame_source.cc
+/// @brief test fused_frame_source class
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-07
+
+#include "../event_loop.h"
+#include "../frame_sources.h"
+#include "../fused_frame_source.h"
+#include "../hand_motion_generator.h"
+#include "verify.h"
+#include <iostream>
+#include <set>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_fused_frame_source [verbose]";
+
+/// @brief keep the fused frames, calls are serialized by the fused source
+struct collector : public frame_listener
+{
+    vector<frame> frames;
+    virtual void on_frame (const frame &f)
+    {
+        frames.push_back (f);
+    }
+};
+
+/// @brief run a fused source until all of its sources are done
+void run (fused_frame_source &f, collector &c)
+{
+    event_loop loop;
+    loop.quit_when (f.get_done ());
+    f.start (c);
+    loop.run ();
+    f.stop ();
+}
+
+/// @brief a source whose fingers are at fixed places, 10ms apart
+unique_ptr<frame_source> fixed_source (const vector<float> &x, uint64_t start_ts)
+{
+    size_t n = 0;
+    return unique_ptr<frame_source> (new generated_frame_source ([=] (frame &f) mutable
+        {
+            if (n == 20)
+                return false;
+            f.id = n;
+            f.ts = start_ts + n * 10000;
+            f.s.resize (x.size ());
+            for (size_t i = 0; i < x.size (); ++i)
+            {
+                f.s[i].id = i + 1;
+                f.s[i].position = vec3 (x[i], 200, 0);
+                f.s[i].direction = vec3 (0, 0, -1);
+            }
+            ++n;
+            return true;
+        }, 1.0));
+}
+
+void test_matching (const bool verbose)
+{
+    // the sources use the same finger ids, one finger is seen by both, and each sees a finger the other can't
+    fused_frame_source f;
+    f.add_source (fixed_source (vector<float> { 0, 100 }, 1000000));
+    f.add_source (fixed_source (vector<float> { 4, 200 }, 7001000000ULL));
+    collector c;
+    run (f, c);
+    VERIFY (c.frames.size () == 40);
+    set<int32_t> ids;
+    for (size_t i = 0; i < c.frames.size (); ++i)
+    {
+        const frame &x = c.frames[i];
+        VERIFY (x.id == static_cast<int64_t> (i));
+        VERIFY (i == 0 || x.ts > c.frames[i - 1].ts);
+        // once both sources have sent a frame
+        if (i < 2)
+            continue;
+        VERIFY (x.s.size () == 3);
+        VERIFY (x.s[0].position.x > 0 && x.s[0].position.x < 4);
+        VERIFY (fabs (x.s[1].position.x - 100) < 0.01);
+        VERIFY (fabs (x.s[2].position.x - 200) < 0.01);
+        for (auto &j : x.s)
+            ids.insert (j.id);
+    }
+    if (verbose)
+        print_stats (clog, f);
+    // the fused ids don't collide and don't change
+    VERIFY (ids.size () == 3);
+    // 7000 seconds apart, give or take how far apart the sources were started
+    const int64_t d = f.get_stats (0).offset - f.get_stats (1).offset;
+    VERIFY (d > 6999990000LL && d < 7000010000LL);
+}
+
+void test_noise (const bool verbose)
+{
+    // the same hand motion seen by a good and a bad controller, whose clocks are 5 seconds apart
+    const size_t N = 240;
+    hand_motion_parameters p;
+    p.flicker = 0.0;
+    p.id_swap = 0.0;
+    hand_motion_parameters q (p);
+    q.noise = 3.0;
+    hand_motion_frames a (p, N);
+    hand_motion_frames b (q, N);
+    fused_frame_source f;
+    f.add_source (unique_ptr<frame_source> (new generated_frame_source (a, 1.0)));
+    f.add_source (unique_ptr<frame_source> (new generated_frame_source ([&] (frame &x)
+        {
+            if (!b (x))
+                return false;
+            x.ts += 5000000;
+            return true;
+        }, 1.0)));
+    collector c;
+    run (f, c);
+    const fusion_source_stats sa = f.get_stats (0);
+    const fusion_source_stats sb = f.get_stats (1);
+    size_t doubled = 0;
+    set<int32_t> ids;
+    for (size_t i = 0; i < c.frames.size (); ++i)
+    {
+        const frame &x = c.frames[i];
+        VERIFY (i == 0 || x.ts > c.frames[i - 1].ts);
+        VERIFY (x.nhands == 1);
+        VERIFY (x.hands[0].size () == x.s.size ());
+        doubled += x.s.size () > 5;
+        for (auto &j : x.s)
+            ids.insert (j.id);
+    }
+    if (verbose)
+    {
+        print_stats (clog, f);
+        clog << doubled << " frames with unmatched fingers" << endl;
+        clog << ids.size () << " fused finger ids" << endl;
+    }
+    VERIFY (c.frames.size () == 2 * N);
+    VERIFY (sa.frames == N);
+    VERIFY (sb.frames == N);
+    // the bad controller gets less weight
+    VERIFY (sb.noise > 4 * sa.noise);
+    // fingers are only unmatched when the hand changes shape between the two sources' frames
+    VERIFY (doubled < N / 10);
+    VERIFY (ids.size () < 30);
+    const int64_t d = sa.offset - sb.offset;
+    VERIFY (d > 4990000 && d < 5010000);
+}
+
+void test_args (const bool verbose)
+{
+    char a[] = "a.soma";
+    char b[] = "b.soma";
+    char s[] = "2";
+    char plus[] = "+";
+    char *one[] = { a, s };
+    char *two[] = { a, s, plus, b };
+    char *empty[] = { a, plus };
+    char *three[] = { a, s, s, plus, b };
+    VERIFY (valid_frame_source_args (0, 0));
+    VERIFY (valid_frame_source_args (2, one));
+    VERIFY (valid_frame_source_args (4, two));
+    VERIFY (!valid_frame_source_args (2, empty));
+    VERIFY (!valid_frame_source_args (5, three));
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_matching (verbose);
+        test_noise (verbose);
+        test_args (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,134 @@
+/// @file test_hand_motion_generator.cc
+/// @brief test hand_motion_generator class
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-26
+
+#include "../hand_motion_generator.h"
+#include "verify.h"
+#include <iostream>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_hand_motion_generator [verbose]";
+
+size_t expected_fingers (const gesture g)
+{
+    switch (g)
+    {
+        default: assert (0); // logic error
+        case gesture::none: return 0;
+        case gesture::pointing1: return 1;
+        case gesture::pointing2: return 2;
+        case gesture::pinching: return 2;
+        case gesture::scrolling: return 3;
+        case gesture::centering: return 5;
+    }
+}
+
+void test_hand_motion_generator (const bool verbose)
+{
+    hand_motion_parameters p;
+    p.fps = 200;
+    p.noise = 0.0;
+    p.flicker = 0.0;
+    p.id_swap = 0.0;
+    hand_motion_generator g (p);
+    const size_t N = 100000;
+    frame f;
+    gesture_label l;
+    uint64_t last_ts = 0;
+    size_t onsets = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        g.next (f, l);
+        VERIFY (f.id == static_cast<int64_t> (i));
+        VERIFY (f.ts > last_ts);
+        if (i > 0)
+            VERIFY (f.ts - last_ts >= 4999 && f.ts - last_ts <= 5001);
+        last_ts = f.ts;
+        VERIFY (l.onset_ts <= f.ts);
+        if (l.onset)
+        {
+            VERIFY (l.onset_ts == f.ts);
+            ++onsets;
+        }
+        VERIFY (!l.flicker && !l.id_swap);
+        VERIFY (f.s.size () == expected_fingers (l.g));
+        for (size_t j = 1; j < f.s.size (); ++j)
+            VERIFY (f.s[j - 1].position.x <= f.s[j].position.x);
+    }
+    if (verbose)
+        clog << onsets << " gestures in " << N << " frames" << endl;
+    // gestures last between 1 and 3 seconds
+    VERIFY (onsets >= N / p.fps / 3);
+    VERIFY (onsets <= N / p.fps + 1);
+}
+
+void test_flicker (const bool verbose)
+{
+    hand_motion_parameters p;
+    p.flicker = 0.1;
+    p.id_swap = 0.1;
+    hand_motion_generator g (p);
+    const size_t N = 100000;
+    frame f;
+    gesture_label l;
+    size_t flickers = 0;
+    size_t swaps = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        g.next (f, l);
+        if (l.flicker)
+        {
+            ++flickers;
+            VERIFY (f.s.size () != expected_fingers (l.g));
+        }
+        else
+            VERIFY (f.s.size () == expected_fingers (l.g));
+        swaps += l.id_swap;
+    }
+    if (verbose)
+        clog << flickers << " flickers, " << swaps << " id swaps" << endl;
+    VERIFY (flickers > N / 20 && flickers < N / 5);
+    VERIFY (swaps > 0);
+}
+
+void test_classification (const bool verbose)
+{
+    // with a little noise, the classifier should agree with the ground truth most of the time
+    hand_motion_parameters p;
+    hand_motion_generator g (p);
+    hand_shape_classifier hsc (200000);
+    const size_t N = 100000;
+    frame f;
+    gesture_label l;
+    size_t agree = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        g.next (f, l);
+        hsc.add (f.ts, f.s);
+        agree += (hsc.get_shape () == expected_shape (l.g));
+    }
+    if (verbose)
+        clog << agree * 100.0 / N << "% agreement" << endl;
+    VERIFY (agree > N * 8 / 10);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_hand_motion_generator (verbose);
+        test_flicker (verbose);
+        test_classification (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
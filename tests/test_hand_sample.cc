@@ -0,0 +1,130 @@
+/// @file test_hand_sample.cc
+/// @brief test hand_sample class
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-29
+
+#include "../frame_source.h"
+#include "../mouse_clicker.h"
+#include "../spsc_ring.h"
+#include "verify.h"
+#include <iostream>
+#include <new>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_hand_sample [verbose]";
+
+/// @brief count heap allocations
+size_t allocations = 0;
+
+void *operator new (size_t sz)
+{
+    ++allocations;
+    void *p = malloc (sz ? sz : 1);
+    if (!p)
+        throw bad_alloc ();
+    return p;
+}
+
+void operator delete (void *p) noexcept
+{
+    free (p);
+}
+
+void operator delete (void *p, size_t) noexcept
+{
+    free (p);
+}
+
+void fill (hand_sample &s, size_t n, size_t i)
+{
+    s.clear ();
+    for (size_t j = 0; j < n; ++j)
+    {
+        finger f;
+        f.id = j;
+        f.position = vec3 ((i * 7 + j * 13) % 100, 200, 0);
+        s.push_back (f);
+    }
+}
+
+void test_hand_sample (const bool verbose)
+{
+    hand_sample s;
+    VERIFY (s.empty ());
+    VERIFY (s.capacity () == hand_sample::MAX_FINGERS);
+    fill (s, 3, 0);
+    VERIFY (s.size () == 3);
+    VERIFY (s[2].id == 2);
+    VERIFY (s.back ().id == 2);
+    hand_sample t (s);
+    VERIFY (t.size () == 3);
+    VERIFY (equal (s.begin (), s.end (), t.begin (), [] (const finger &a, const finger &b) { return a.id == b.id; }));
+    t.resize (5);
+    VERIFY (t.size () == 5);
+    VERIFY (t[4].id == finger ().id);
+    t.pop_back ();
+    VERIFY (t.size () == 4);
+    t = s;
+    VERIFY (t.size () == 3);
+    hand_sample u (s.begin () + 1, s.end ());
+    VERIFY (u.size () == 2);
+    VERIFY (u[0].id == 1);
+    fill (s, hand_sample::MAX_FINGERS, 1);
+    sort (s.begin (), s.end (), sort_left_to_right);
+    for (size_t i = 1; i < s.size (); ++i)
+        VERIFY (s[i - 1].position.x <= s[i].position.x);
+}
+
+void test_no_allocations (const bool verbose)
+{
+    const size_t N = 100000;
+    spsc_ring<frame> ring (16);
+    pinch_detector pd;
+    frame f;
+    hand_sample s;
+    // warm up
+    fill (f.s, 2, 0);
+    ring.push (f);
+    ring.pop ();
+    pd.update (0, f.s);
+    const size_t before = allocations;
+    for (size_t i = 0; i < N; ++i)
+    {
+        // get a sample, queue it, and use it the way the pipeline does
+        fill (s, i % 6, i);
+        sort (s.begin (), s.end (), sort_left_to_right);
+        f.id = i;
+        f.ts = i * 10000;
+        f.s = s;
+        ring.push (f);
+        frame *q = ring.front ();
+        VERIFY (q);
+        hand_sample tmp (q->s);
+        sort (tmp.begin (), tmp.end (), sort_left_to_right);
+        pd.update (q->ts, tmp);
+        ring.pop ();
+    }
+    const size_t n = allocations - before;
+    if (verbose)
+        clog << n << " allocations in " << N << " frames" << endl;
+    VERIFY (n == 0);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_hand_sample (verbose);
+        test_no_allocations (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
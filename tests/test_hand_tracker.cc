@@ -0,0 +1,204 @@
+/// @file test_hand_tracker.cc
+/// @brief test hand_tracker class
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-06
+
+#include "../hand_motion_generator.h"
+#include "../hand_tracker.h"
+#include "verify.h"
+#include <iostream>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_hand_tracker [verbose]";
+
+hand make_hand (int32_t id, float x)
+{
+    hand h;
+    h.id = id;
+    h.palm_position = vec3 (x, 200, 0);
+    h.palm_normal = vec3 (0, -1, 0);
+    return h;
+}
+
+void test_split (const bool verbose)
+{
+    hand h[MAX_SPLIT_HANDS];
+    hand_sample s[MAX_SPLIT_HANDS];
+    frame f;
+    f.s.resize (7);
+    for (size_t i = 0; i < f.s.size (); ++i)
+        f.s[i].id = i;
+    // no hands, so all the fingers are one hand
+    VERIFY (split_hands (f, h, s) == 1);
+    VERIFY (h[0].id == -1);
+    VERIFY (s[0].size () == 7);
+    // grouped
+    f.has_hands = true;
+    f.nhands = 2;
+    f.hands[0] = make_hand (10, -100);
+    f.hands[0].fingers = 0x07;
+    f.hands[1] = make_hand (11, 100);
+    f.hands[1].fingers = 0x58;
+    VERIFY (f.hands[0].size () == 3);
+    VERIFY (f.hands[1].size () == 3);
+    // finger 5 isn't in either hand
+    VERIFY (split_hands (f, h, s) == 3);
+    VERIFY (h[0].id == 10);
+    VERIFY (h[1].id == 11);
+    VERIFY (h[2].id == -1);
+    VERIFY (s[2].size () == 1);
+    VERIFY (s[2][0].id == 5);
+    VERIFY (s[0].size () == 3);
+    VERIFY (s[0][2].id == 2);
+    VERIFY (s[1].size () == 3);
+    VERIFY (s[1][0].id == 3);
+    VERIFY (s[1][1].id == 4);
+    VERIFY (s[1][2].id == 6);
+    // the extra hand's palm is in the middle of its fingers
+    for (size_t i = 0; i < f.s.size (); ++i)
+        f.s[i].position = vec3 (i * 10.0f, 200, 0);
+    f.hands[1].fingers = 0x18;
+    VERIFY (split_hands (f, h, s) == 3);
+    VERIFY (h[0].id == 10);
+    VERIFY (h[1].id == 11);
+    VERIFY (h[2].id == -1);
+    VERIFY (h[2].fingers == 0x60);
+    VERIFY (s[2].size () == 2);
+    VERIFY (s[2][0].id == 5);
+    VERIFY (s[2][1].id == 6);
+    VERIFY (h[2].palm_position == vec3 (55, 200, 0));
+    // a grouped frame whose fingers weren't attached to a hand
+    f.nhands = 0;
+    VERIFY (split_hands (f, h, s) == 1);
+    VERIFY (h[0].id == -1);
+    VERIFY (s[0].size () == 7);
+    // a grouped frame with nothing in view
+    f.s.clear ();
+    VERIFY (split_hands (f, h, s) == 0);
+}
+
+void test_policy (const bool verbose)
+{
+    const hand_policy policies[] = { hand_policy::first, hand_policy::right, hand_policy::left };
+    for (auto p : policies)
+    {
+        VERIFY (to_hand_policy (to_string (p)) == p);
+        hand_tracker<int> t (0, 100000, p);
+        // the left hand shows up first
+        hand h[2] = { make_hand (1, -100), make_hand (2, 100) };
+        VERIFY (t.update (0, h, 1) == 0);
+        VERIFY (t.has_changed ());
+        // the right hand joins, but the driver doesn't change
+        VERIFY (t.update (10000, h, 2) == 0);
+        VERIFY (!t.has_changed ());
+        VERIFY (t.get_driver () == 1);
+        // the driver leaves for good
+        VERIFY (t.update (20000, h + 1, 1) == -1);
+        VERIFY (t.get_driver () == 1);
+        VERIFY (t.update (200000, h + 1, 1) == 0);
+        VERIFY (t.has_changed ());
+        VERIFY (t.get_driver () == 2);
+        // both show up at once
+        hand_tracker<int> u (0, 100000, p);
+        VERIFY (u.update (0, h, 2) == (p == hand_policy::right ? 1 : 0));
+        if (verbose)
+            clog << to_string (p) << " chose hand " << u.get_driver () << endl;
+    }
+    bool failed = false;
+    try { to_hand_policy ("middle"); }
+    catch (...) { failed = true; }
+    VERIFY (failed);
+}
+
+void test_linger (const bool verbose)
+{
+    hand_tracker<int> t (0, 100000);
+    hand a = make_hand (1, 0);
+    hand b = make_hand (2, 200);
+    VERIFY (t.update (0, &a, 1) == 0);
+    t.get (1) = 42;
+    // the hand drops out for a few frames, and the other hand can't take over
+    VERIFY (t.update (10000, &b, 1) == -1);
+    VERIFY (t.get_driver () == 1);
+    VERIFY (t.size () == 2);
+    // it comes back with a new id, close to where it was
+    a.id = 3;
+    a.palm_position.x += 10;
+    VERIFY (t.update (50000, &a, 1) == 0);
+    VERIFY (!t.has_changed ());
+    VERIFY (t.get_driver () == 3);
+    VERIFY (t.get (3) == 42);
+    // a new hand far away does not take over the state
+    b.id = 4;
+    hand both[2] = { a, b };
+    VERIFY (t.update (60000, both, 2) == 0);
+    VERIFY (t.get (4) == 0);
+    // hands that are gone too long are forgotten
+    VERIFY (t.update (500000, &a, 1) == 0);
+    VERIFY (t.size () == 1);
+}
+
+void test_spurious_hand (const bool verbose)
+{
+    hand_motion_parameters p;
+    p.second_hand = 0.002;
+    p.flicker = 0.0;
+    hand_motion_generator g (p);
+    // one classifier for all the fingers, like before frames had hands
+    hand_shape_classifier all (200000);
+    hand_tracker<hand_shape_classifier> t (hand_shape_classifier (200000), 500000);
+    size_t all_changes = 0;
+    size_t hand_changes = 0;
+    size_t driver_changes = 0;
+    size_t second_hands = 0;
+    frame f;
+    gesture_label l;
+    for (size_t i = 0; i < 50000; ++i)
+    {
+        g.next (f, l);
+        second_hands += l.second_hand;
+        all.add (f.ts, f.s);
+        all_changes += all.has_changed ();
+        hand h[MAX_SPLIT_HANDS];
+        hand_sample s[MAX_SPLIT_HANDS];
+        const size_t n = split_hands (f, h, s);
+        const int d = t.update (f.ts, h, n);
+        driver_changes += t.has_changed ();
+        for (size_t j = 0; j < n; ++j)
+            t.get (h[j].id).add (f.ts, s[j]);
+        VERIFY (d != -1);
+        VERIFY (s[d].size () <= 5);
+        hand_changes += t.get (h[d].id).has_changed ();
+    }
+    if (verbose)
+    {
+        clog << second_hands << " frames with a second hand" << endl;
+        clog << all_changes << " shape changes using all fingers" << endl;
+        clog << hand_changes << " shape changes using the pointer hand" << endl;
+    }
+    VERIFY (second_hands > 1000);
+    // the first hand drives the whole time
+    VERIFY (driver_changes == 1);
+    VERIFY (3 * hand_changes < 2 * all_changes);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_split (verbose);
+        test_policy (verbose);
+        test_linger (verbose);
+        test_spurious_hand (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,99 @@
+/// @file test_idle_detector.cc
+/// @brief test idle_detector
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-11
+
+#include "../idle_detector.h"
+#include "verify.h"
+#include <iostream>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_idle_detector [verbose]";
+
+frame make_frame (uint64_t ts, size_t fingers)
+{
+    frame f;
+    f.id = ts / 10000;
+    f.ts = ts;
+    f.s.resize (fingers);
+    return f;
+}
+
+void test_idle (const bool verbose)
+{
+    idle_detector d (100000);
+    VERIFY (!d.is_idle ());
+    // a hand
+    VERIFY (!d.update (make_frame (0, 2)));
+    // no fingers, but not for long enough
+    for (uint64_t ts = 10000; ts < 100000; ts += 10000)
+        VERIFY (!d.update (make_frame (ts, 0)));
+    VERIFY (!d.is_idle ());
+    // now it's been long enough
+    for (uint64_t ts = 100000; ts < 200000; ts += 10000)
+        VERIFY (d.update (make_frame (ts, 0)));
+    VERIFY (d.is_idle ());
+    // the first frame with fingers in it goes through
+    VERIFY (!d.update (make_frame (200000, 1)));
+    VERIFY (!d.is_idle ());
+    VERIFY (!d.update (make_frame (210000, 0)));
+    VERIFY (d.get_frames () == 22);
+    VERIFY (d.get_idle_frames () == 10);
+    VERIFY (d.get_idle_periods () == 1);
+    // the clock starts over, so the wait starts over
+    VERIFY (!d.update (make_frame (5000, 0)));
+    VERIFY (d.update (make_frame (105000, 0)));
+    VERIFY (d.get_idle_periods () == 2);
+    // costs of frames without fingers estimate the savings
+    d.add_cost (make_frame (0, 0), 10);
+    d.add_cost (make_frame (0, 0), 30);
+    d.add_cost (make_frame (0, 3), 1000);
+    VERIFY (d.empty_frame_cost () == 20.0);
+    VERIFY (d.cpu_saved () == 11 * 20.0);
+    if (verbose)
+        print_stats (clog, d);
+}
+
+void test_off (const bool verbose)
+{
+    idle_detector d (0);
+    for (uint64_t ts = 0; ts < 1000000; ts += 10000)
+        VERIFY (!d.update (make_frame (ts, 0)));
+    VERIFY (!d.is_idle ());
+    VERIFY (d.get_idle_frames () == 0);
+    if (verbose)
+        print_stats (clog, d);
+}
+
+void test_cpu (const bool verbose)
+{
+    const uint64_t start = thread_cpu_now ();
+    volatile double x = 0.0;
+    for (int i = 0; i < 10000000; ++i)
+        x += i;
+    const uint64_t t = thread_cpu_now () - start;
+    if (verbose)
+        clog << t << "us" << endl;
+    VERIFY (t > 0);
+    VERIFY (t < 10000000);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_idle (verbose);
+        test_off (verbose);
+        test_cpu (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
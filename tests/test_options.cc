@@ -23,6 +23,10 @@ void test_options (const bool verbose)
     {
         options opts;
         opts.set_sound (true);
+        opts.set_record (true);
+        opts.set_pointer_hand ("right");
+        opts.set_fill_gaps (3);
+        opts.set_idle_seconds (2.5);
         write (opts, config_fn);
     }
     {
@@ -37,6 +41,10 @@ void test_options (const bool verbose)
         VERIFY (opts.get_major_revision () == MAJOR_REVISION);
         VERIFY (opts.get_minor_revision () == MINOR_REVISION);
         VERIFY (opts.get_sound () == true);
+        VERIFY (opts.get_record () == true);
+        VERIFY (opts.get_pointer_hand () == "right");
+        VERIFY (opts.get_fill_gaps () == 3);
+        VERIFY (opts.get_idle_seconds () == 2.5);
     }
     {
         options opts;
@@ -54,12 +62,40 @@ void test_options (const bool verbose)
     }
 }
 
+void test_old_options (const bool verbose)
+{
+    string config_fn = get_config_dir () + "/tmprc";
+    {
+        // written before there was a flight recorder
+        ofstream ofs (config_fn.c_str ());
+        ofs << "major_revision " << MAJOR_REVISION << endl;
+        ofs << "minor_revision 1" << endl;
+        ofs << "sound 1" << endl;
+        ofs << "mouse_speed 3" << endl;
+    }
+    options opts;
+    read (opts, config_fn);
+    VERIFY (opts.get_minor_revision () == 1);
+    VERIFY (opts.get_sound () == true);
+    VERIFY (opts.get_mouse_speed () == 3);
+    VERIFY (opts.get_flight_seconds () == options ().get_flight_seconds ());
+    VERIFY (opts.get_flight_trigger () == options ().get_flight_trigger ());
+    VERIFY (opts.get_record () == options ().get_record ());
+    VERIFY (opts.get_record_mb () == options ().get_record_mb ());
+    VERIFY (opts.get_pointer_hand () == options ().get_pointer_hand ());
+    VERIFY (opts.get_fill_gaps () == options ().get_fill_gaps ());
+    // filling gaps is something you ask for
+    VERIFY (options ().get_fill_gaps () == 0);
+    VERIFY (opts.get_idle_seconds () == options ().get_idle_seconds ());
+}
+
 int main (int argc, char **)
 {
     try
     {
         const bool verbose = (argc > 1);
         test_options (verbose);
+        test_old_options (verbose);
 
         return 0;
     }
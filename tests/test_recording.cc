@@ -0,0 +1,420 @@
+/// @file test_recording.cc
+/// @brief test recording format
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-24
+
+#include "../hand_motion_generator.h"
+#include "../hand_shape_classifier.h"
+#include "../mouse_pointer.h"
+#include "../recording.h"
+#include "verify.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_recording [verbose]";
+
+const string fn ("/tmp/test_recording.soma");
+
+hand_sample random_sample ()
+{
+    vector<finger> f (rand () % 6);
+    for (auto &i : f)
+    {
+        i.id = rand () % 100;
+        i.position = vec3 (rand () % 200 - 100, rand () % 300, rand () % 200 - 100);
+        i.velocity = vec3 (rand () % 10, rand () % 10, rand () % 10);
+        i.direction = vec3 (0, 0, -1);
+    }
+    sort (f.begin (), f.end (), sort_left_to_right);
+    return hand_sample (f.begin (), f.end ());
+}
+
+namespace soma
+{
+
+bool operator== (const finger &a, const finger &b)
+{
+    return a.id == b.id
+        && a.position == b.position
+        && a.velocity == b.velocity
+        && a.direction == b.direction;
+}
+
+}
+
+void test_recording (const bool verbose)
+{
+    const size_t N = 10000;
+    vector<hand_sample> samples;
+    {
+        recording_writer w (fn);
+        for (size_t i = 0; i < N; ++i)
+        {
+            samples.push_back (random_sample ());
+            w.write (i, i * 10000, samples.back ());
+        }
+        VERIFY (w.get_frames () == N);
+    }
+    recording_reader r (fn);
+    if (verbose)
+        clog << r.header ().frames << " frames" << endl;
+    VERIFY (r.header ().frames == N);
+    size_t n = 0;
+    for (auto f : r)
+    {
+        VERIFY (f.id () == static_cast<int64_t> (n));
+        VERIFY (f.timestamp () == n * 10000);
+        hand_sample s (f.begin (), f.end ());
+        VERIFY (s.size () == samples[n].size ());
+        VERIFY (equal (s.begin (), s.end (), samples[n].begin ()));
+        ++n;
+    }
+    VERIFY (n == N);
+}
+
+void test_truncated (const bool verbose)
+{
+    {
+        recording_writer w (fn);
+        hand_sample s = random_sample ();
+        while (s.empty ())
+            s = random_sample ();
+        w.write (0, 0, s);
+        w.write (1, 10000, s);
+    }
+    // chop off the index and part of the last finger, like a recording that was never closed
+    uint64_t index = 0;
+    {
+        recording_reader r (fn);
+        index = r.header ().index;
+    }
+    VERIFY (index > sizeof (recording_header));
+    VERIFY (truncate (fn.c_str (), index - 1) == 0);
+    recording_reader r (fn);
+    size_t n = 0;
+    for (auto f : r)
+    {
+        VERIFY (f.id () == 0);
+        ++n;
+    }
+    if (verbose)
+        clog << n << " complete frames" << endl;
+    VERIFY (n == 1);
+}
+
+vector<frame> write_motion (size_t n)
+{
+    hand_motion_generator g ((hand_motion_parameters ()));
+    vector<frame> frames (n);
+    gesture_label l;
+    recording_writer w (fn);
+    for (auto &f : frames)
+    {
+        g.next (f, l);
+        w.write (f.id, f.ts, f.s);
+    }
+    return frames;
+}
+
+void verify_seek (const recording_reader &r, const vector<frame> &frames)
+{
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        // anywhere from before the first frame to after the last one
+        const uint64_t ts = rand () % (frames.back ().ts + 20000);
+        auto j = lower_bound (frames.begin (), frames.end (), ts,
+            [] (const frame &f, uint64_t t) { return f.ts < t; });
+        auto k = r.seek (ts);
+        if (j == frames.end ())
+            VERIFY (k == r.end ());
+        else
+        {
+            VERIFY (k != r.end ());
+            VERIFY ((*k).id () == j->id);
+        }
+        const size_t n = rand () % (frames.size () + 10);
+        auto m = r.seek_frame (n);
+        if (n >= frames.size ())
+            VERIFY (m == r.end ());
+        else
+        {
+            VERIFY (m != r.end ());
+            VERIFY ((*m).id () == frames[n].id);
+        }
+    }
+    VERIFY (r.seek (0) == r.begin ());
+    VERIFY (r.seek_frame (0) == r.begin ());
+}
+
+void test_seek (const bool verbose)
+{
+    const vector<frame> frames = write_motion (100000);
+    uint64_t index = 0;
+    {
+        recording_reader r (fn);
+        index = r.header ().index;
+        const size_t entries = r.index_end () - r.index_begin ();
+        if (verbose)
+            clog << entries << " index entries" << endl;
+        VERIFY (entries == (frames.size () + RECORDING_INDEX_INTERVAL - 1) / RECORDING_INDEX_INTERVAL);
+        size_t n = 0;
+        for (auto i = r.begin (); i != r.end (); ++i)
+            ++n;
+        VERIFY (n == frames.size ());
+        verify_seek (r, frames);
+    }
+    // without the index it gets built by scanning
+    VERIFY (truncate (fn.c_str (), index) == 0);
+    recording_reader r (fn);
+    VERIFY (r.index_end () - r.index_begin () > 1);
+    verify_seek (r, frames);
+}
+
+// overwrite one field of a stored index entry
+void damage_index (uint64_t index, size_t entry, size_t field, uint64_t value)
+{
+    fstream fs (fn.c_str (), ios::in | ios::out | ios::binary);
+    fs.seekp (index + sizeof (recording_index) + entry * sizeof (recording_index_entry) + field * sizeof (uint64_t));
+    fs.write (reinterpret_cast<const char *> (&value), sizeof (value));
+    VERIFY (fs.good ());
+}
+
+// where the stored index entries were mapped
+const recording_index_entry *stored_entries (const recording_reader &r, uint64_t index)
+{
+    return reinterpret_cast<const recording_index_entry *> (
+        reinterpret_cast<const char *> (&r.header ()) + index + sizeof (recording_index));
+}
+
+void test_damaged_index (const bool verbose)
+{
+    const vector<frame> frames = write_motion (10000);
+    uint64_t index = 0;
+    vector<recording_index_entry> entries;
+    {
+        recording_reader r (fn);
+        index = r.header ().index;
+        entries.assign (r.index_begin (), r.index_end ());
+    }
+    VERIFY (entries.size () > 3);
+    // an offset past the frames, an offset inside the header, and entries out of order
+    const uint64_t damage[][3] = {
+        { 2, 2, index + 1000000 },
+        { 1, 2, 0 },
+        { 2, 0, entries[1].frame },
+        { 3, 1, entries[1].ts },
+        { 3, 2, entries[1].offset },
+    };
+    for (const auto &d : damage)
+    {
+        damage_index (index, d[0], d[1], d[2]);
+        {
+            recording_reader r (fn);
+            // it was rebuilt by scanning
+            VERIFY (r.index_begin () != stored_entries (r, index));
+            VERIFY (r.index_end () - r.index_begin () == static_cast<ptrdiff_t> (entries.size ()));
+            VERIFY (equal (r.index_begin (), r.index_end (), entries.begin (),
+                [] (const recording_index_entry &a, const recording_index_entry &b)
+                { return a.frame == b.frame && a.ts == b.ts && a.offset == b.offset; }));
+            verify_seek (r, frames);
+        }
+        if (verbose)
+            clog << "index entry " << d[0] << " field " << d[1] << " damaged" << endl;
+        damage_index (index, d[0], d[1], reinterpret_cast<const uint64_t *> (&entries[d[0]])[d[1]]);
+    }
+    // repaired, it is used as is
+    recording_reader r (fn);
+    VERIFY (r.index_begin () == stored_entries (r, index));
+}
+
+void test_warm_up (const bool verbose)
+{
+    const vector<frame> frames = write_motion (20000);
+    // replay all of it
+    static const uint64_t WINDOW_DURATION = 200000;
+    vector<hand_shape> shapes;
+    vector<double> xs;
+    {
+        hand_shape_classifier hsc (WINDOW_DURATION);
+        pointer_smoother ps;
+        for (const auto &f : frames)
+        {
+            frame_features ff (f.s);
+            hsc.add (f.ts, ff);
+            shapes.push_back (hsc.get_shape ());
+            if (ff.size () == 1 || ff.size () == 2)
+                ps.update (f.ts, pointer_finger (ff).position.x, pointer_finger (ff).position.y);
+            xs.push_back (ps.x ());
+        }
+    }
+    // seek and compare
+    recording_reader r (fn);
+    const uint64_t SMOOTHER_DURATION = pointer_smoother::DURATION;
+    const uint64_t WARM_UP = max (WINDOW_DURATION, SMOOTHER_DURATION);
+    for (size_t i = 0; i < 20; ++i)
+    {
+        const size_t n = rand () % frames.size ();
+        const uint64_t ts = frames[n].ts;
+        hand_shape_classifier hsc (WINDOW_DURATION);
+        pointer_smoother ps;
+        size_t j = 0;
+        size_t compared = 0;
+        for (auto k = r.warm_up (ts, WARM_UP); k != r.end () && compared < 1000; ++k)
+        {
+            const recorded_frame rf = *k;
+            hand_sample s (rf.begin (), rf.end ());
+            frame_features ff (s);
+            hsc.add (rf.timestamp (), ff);
+            if (ff.size () == 1 || ff.size () == 2)
+                ps.update (rf.timestamp (), pointer_finger (ff).position.x, pointer_finger (ff).position.y);
+            if (rf.timestamp () < ts)
+                continue;
+            j = rf.id ();
+            VERIFY (hsc.get_shape () == shapes[j]);
+            if (ps.x () == ps.x ())
+                VERIFY (fabs (ps.x () - xs[j]) < 1e-6);
+            ++compared;
+        }
+        VERIFY (compared > 0);
+    }
+}
+
+void test_hands (const bool verbose)
+{
+    hand_motion_parameters p;
+    p.second_hand = 0.01;
+    hand_motion_generator g (p);
+    vector<frame> frames (1000);
+    gesture_label l;
+    {
+        recording_writer w (fn);
+        for (auto &f : frames)
+        {
+            g.next (f, l);
+            w.write (f);
+        }
+        // a frame from a source that doesn't group fingers by hand
+        w.write (frames.back ().id + 1, frames.back ().ts + 10000, frames.back ().s);
+    }
+    recording_reader r (fn);
+    VERIFY (r.header ().version == RECORDING_VERSION);
+    size_t n = 0;
+    size_t two = 0;
+    for (auto i : r)
+    {
+        frame f;
+        i.get (f);
+        if (n == frames.size ())
+        {
+            VERIFY (!f.has_hands);
+            VERIFY (f.nhands == 0);
+            VERIFY (f.s.size () == frames.back ().s.size ());
+            ++n;
+            continue;
+        }
+        const frame &e = frames[n++];
+        VERIFY (f.id == e.id);
+        VERIFY (f.has_hands);
+        VERIFY (f.nhands == e.nhands);
+        VERIFY (f.s.size () == e.s.size ());
+        size_t fingers = 0;
+        for (size_t j = 0; j < f.nhands; ++j)
+        {
+            VERIFY (f.hands[j].id == e.hands[j].id);
+            VERIFY (f.hands[j].fingers == e.hands[j].fingers);
+            VERIFY (f.hands[j].palm_position == e.hands[j].palm_position);
+            fingers += f.hands[j].size ();
+        }
+        VERIFY (fingers == f.s.size ());
+        two += f.nhands == 2;
+    }
+    if (verbose)
+        clog << two << " frames with two hands" << endl;
+    VERIFY (n == frames.size () + 1);
+    VERIFY (two > 50);
+}
+
+void test_too_many_fingers (const bool verbose)
+{
+    // a hand made recording whose only frame has more fingers than a hand_sample can hold
+    const size_t N = hand_sample::MAX_FINGERS + 1;
+    {
+        recording_header h;
+        memset (&h, 0, sizeof (h));
+        memcpy (h.magic, RECORDING_MAGIC, sizeof (h.magic));
+        h.version = 1;
+        h.finger_size = sizeof (finger);
+        frame_record r;
+        memset (&r, 0, sizeof (r));
+        r.id = 1;
+        r.ts = 10000;
+        r.nfingers = N;
+        vector<finger> f (N);
+        for (size_t i = 0; i < N; ++i)
+            f[i].id = i;
+        ofstream ofs (fn.c_str (), ios::binary);
+        ofs.write (reinterpret_cast<const char *> (&h), sizeof (h));
+        ofs.write (reinterpret_cast<const char *> (&r), sizeof (r));
+        ofs.write (reinterpret_cast<const char *> (f.data ()), N * sizeof (finger));
+    }
+    recording_reader r (fn);
+    VERIFY (r.begin () != r.end ());
+    const recorded_frame f = *r.begin ();
+    if (verbose)
+        clog << f.size () << " fingers in the record" << endl;
+    VERIFY (f.size () == N);
+    // the extra finger is dropped
+    hand_sample s (f.begin (), f.end ());
+    VERIFY (s.size () == hand_sample::MAX_FINGERS);
+    VERIFY (s.back ().id == static_cast<int> (N) - 2);
+    s.assign (f.begin (), f.end ());
+    VERIFY (s.size () == hand_sample::MAX_FINGERS);
+    frame g;
+    f.get (g);
+    VERIFY (g.s.size () == hand_sample::MAX_FINGERS);
+}
+
+void test_bad_file (const bool verbose)
+{
+    {
+        ofstream ofs (fn.c_str ());
+        ofs << "this is not a recording, but it is long enough to have a header" << endl;
+    }
+    bool failed = false;
+    try { recording_reader r (fn); }
+    catch (const exception &e)
+    {
+        if (verbose)
+            clog << e.what () << endl;
+        failed = true;
+    }
+    VERIFY (failed);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_recording (verbose);
+        test_truncated (verbose);
+        test_seek (verbose);
+        test_damaged_index (verbose);
+        test_warm_up (verbose);
+        test_hands (verbose);
+        test_too_many_fingers (verbose);
+        test_bad_file (verbose);
+        unlink (fn.c_str ());
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,311 @@
+/// @file test_recording_codec.cc
+/// @brief test compressed recording format
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-01
+
+#include "../hand_motion_generator.h"
+#include "../recording.h"
+#include "../recording_codec.h"
+#include "verify.h"
+#include <iostream>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_recording_codec [verbose]";
+
+const string fn ("/tmp/test_recording_codec.somz");
+const string raw_fn ("/tmp/test_recording_codec.soma");
+
+void test_varint (const bool verbose)
+{
+    const int64_t values[] = { 0, 1, -1, 63, -64, 64, 127, 128, -129, 1 << 20, -(1LL << 40), INT64_MAX, INT64_MIN };
+    for (auto i : values)
+    {
+        VERIFY (unzigzag (zigzag (i)) == i);
+        uint8_t buffer[10];
+        uint8_t *end = put_varint (zigzag (i), buffer);
+        VERIFY (end - buffer <= 10);
+        uint64_t x;
+        VERIFY (get_varint (buffer, end, x) == end);
+        VERIFY (unzigzag (x) == i);
+    }
+    // small magnitudes take one byte
+    uint8_t buffer[10];
+    VERIFY (put_varint (zigzag (-64), buffer) == buffer + 1);
+    VERIFY (put_varint (zigzag (63), buffer) == buffer + 1);
+    // a varint that runs past the end of the block
+    uint64_t x;
+    uint8_t *end = put_varint (1 << 20, buffer);
+    bool thrown = false;
+    try { get_varint (buffer, end - 1, x); }
+    catch (const runtime_error &) { thrown = true; }
+    VERIFY (thrown);
+    thrown = false;
+    try { get_varint (buffer, buffer, x); }
+    catch (const runtime_error &) { thrown = true; }
+    VERIFY (thrown);
+    // a varint that is too long for 64 bits
+    uint8_t junk[16];
+    memset (junk, 0xff, sizeof (junk));
+    thrown = false;
+    try { get_varint (junk, junk + sizeof (junk), x); }
+    catch (const runtime_error &) { thrown = true; }
+    VERIFY (thrown);
+}
+
+bool close_to (const vec3 &a, const vec3 &b, float step)
+{
+    // quantization error is at most half a step
+    const float e = step / 2 + 1e-3f;
+    return fabs (a.x - b.x) <= e && fabs (a.y - b.y) <= e && fabs (a.z - b.z) <= e;
+}
+
+void test_round_trip (const bool verbose)
+{
+    hand_motion_parameters hp;
+    hp.second_hand = 0.02;
+    hand_motion_generator g (hp);
+    const size_t N = 50000;
+    vector<frame> frames (N);
+    gesture_label l;
+    codec_parameters p;
+    p.block_frames = 1000;
+    uint64_t raw = 0;
+    {
+        compressed_writer w (fn, p);
+        recording_writer rw (raw_fn);
+        for (auto &f : frames)
+        {
+            g.next (f, l);
+            w.write (f);
+            rw.write (f);
+        }
+        w.close ();
+        rw.close ();
+        raw = rw.get_frames () * sizeof (frame_record);
+        for (const auto &f : frames)
+            raw += f.s.size () * sizeof (finger) + f.nhands * sizeof (hand);
+        VERIFY (w.get_frames () == N);
+        if (verbose)
+        {
+            clog << raw << " raw bytes" << endl;
+            clog << w.get_bytes () << " compressed bytes" << endl;
+            clog << static_cast<double> (raw) / w.get_bytes () << " compression ratio" << endl;
+        }
+        VERIFY (raw > 5 * w.get_bytes ());
+    }
+    compressed_reader r (fn);
+    VERIFY (r.frames () == N);
+    VERIFY (r.size () == N / p.block_frames);
+    VERIFY (r.parameters ().position_step == p.position_step);
+    // decode the blocks one at a time, in reverse, to make sure they are independent
+    vector<frame> decoded (N);
+    for (size_t b = r.size (); b-- > 0; )
+        r.decode (b, &decoded[r.first_frame (b)]);
+    for (size_t i = 0; i < N; ++i)
+    {
+        const frame &a = frames[i];
+        const frame &b = decoded[i];
+        VERIFY (a.id == b.id);
+        VERIFY (a.ts == b.ts);
+        VERIFY (a.s.size () == b.s.size ());
+        for (size_t j = 0; j < a.s.size (); ++j)
+        {
+            VERIFY (a.s[j].id == b.s[j].id);
+            VERIFY (close_to (a.s[j].position, b.s[j].position, p.position_step));
+            VERIFY (close_to (a.s[j].velocity, b.s[j].velocity, p.velocity_step));
+            VERIFY (close_to (a.s[j].direction, b.s[j].direction, p.direction_step));
+        }
+        VERIFY (a.has_hands == b.has_hands);
+        VERIFY (a.nhands == b.nhands);
+        for (size_t j = 0; j < a.nhands; ++j)
+        {
+            VERIFY (a.hands[j].id == b.hands[j].id);
+            VERIFY (a.hands[j].fingers == b.hands[j].fingers);
+            VERIFY (close_to (a.hands[j].palm_position, b.hands[j].palm_position, p.position_step));
+            VERIFY (close_to (a.hands[j].palm_normal, b.hands[j].palm_normal, p.direction_step));
+        }
+    }
+    // parallel decode gives the same frames
+    vector<frame> parallel (N);
+    r.decode (&parallel[0]);
+    for (size_t i = 0; i < N; ++i)
+    {
+        VERIFY (parallel[i].id == decoded[i].id);
+        VERIFY (parallel[i].ts == decoded[i].ts);
+        VERIFY (parallel[i].s.size () == decoded[i].s.size ());
+        for (size_t j = 0; j < decoded[i].s.size (); ++j)
+            VERIFY (parallel[i].s[j].position == decoded[i].s[j].position);
+    }
+}
+
+void test_truncated (const bool verbose)
+{
+    codec_parameters p;
+    p.block_frames = 100;
+    hand_motion_generator g ((hand_motion_parameters ()));
+    frame f;
+    gesture_label l;
+    {
+        compressed_writer w (fn, p);
+        for (size_t i = 0; i < 250; ++i)
+        {
+            g.next (f, l);
+            w.write (f);
+        }
+    }
+    {
+        compressed_reader r (fn);
+        VERIFY (r.frames () == 250);
+        VERIFY (r.size () == 3);
+        VERIFY (r.block_frames (2) == 50);
+    }
+    // chop off part of the last block
+    {
+        FILE *fp = fopen (fn.c_str (), "r+b");
+        VERIFY (fp);
+        VERIFY (fseek (fp, 0, SEEK_END) == 0);
+        const long len = ftell (fp);
+        fclose (fp);
+        VERIFY (truncate (fn.c_str (), len - 10) == 0);
+    }
+    compressed_reader r (fn);
+    VERIFY (r.frames () == 200);
+    VERIFY (r.size () == 2);
+}
+
+/// @brief write a compressed recording of frames in blocks of 100
+void write_frames (size_t n)
+{
+    codec_parameters p;
+    p.block_frames = 100;
+    hand_motion_generator g ((hand_motion_parameters ()));
+    frame f;
+    gesture_label l;
+    compressed_writer w (fn, p);
+    for (size_t i = 0; i < n; ++i)
+    {
+        g.next (f, l);
+        w.write (f);
+    }
+}
+
+/// @brief true if decoding block b of the recording throws
+bool decode_throws (size_t b)
+{
+    compressed_reader r (fn);
+    vector<frame> frames (r.frames ());
+    try { r.decode (b, &frames[r.first_frame (b)]); }
+    catch (const runtime_error &) { return true; }
+    return false;
+}
+
+/// @brief true if decoding all of the recording at once throws
+bool parallel_decode_throws ()
+{
+    compressed_reader r (fn);
+    vector<frame> frames (r.frames ());
+    try { r.decode (&frames[0]); }
+    catch (const runtime_error &) { return true; }
+    return false;
+}
+
+void test_corrupt (const bool verbose)
+{
+    // continuation bits at the start of the first block, so the first varint is too long
+    write_frames (250);
+    {
+        FILE *fp = fopen (fn.c_str (), "r+b");
+        VERIFY (fp);
+        uint8_t junk[64];
+        memset (junk, 0xff, sizeof (junk));
+        VERIFY (fseek (fp, sizeof (codec_header) + sizeof (codec_block), SEEK_SET) == 0);
+        VERIFY (fwrite (junk, sizeof (junk), 1, fp) == 1);
+        fclose (fp);
+    }
+    VERIFY (decode_throws (0));
+    VERIFY (!decode_throws (1));
+    VERIFY (parallel_decode_throws ());
+    // a block that says it is shorter than it is, so its last frame runs past the end of the block
+    write_frames (100);
+    {
+        FILE *fp = fopen (fn.c_str (), "r+b");
+        VERIFY (fp);
+        codec_block b;
+        VERIFY (fseek (fp, sizeof (codec_header), SEEK_SET) == 0);
+        VERIFY (fread (&b, sizeof (b), 1, fp) == 1);
+        b.bytes -= 1;
+        VERIFY (fseek (fp, sizeof (codec_header), SEEK_SET) == 0);
+        VERIFY (fwrite (&b, sizeof (b), 1, fp) == 1);
+        fclose (fp);
+        VERIFY (truncate (fn.c_str (), sizeof (codec_header) + sizeof (codec_block) + b.bytes) == 0);
+    }
+    {
+        compressed_reader r (fn);
+        VERIFY (r.size () == 1);
+    }
+    VERIFY (decode_throws (0));
+    VERIFY (parallel_decode_throws ());
+    // a block that claims more frames than it has bytes is where the recording stops
+    write_frames (250);
+    {
+        FILE *fp = fopen (fn.c_str (), "r+b");
+        VERIFY (fp);
+        codec_block b;
+        VERIFY (fseek (fp, sizeof (codec_header), SEEK_SET) == 0);
+        VERIFY (fread (&b, sizeof (b), 1, fp) == 1);
+        const long second = sizeof (codec_header) + sizeof (codec_block) + b.bytes;
+        VERIFY (fseek (fp, second, SEEK_SET) == 0);
+        VERIFY (fread (&b, sizeof (b), 1, fp) == 1);
+        b.frames = 0xffffffff;
+        VERIFY (fseek (fp, second, SEEK_SET) == 0);
+        VERIFY (fwrite (&b, sizeof (b), 1, fp) == 1);
+        fclose (fp);
+    }
+    {
+        compressed_reader r (fn);
+        VERIFY (r.size () == 1);
+        VERIFY (r.frames () == 100);
+    }
+    VERIFY (!decode_throws (0));
+    VERIFY (!parallel_decode_throws ());
+    if (verbose)
+        clog << "corrupt blocks throw" << endl;
+}
+
+void test_bad_file (const bool verbose)
+{
+    {
+        FILE *fp = fopen (fn.c_str (), "wb");
+        VERIFY (fp);
+        const char junk[64] = "not a compressed recording";
+        VERIFY (fwrite (junk, sizeof (junk), 1, fp) == 1);
+        fclose (fp);
+    }
+    bool thrown = false;
+    try { compressed_reader r (fn); }
+    catch (const runtime_error &) { thrown = true; }
+    VERIFY (thrown);
+}
+
+int main (int argc, char **argv)
+{
+    try
+    {
+        const bool verbose = (argc != 1);
+        test_varint (verbose);
+        test_round_trip (verbose);
+        test_truncated (verbose);
+        test_corrupt (verbose);
+        test_bad_file (verbose);
+        remove (fn.c_str ());
+        remove (raw_fn.c_str ());
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,154 @@
+/// @file test_recording_tee.cc
+/// @brief test recording_tee class
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-04
+
+#include "../hand_motion_generator.h"
+#include "../recording_tee.h"
+#include "verify.h"
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_recording_tee [verbose]";
+
+const string prefix ("/tmp/test_recording_tee");
+
+string filename (size_t n, const string &ext)
+{
+    char s[16];
+    snprintf (s, sizeof (s), "-%04zu", n);
+    return prefix + s + ext;
+}
+
+void remove_files (size_t files)
+{
+    for (size_t i = 0; i < files; ++i)
+    {
+        unlink (filename (i, ".soma").c_str ());
+        unlink (filename (i, ".events").c_str ());
+    }
+}
+
+/// @brief write frames with an event every 10 frames
+void write_frames (recording_tee &t, size_t n)
+{
+    hand_motion_generator g ((hand_motion_parameters ()));
+    frame f;
+    gesture_label l;
+    for (size_t i = 0; i < n; ++i)
+    {
+        g.next (f, l);
+        t.write (f);
+        if (i % 10 == 0)
+        {
+            const mouse_event e = { mouse_event_type::move, 0, 0, 0, static_cast<int32_t> (i), 0 };
+            t.on_event (e);
+        }
+    }
+}
+
+void test_rotation (const bool verbose)
+{
+    const size_t N = 12000;
+    tee_parameters p;
+    // 120 fps, so about 10 files by time
+    p.max_file_duration = 10 * 1000000;
+    recording_tee t (prefix, p);
+    write_frames (t, N);
+    t.stop ();
+    if (verbose)
+        print_stats (clog, t);
+    VERIFY (t.get_dropped_frames () == 0);
+    VERIFY (t.get_dropped_events () == 0);
+    VERIFY (t.get_errors () == 0);
+    VERIFY (t.get_frames () == N);
+    VERIFY (t.get_events () == N / 10);
+    VERIFY (t.get_files () == 10);
+    // read them back
+    int64_t id = 0;
+    size_t events = 0;
+    for (size_t i = 0; i < t.get_files (); ++i)
+    {
+        recording_reader r (filename (i, ".soma"));
+        VERIFY (r.header ().frames > 0);
+        const uint64_t first_ts = (*r.begin ()).timestamp ();
+        for (auto f : r)
+        {
+            VERIFY (f.id () == id++);
+            VERIFY (f.timestamp () - first_ts < p.max_file_duration);
+        }
+        for (auto e : read_event_log (filename (i, ".events")))
+        {
+            VERIFY (e.id % 10 == 0);
+            VERIFY (e.e.type == mouse_event_type::move);
+            VERIFY (e.e.x == e.id);
+            ++events;
+        }
+    }
+    VERIFY (id == static_cast<int64_t> (N));
+    VERIFY (events == N / 10);
+    remove_files (t.get_files ());
+}
+
+void test_size (const bool verbose)
+{
+    tee_parameters p;
+    p.max_file_bytes = 100000;
+    recording_tee t (prefix, p);
+    write_frames (t, 10000);
+    t.stop ();
+    if (verbose)
+        clog << t.get_files () << " files" << endl;
+    VERIFY (t.get_files () > 5);
+    for (size_t i = 0; i < t.get_files (); ++i)
+    {
+        struct stat sb;
+        VERIFY (stat (filename (i, ".soma").c_str (), &sb) == 0);
+        // a file can go over by one frame and the index
+        VERIFY (static_cast<uint64_t> (sb.st_size) < p.max_file_bytes + 4096);
+    }
+    remove_files (t.get_files ());
+}
+
+void test_budget (const bool verbose)
+{
+    tee_parameters p;
+    // room for only a few records, so some have to be dropped
+    p.memory_budget = 8192;
+    recording_tee t (prefix, p);
+    const size_t N = 100000;
+    auto start = chrono::steady_clock::now ();
+    write_frames (t, N);
+    double secs = chrono::duration<double> (chrono::steady_clock::now () - start).count ();
+    t.stop ();
+    if (verbose)
+    {
+        clog << N / secs << " frames/sec" << endl;
+        print_stats (clog, t);
+    }
+    VERIFY (t.capacity () * 500 <= p.memory_budget);
+    VERIFY (t.get_frames () + t.get_dropped_frames () == N);
+    VERIFY (t.get_events () + t.get_dropped_events () == N / 10);
+    remove_files (t.get_files ());
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_rotation (verbose);
+        test_size (verbose);
+        test_budget (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,125 @@
+/// @file test_sample_filter.cc
+/// @brief test sample_filter class
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-08
+
+#include "../hand_motion_generator.h"
+#include "../sample_filter.h"
+#include "verify.h"
+#include <iostream>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_sample_filter [verbose]";
+
+hand_sample make_sample (const vector<int32_t> &ids)
+{
+    hand_sample s;
+    for (auto id : ids)
+    {
+        finger f;
+        f.id = id;
+        s.push_back (f);
+    }
+    return s;
+}
+
+bool same_ids (const hand_sample &a, const hand_sample &b)
+{
+    if (a.size () != b.size ())
+        return false;
+    for (size_t i = 0; i < a.size (); ++i)
+        if (a[i].id != b[i].id)
+            return false;
+    return true;
+}
+
+void test_sample_filter (const bool verbose)
+{
+    sample_filter f (100);
+    VERIFY (!f.is_good (make_sample ({ 1, 2 })));
+    VERIFY (f.update (0, make_sample ({ 1, 2 })));
+    VERIFY (f.update (10, make_sample ({ 1, 2 })));
+    // a spurious finger
+    VERIFY (!f.update (20, make_sample ({ 1, 2, 3 })));
+    // swapped ids
+    VERIFY (!f.update (30, make_sample ({ 2, 1 })));
+    VERIFY (f.update (40, make_sample ({ 1, 2 })));
+    VERIFY (f.get_num_fingers () == 2);
+    VERIFY (f.size () == 5);
+    // three fingers for long enough that they take over
+    for (uint64_t ts = 50; ts < 150; ts += 10)
+        f.update (ts, make_sample ({ 1, 2, 4 }));
+    VERIFY (f.get_num_fingers () == 3);
+    VERIFY (f.is_good (make_sample ({ 1, 2, 4 })));
+    VERIFY (!f.is_good (make_sample ({ 1, 2, 3 })));
+    VERIFY (!f.is_good (make_sample ({ 1, 2 })));
+    f.clear ();
+    VERIFY (f.size () == 0);
+    VERIFY (!f.is_good (make_sample ({ 1, 2, 4 })));
+}
+
+void test_batch (const bool verbose)
+{
+    // agrees with filter () on the same window
+    hand_motion_parameters p;
+    p.flicker = 0.05;
+    p.id_swap = 0.02;
+    hand_motion_generator g (p);
+    const uint64_t D = 100000;
+    sample_filter f (D);
+    sliding_window<hand_sample> w (D);
+    size_t agree = 0;
+    size_t rejected = 0;
+    size_t glitches = 0;
+    size_t caught = 0;
+    const size_t N = 20000;
+    for (size_t i = 0; i < N; ++i)
+    {
+        frame x;
+        gesture_label l;
+        g.next (x, l);
+        const bool good = f.update (x.ts, x.s);
+        w.add (x.ts, x.s);
+        const hand_samples batch (w.get_samples ().begin (), w.get_samples ().end ());
+        const hand_samples kept = filter (batch);
+        bool keep = false;
+        for (const auto &j : kept)
+            keep = keep || same_ids (j, x.s);
+        agree += good == keep;
+        rejected += !good;
+        // a glitch that is not the first frame of a gesture
+        if ((l.flicker || l.id_swap) && x.ts - l.onset_ts > D)
+        {
+            ++glitches;
+            caught += !good;
+        }
+    }
+    if (verbose)
+    {
+        clog << agree << "/" << N << " agree with filter ()" << endl;
+        clog << rejected << " rejected" << endl;
+        clog << caught << "/" << glitches << " glitches caught" << endl;
+    }
+    VERIFY (agree > N * 99 / 100);
+    VERIFY (caught > glitches * 95 / 100);
+    VERIFY (rejected < N / 5);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_sample_filter (verbose);
+        test_batch (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
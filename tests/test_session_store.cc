@@ -0,0 +1,267 @@
+/// @file test_session_store.cc
+/// @brief test session_store and its kernels
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-11-11
+
+#include "../session_store.h"
+#include "verify.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <unistd.h>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_session_store [verbose]";
+const string fn ("/tmp/test_session_store.cols");
+
+// frames with 0 to 5 fingers
+session_store make_store (size_t frames)
+{
+    mt19937 rng (1);
+    uniform_real_distribution<double> u (-100.0, 100.0);
+    session_store s;
+    for (size_t i = 0; i < frames; ++i)
+    {
+        frame f;
+        f.id = i;
+        f.ts = i * 10000;
+        f.s.resize (rng () % 6);
+        for (size_t j = 0; j < f.s.size (); ++j)
+        {
+            f.s[j].id = j;
+            f.s[j].position = vec3 (u (rng), u (rng), u (rng));
+            f.s[j].velocity = vec3 (u (rng), u (rng), u (rng));
+        }
+        s.add (f);
+    }
+    return s;
+}
+
+void test_columns (const bool verbose)
+{
+    session_store s;
+    VERIFY (s.frames () == 0);
+    VERIFY (s.fingers () == 0);
+    frame f;
+    f.id = 3;
+    f.ts = 30000;
+    f.s.resize (2);
+    f.s[0].id = 7;
+    f.s[0].position = vec3 (1, 2, 3);
+    f.s[0].velocity = vec3 (4, 5, 6);
+    f.s[1].id = 8;
+    f.s[1].position = vec3 (4, 6, 3);
+    s.add (f);
+    f.id = 4;
+    f.ts = 40000;
+    f.s.clear ();
+    s.add (f);
+    VERIFY (s.frames () == 2);
+    VERIFY (s.fingers () == 2);
+    VERIFY (s.fingers (0) == 2);
+    VERIFY (s.fingers (1) == 0);
+    VERIFY (s.get_frame_ids ()[1] == 4);
+    VERIFY (s.get_timestamps ()[0] == 30000);
+    VERIFY (s.get_ids ()[1] == 8);
+    VERIFY (s.get_y ()[0] == 2);
+    VERIFY (s.get_vz ()[0] == 6);
+    VERIFY (finger_counts (s)[0] == 2);
+    VERIFY (finger_speeds (s)[1] == 0);
+    VERIFY (fabs (finger_speeds (s)[0] - sqrt (77.0)) < 1e-5);
+    const vector<uint64_t> two = select_frames (s, 2);
+    VERIFY (two.size () == 1 && two[0] == 0);
+    VERIFY (finger_distances (s, two)[0] == 5);
+    // appending keeps the offsets right
+    session_store t = s;
+    t.add (s);
+    VERIFY (t.frames () == 4);
+    VERIFY (t.fingers (2) == 2);
+    VERIFY (t.get_offsets ()[3] == 4);
+    VERIFY (t.get_x ()[3] == 4);
+    if (verbose)
+        clog << t.frames () << " frames" << endl;
+    s.clear ();
+    VERIFY (s.frames () == 0);
+    VERIFY (s.get_offsets ().size () == 1);
+}
+
+void test_save_load (const bool verbose)
+{
+    const session_store s = make_store (1000);
+    s.save (fn);
+    VERIFY (is_session_store (fn));
+    session_store t;
+    t.load (fn);
+    VERIFY (t.frames () == s.frames ());
+    VERIFY (t.fingers () == s.fingers ());
+    VERIFY (t.get_offsets () == s.get_offsets ());
+    VERIFY (t.get_timestamps () == s.get_timestamps ());
+    VERIFY (t.get_ids () == s.get_ids ());
+    VERIFY (t.get_x () == s.get_x ());
+    VERIFY (t.get_vz () == s.get_vz ());
+    if (verbose)
+        clog << t.fingers () << " fingers" << endl;
+    // a truncated file
+    VERIFY (truncate (fn.c_str (), sizeof (session_store_header) + 100) == 0);
+    bool failed = false;
+    try { t.load (fn); }
+    catch (...) { failed = true; }
+    VERIFY (failed);
+    VERIFY (t.frames () == 0);
+    // not a store
+    VERIFY (!is_session_store ("/tmp/no_such_session_store"));
+    unlink (fn.c_str ());
+}
+
+// save a store, change its header, and check that it can't be loaded
+void verify_damaged (const session_store &s, uint64_t frames, uint64_t fingers, size_t extra, const bool verbose)
+{
+    s.save (fn);
+    {
+        FILE *fp = fopen (fn.c_str (), "r+b");
+        VERIFY (fp);
+        session_store_header h;
+        VERIFY (fread (&h, sizeof (h), 1, fp) == 1);
+        h.frames = frames;
+        h.fingers = fingers;
+        VERIFY (fseek (fp, 0, SEEK_SET) == 0);
+        VERIFY (fwrite (&h, sizeof (h), 1, fp) == 1);
+        VERIFY (fseek (fp, 0, SEEK_END) == 0);
+        for (size_t i = 0; i < extra; ++i)
+            VERIFY (fputc (0, fp) == 0);
+        VERIFY (fclose (fp) == 0);
+    }
+    session_store t = s;
+    bool failed = false;
+    try { t.load (fn); }
+    catch (const exception &e)
+    {
+        if (verbose)
+            clog << frames << " frames, " << fingers << " fingers, " << extra << " extra bytes: " << e.what () << endl;
+        failed = true;
+    }
+    VERIFY (failed);
+    VERIFY (t.frames () == 0);
+    VERIFY (t.fingers () == 0);
+}
+
+void test_damaged (const bool verbose)
+{
+    const session_store s = make_store (100);
+    const uint64_t n = s.frames ();
+    const uint64_t m = s.fingers ();
+    // counts so large they would overflow the size computation or exhaust memory
+    verify_damaged (s, uint64_t (1) << 60, m, 0, verbose);
+    verify_damaged (s, n, uint64_t (1) << 62, 0, verbose);
+    verify_damaged (s, ~uint64_t (0), ~uint64_t (0), 0, verbose);
+    // counts that disagree with the file size
+    verify_damaged (s, n + 1, m, 0, verbose);
+    verify_damaged (s, n, m - 1, 0, verbose);
+    verify_damaged (s, n, m, 1, verbose);
+    // the right size, but the offsets don't add up
+    verify_damaged (s, n + 7, m - 6, 0, verbose);
+    // undamaged, it still loads
+    s.save (fn);
+    session_store t;
+    t.load (fn);
+    VERIFY (t.frames () == n);
+    VERIFY (t.fingers () == m);
+    unlink (fn.c_str ());
+}
+
+void test_kernels (const bool verbose)
+{
+    // check the parallel kernels against simple loops
+    const session_store s = make_store (100000);
+    const vector<uint32_t> c = finger_counts (s);
+    uint64_t changes = 0;
+    for (size_t i = 1; i < c.size (); ++i)
+        changes += c[i] != c[i - 1];
+    VERIFY (count_changes (c) == changes);
+    const vector<uint64_t> h = histogram (c, 0.0, 1.0, 4);
+    VERIFY (h.size () == 4);
+    for (size_t i = 0; i < 3; ++i)
+        VERIFY (h[i] == static_cast<uint64_t> (count (c.begin (), c.end (), i)));
+    // bigger values go in the last bucket
+    VERIFY (h[3] == c.size () - h[0] - h[1] - h[2]);
+    const vector<float> v = finger_speeds (s);
+    VERIFY (v.size () == s.fingers ());
+    double sum = 0.0;
+    float lo = v[0], hi = v[0];
+    for (auto i : v)
+    {
+        sum += i;
+        lo = min (lo, i);
+        hi = max (hi, i);
+    }
+    const column_summary cs = summarize (v);
+    if (verbose)
+        print_stats (clog, cs);
+    VERIFY (cs.n == v.size ());
+    VERIFY (fabs (cs.sum - sum) < 1e-6 * sum);
+    VERIFY (cs.min == lo);
+    VERIFY (cs.max == hi);
+    for (size_t i = 0; i < v.size (); i += 97)
+        VERIFY (fabs (v[i] - sqrt (s.get_vx ()[i] * s.get_vx ()[i]
+            + s.get_vy ()[i] * s.get_vy ()[i]
+            + s.get_vz ()[i] * s.get_vz ()[i])) <= 1e-5 * v[i]);
+    const vector<uint64_t> f = select_frames (s, 3);
+    VERIFY (f.size () == h[3] - count (c.begin (), c.end (), 4) - count (c.begin (), c.end (), 5));
+    vector<uint64_t> g;
+    for (size_t i = 0; i < c.size (); ++i)
+        if (c[i] == 3)
+            g.push_back (i);
+    VERIFY (f == g);
+    const vector<float> d = finger_distances (s, f);
+    for (size_t i = 0; i < d.size (); ++i)
+    {
+        const uint64_t j = s.get_offsets ()[f[i]];
+        const float dx = s.get_x ()[j + 1] - s.get_x ()[j];
+        const float dy = s.get_y ()[j + 1] - s.get_y ()[j];
+        const float dz = s.get_z ()[j + 1] - s.get_z ()[j];
+        VERIFY (fabs (d[i] - sqrt (dx * dx + dy * dy + dz * dz)) <= 1e-5 * d[i]);
+    }
+    const vector<uint64_t> dh = histogram (d, 0.0, 10.0, 40);
+    if (verbose)
+        print_histogram (clog, dh, 0.0, 10.0);
+    uint64_t total = 0;
+    for (auto i : dh)
+        total += i;
+    VERIFY (total == d.size ());
+    const column_summary ds = summarize (d);
+    VERIFY (ds.min >= 0.0);
+    VERIFY (ds.max <= sqrt (3.0) * 200.0);
+    // columns that don't fill the last group of four
+    const vector<float> odd { 3, -1, 4, 1, -5, 9, 2 };
+    const column_summary os = summarize (odd);
+    VERIFY (os.n == 7);
+    VERIFY (os.sum == 13.0);
+    VERIFY (os.min == -5.0);
+    VERIFY (os.max == 9.0);
+    VERIFY (summarize (vector<float> (1, 2.0f)).min == 2.0);
+    // empty columns
+    VERIFY (summarize (vector<float> ()).n == 0);
+    VERIFY (summarize (vector<float> ()).max == 0.0);
+    VERIFY (count_changes (vector<uint32_t> ()) == 0);
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_columns (verbose);
+        test_save_load (verbose);
+        test_damaged (verbose);
+        test_kernels (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
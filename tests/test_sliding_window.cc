@@ -6,7 +6,9 @@
 
 #include "../sliding_window.h"
 #include "verify.h"
+#include <deque>
 #include <iostream>
+#include <random>
 
 using namespace std;
 using namespace soma;
@@ -73,12 +75,110 @@ void test_sliding_window (const bool verbose)
     VERIFY (sw.fullness (ts) == 0.0);
 }
 
+struct summer
+{
+    int sum;
+    summer ()
+        : sum (0)
+    {
+    }
+    void add (int x) { sum += x; }
+    void remove (int x) { sum -= x; }
+};
+
+void test_ring (const bool verbose)
+{
+    // a window that has to grow, checked against a deque that slides one sample at a time
+    const uint64_t D = 10000;
+    sliding_window<int> sw (D, 100);
+    const size_t initial = sw.capacity ();
+    VERIFY (initial == 4);
+    deque<pair<uint64_t, int>> d;
+    summer obs;
+    mt19937 rng (1);
+    uint64_t ts = 0;
+    for (int i = 0; i < 10000; ++i)
+    {
+        // bursts of frames that are close together, and now and then a pause that empties most of the window
+        ts += rng () % 7 == 0 ? rng () % (2 * D) : rng () % 300;
+        sw.add (ts, i, obs);
+        d.push_front (make_pair (ts, i));
+        while (ts - d.back ().first >= D)
+            d.pop_back ();
+        VERIFY (sw.size () == d.size ());
+        VERIFY (sw.front () == i);
+        VERIFY (sw.back () == d.back ().second);
+        int sum = 0;
+        size_t j = 0;
+        for (auto k : sw.get_samples ())
+        {
+            VERIFY (k == d[j++].second);
+            sum += k;
+        }
+        VERIFY (obs.sum == sum);
+    }
+    if (verbose)
+        clog << initial << " to " << sw.capacity () << " capacity" << endl;
+    VERIFY (sw.capacity () > initial);
+    // clearing keeps the capacity
+    const size_t c = sw.capacity ();
+    sw.clear ();
+    VERIFY (sw.size () == 0);
+    VERIFY (sw.begin () == sw.end ());
+    VERIFY (sw.capacity () == c);
+    // the capacity covers the duration at the frame rate
+    VERIFY (sliding_window<int> (100000).capacity () == 32);
+    VERIFY (sliding_window<int> (200000, 100).capacity () == 32);
+}
+
+void test_multi (const bool verbose)
+{
+    // a 3 channel window should slide exactly like 3 separate windows
+    const uint64_t D = 10000;
+    multi_sliding_window<int, 3> mw (D, 100);
+    sliding_window<int> sw[3] = { sliding_window<int> (D, 100), sliding_window<int> (D, 100), sliding_window<int> (D, 100) };
+    array<summer, 3> mobs;
+    summer obs[3];
+    mt19937 rng (2);
+    uint64_t ts = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        ts += rng () % 7 == 0 ? rng () % (2 * D) : rng () % 300;
+        const array<int, 3> s = {{ i, -i, i * i }};
+        mw.add (ts, s, mobs);
+        for (size_t c = 0; c < 3; ++c)
+        {
+            sw[c].add (ts, s[c], obs[c]);
+            VERIFY (mobs[c].sum == obs[c].sum);
+            VERIFY (mw.size () == sw[c].size ());
+        }
+        VERIFY (mw.fullness (ts) == sw[0].fullness (ts));
+        size_t j = 0;
+        for (auto k : mw)
+        {
+            VERIFY (k[0] == sw[0][j]);
+            VERIFY (k[1] == sw[1][j]);
+            VERIFY (k[2] == sw[2][j]);
+            ++j;
+        }
+        VERIFY (j == mw.size ());
+        VERIFY (mw[0][1] == -i);
+    }
+    if (verbose)
+        clog << mw.size () << " samples, " << mw.capacity () << " capacity" << endl;
+    mw.clear ();
+    VERIFY (mw.size () == 0);
+    VERIFY (mw.begin () == mw.end ());
+}
+
 int main (int argc, char **)
 {
     try
     {
         const bool verbose = (argc > 1);
         test_sliding_window (verbose);
+        test_ring (verbose);
+        test_multi (verbose);
 
         return 0;
     }
@@ -0,0 +1,99 @@
+/// @file test_spsc_ring.cc
+/// @brief test spsc_ring class
+/// @author Jeff Perry <jeffsp@gmail.com>
+/// @version 1.0
+/// @date 2013-10-28
+
+#include "../spsc_ring.h"
+#include "verify.h"
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace soma;
+const string usage = "usage: test_spsc_ring [verbose]";
+
+void test_spsc_ring1 (const bool verbose)
+{
+    spsc_ring<int> r (4);
+    VERIFY (r.capacity () == 4);
+    VERIFY (r.empty ());
+    VERIFY (r.front () == 0);
+    for (int i = 0; i < 4; ++i)
+        VERIFY (r.push (i));
+    VERIFY (r.size () == 4);
+    // it's full
+    VERIFY (!r.push (4));
+    VERIFY (r.prepare () == 0);
+    for (int i = 0; i < 4; ++i)
+    {
+        VERIFY (*r.front () == i);
+        r.pop ();
+    }
+    VERIFY (r.empty ());
+    // wrap around
+    for (int i = 0; i < 10; ++i)
+    {
+        VERIFY (r.push (i));
+        VERIFY (*r.front () == i);
+        r.pop ();
+    }
+    VERIFY (r.empty ());
+}
+
+void test_spsc_ring2 (const bool verbose)
+{
+    // one thread pushes, the other pops, every element arrives in order
+    const size_t N = 1000000;
+    spsc_ring<vector<size_t>> r (64);
+    size_t full = 0;
+    thread producer ([&] ()
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            vector<size_t> *p;
+            while ((p = r.prepare ()) == 0)
+            {
+                ++full;
+                this_thread::yield ();
+            }
+            p->assign (i % 7, i);
+            r.commit ();
+        }
+    });
+    size_t errors = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        vector<size_t> *p;
+        while ((p = r.front ()) == 0)
+            this_thread::yield ();
+        if (p->size () != i % 7)
+            ++errors;
+        for (auto j : *p)
+            if (j != i)
+                ++errors;
+        r.pop ();
+    }
+    producer.join ();
+    if (verbose)
+        clog << "producer found the ring full " << full << " times" << endl;
+    VERIFY (errors == 0);
+    VERIFY (r.empty ());
+}
+
+int main (int argc, char **)
+{
+    try
+    {
+        const bool verbose = (argc > 1);
+        test_spsc_ring1 (verbose);
+        test_spsc_ring2 (verbose);
+
+        return 0;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what () << endl;
+        return -1;
+    }
+}
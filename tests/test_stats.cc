@@ -5,8 +5,11 @@
 /// @date 2013-09-05
 
 #include "../stats.h"
+#include "../sliding_window.h"
 #include "verify.h"
+#include <algorithm>
 #include <iostream>
+#include <random>
 
 using namespace std;
 using namespace soma;
@@ -26,6 +29,20 @@ void test_stats (const bool verbose)
     VERIFY (round (variance (x) * 100) == 523);
 }
 
+void test_variance (const bool verbose)
+{
+    // a big mean and a small spread
+    vector<double> x;
+    for (int i = 0; i < 1000; ++i)
+        x.push_back (1e9 + (i % 10) * 0.1);
+    // the spread of 0.0, 0.1, ... 0.9
+    const double v = 0.0825;
+    if (verbose)
+        clog << "variance(x)=" << variance (x) << endl;
+    VERIFY (fabs (variance (x) - v) < 1e-6);
+    VERIFY (variance (vector<double> ()) == 0.0);
+}
+
 void test_running_stats (const bool verbose)
 {
     running_mean a;
@@ -61,13 +78,273 @@ void test_running_stats (const bool verbose)
     VERIFY (b.get_mode () == 3);
 }
 
+/// @brief the running_mode that walked its whole distribution when the mode was removed
+struct map_running_mode
+{
+    std::map<int,size_t> d;
+    int m;
+    size_t count;
+    map_running_mode () : m (0), count (0) { }
+    void add (const int x)
+    {
+        if (++d[x] > count)
+        {
+            m = x;
+            count = d[x];
+        }
+    }
+    void remove (const int x)
+    {
+        auto i = d.find (x);
+        if (--i->second == 0)
+            d.erase (i);
+        if (m == x)
+        {
+            --count;
+            for (auto i : d)
+            {
+                if (i.second > count)
+                {
+                    m = i.first;
+                    count = i.second;
+                }
+            }
+            if (count == 0)
+                m = 0;
+        }
+    }
+};
+
+void test_running_mode (const bool verbose)
+{
+    // both modes pick the same number as the old one, ties included
+    const uint64_t D = 1000;
+    sliding_window<int> w (D);
+    sliding_window<int> wb (D);
+    sliding_window<int> wr (D);
+    running_mode a;
+    bounded_running_mode<11> b;
+    map_running_mode r;
+    mt19937 rng (5);
+    uint64_t ts = 0;
+    size_t changes = 0;
+    for (int i = 0; i < 20000; ++i)
+    {
+        ts += rng () % 200;
+        const int x = rng () % 11;
+        const int last = r.m;
+        w.add (ts, x, a);
+        wb.add (ts, x, b);
+        wr.add (ts, x, r);
+        changes += last != r.m;
+        VERIFY (a.get_mode () == r.m);
+        VERIFY (a.get_count () == static_cast<int> (r.count));
+        VERIFY (b.get_mode () == r.m);
+        VERIFY (b.get_count () == static_cast<int> (r.count));
+    }
+    if (verbose)
+        clog << changes << " mode changes" << endl;
+    // ids that keep growing
+    for (int i = 0; i < 20000; ++i)
+    {
+        ts += rng () % 200;
+        const int x = i / (1 + rng () % 20);
+        w.add (ts, x, a);
+        wr.add (ts, x, r);
+        VERIFY (a.get_mode () == r.m);
+        VERIFY (a.get_count () == static_cast<int> (r.count));
+    }
+    // emptying it
+    ts += 2 * D;
+    w.add (ts, 7, a);
+    VERIFY (a.get_mode () == 7);
+    VERIFY (a.get_count () == 1);
+    a.reset ();
+    b.reset ();
+    a.add (3);
+    b.add (3);
+    VERIFY (a.get_mode () == 3);
+    VERIFY (b.get_mode () == 3);
+    a.remove (3);
+    b.remove (3);
+    VERIFY (a.get_mode () == 0 && a.get_count () == 0);
+    VERIFY (b.get_mode () == 0 && b.get_count () == 0);
+}
+
+/// @brief the running_mean that kept a raw sum
+struct naive_mean
+{
+    size_t total;
+    double sum;
+    naive_mean () : total (0), sum (0) { }
+    void add (const double x) { ++total; sum += x; }
+    void remove (const double x) { --total; sum -= x; }
+    double get_mean () const { return sum / total; }
+};
+
+void test_long_session (const bool verbose)
+{
+    // positions far from the origin slide through a window for a long time, and the running stats still match
+    // stats of the window computed from scratch
+    const uint64_t D = 100;
+    sliding_window<double> w (D);
+    sliding_window<double> wv (D);
+    sliding_window<double> wn (D);
+    running_mean a;
+    running_variance b;
+    naive_mean c;
+    mt19937 rng (6);
+    uniform_real_distribution<double> u (-1.0, 1.0);
+    double err = 0.0;
+    double verr = 0.0;
+    double nerr = 0.0;
+    for (uint64_t ts = 0; ts < 2000000; ++ts)
+    {
+        const double x = 1e6 + 1e3 * sin (ts * 1e-4) + u (rng);
+        w.add (ts, x, a);
+        wv.add (ts, x, b);
+        wn.add (ts, x, c);
+        if (ts % 1000 != 0)
+            continue;
+        const vector<double> v (w.begin (), w.end ());
+        const double m = accumulate (v.begin (), v.end (), 0.0L) / v.size ();
+        err = max (err, fabs (a.get_mean () - m));
+        nerr = max (nerr, fabs (c.get_mean () - m));
+        verr = max (verr, fabs (b.get_variance () - variance (v)));
+        VERIFY (fabs (b.get_mean () - m) < 1e-6);
+    }
+    if (verbose)
+        clog << "largest running_mean error " << err
+            << ", with a raw sum " << nerr
+            << ", running_variance error " << verr << endl;
+    VERIFY (err < 1e-9);
+    VERIFY (verr < 1e-6);
+    // recomputing gives the same answers
+    running_mean d;
+    d.recompute (w.begin (), w.end ());
+    VERIFY (fabs (d.get_mean () - a.get_mean ()) < 1e-8);
+    running_variance e;
+    e.recompute (w.begin (), w.end ());
+    VERIFY (fabs (e.get_variance () - b.get_variance ()) < 1e-6);
+    // emptying it starts over
+    e.reset ();
+    e.add (5); e.add (7);
+    VERIFY (e.get_variance () == 1.0);
+    e.remove (7);
+    VERIFY (e.get_variance () == 0.0);
+    VERIFY (e.get_mean () == 5.0);
+    e.remove (5);
+    VERIFY (e.get_mean () == 0.0);
+}
+
+void test_running_range (const bool verbose)
+{
+    running_range<int> a;
+    a.add (3); a.add (1); a.add (4); a.add (1); a.add (5);
+    if (verbose)
+        clog << "running_range=" << a.get_min () << " " << a.get_max () << endl;
+    VERIFY (a.get_min () == 1);
+    VERIFY (a.get_max () == 5);
+    VERIFY (a.get_range () == 4);
+    // the first 1 leaves, but the second is still there
+    a.remove (3); a.remove (1);
+    VERIFY (a.get_min () == 1);
+    a.remove (4); a.remove (1);
+    VERIFY (a.get_min () == 5);
+    VERIFY (a.get_range () == 0);
+    a.remove (5);
+    VERIFY (a.get_range () == 0);
+    // against a rescan of a sliding window
+    const uint64_t D = 1000;
+    sliding_window<int> w (D);
+    sliding_window<int> wh (D);
+    sliding_window<int> wr (D);
+    running_min<int> lo;
+    running_max<int> hi;
+    running_range<int> r;
+    mt19937 rng (3);
+    uint64_t ts = 0;
+    for (int i = 0; i < 10000; ++i)
+    {
+        ts += rng () % 200;
+        // few distinct values, so there are lots of ties
+        const int x = rng () % 10;
+        w.add (ts, x, lo);
+        wh.add (ts, x, hi);
+        wr.add (ts, x, r);
+        const int m = *min_element (w.begin (), w.end ());
+        const int n = *max_element (w.begin (), w.end ());
+        VERIFY (lo.get_min () == m);
+        VERIFY (hi.get_max () == n);
+        VERIFY (r.get_range () == n - m);
+    }
+    lo.reset ();
+    VERIFY (lo.get_min () == 0);
+}
+
+void test_running_quantile (const bool verbose)
+{
+    running_median a;
+    a.add (5); a.add (1); a.add (3);
+    VERIFY (a.get_median () == 3);
+    a.add (100);
+    if (verbose)
+        clog << "running_median=" << a.get_median () << endl;
+    VERIFY (a.get_median () == 4);
+    // a glitch barely moves it
+    a.add (1000);
+    VERIFY (a.get_median () == 5);
+    a.remove (5); a.remove (1);
+    VERIFY (a.get_median () == 100);
+    a.remove (3); a.remove (100); a.remove (1000);
+    VERIFY (a.get_median () == 0);
+    // against a sort of a sliding window, with lots of ties
+    const uint64_t D = 1000;
+    const double Q[] = { 0.0, 0.1, 0.5, 0.9, 1.0 };
+    vector<sliding_window<double>> w (5, sliding_window<double> (D));
+    vector<running_quantile> r;
+    for (auto q : Q)
+        r.push_back (running_quantile (q));
+    mt19937 rng (4);
+    uint64_t ts = 0;
+    for (int i = 0; i < 10000; ++i)
+    {
+        ts += rng () % 200;
+        const double x = rng () % 10;
+        for (size_t j = 0; j < w.size (); ++j)
+        {
+            w[j].add (ts, x, r[j]);
+            vector<double> v (w[j].begin (), w[j].end ());
+            sort (v.begin (), v.end ());
+            const double h = Q[j] * (v.size () - 1);
+            const size_t k = h;
+            const double e = k + 1 < v.size () ? v[k] + (h - k) * (v[k + 1] - v[k]) : v[k];
+            VERIFY (fabs (r[j].get_quantile () - e) < 1e-9);
+        }
+    }
+    // copies are independent
+    running_quantile b (r[2]);
+    const double m = b.get_quantile ();
+    r[2].reset ();
+    VERIFY (b.get_quantile () == m);
+    b.add (m);
+    VERIFY (b.get_quantile () == m);
+    r[2] = b;
+    VERIFY (r[2].get_quantile () == m);
+}
+
 int main (int argc, char **)
 {
     try
     {
         const bool verbose = (argc > 1);
         test_stats (verbose);
+        test_variance (verbose);
         test_running_stats (verbose);
+        test_long_session (verbose);
+        test_running_mode (verbose);
+        test_running_range (verbose);
+        test_running_quantile (verbose);
 
         return 0;
     }
@@ -4,14 +4,15 @@
 /// @version 1.0
 /// @date 2013-10-11
 
+#include "event_loop.h"
+#include "frame_sources.h"
 #include "touch_port.h"
-#include "Leap.h"
 #include <stdexcept>
 #include <unistd.h>
 
 using namespace std;
 using namespace soma;
-const string usage = "usage: touch_port > touch_port.txt";
+const string usage = "usage: touch_port " + frame_source_usage + " > touch_port.txt";
 
 vec3 find (const vec3 &c, const vector<vec3> &p, bool xltz, bool yltz)
 {
@@ -32,10 +33,10 @@ vec3 find (const vec3 &c, const vector<vec3> &p, bool xltz, bool yltz)
     return m;
 }
 
-class touchport : public Leap::Listener
+class touchport : public frame_listener
 {
     private:
-    bool done;
+    done_flag done;
     vector<vec3> points;
     vec3 tl;
     vec3 tr;
@@ -43,7 +44,6 @@ class touchport : public Leap::Listener
     vec3 br;
     public:
     touchport (uint64_t duration)
-        : done (false)
     {
     }
     void print (ostream &s)
@@ -67,21 +67,19 @@ class touchport : public Leap::Listener
         s << bl << endl;
         s << br << endl;
     }
-    bool is_done () const
+    /// @brief get the flag that is set when the user quits
+    done_flag &get_done ()
     {
         return done;
     }
-    virtual void onFrame (const Leap::Controller& c)
+    virtual void on_frame (const frame &f)
     {
-        if (done)
+        if (done.is_set ())
             return;
-        // get the frame
-        Leap::Frame f = c.frame ();
-        // get the sample
-        hand_sample hs (f.pointables ());
+        const hand_sample &hs = f.s;
         // 5 fingers == exit
         if (hs.size () == 5)
-            done = true;
+            done.set ();
         // pointer
         if (hs.size () == 1)
         {
@@ -95,21 +93,25 @@ int main (int argc, char **argv)
 {
     try
     {
-        if (argc != 1)
+        if (!valid_frame_source_args (argc - 1, argv + 1))
             throw runtime_error (usage);
 
+        // signals are blocked in every thread started after this
+        event_loop loop;
+
         clog << "5 fingers = exit" << endl;
 
         static const uint64_t WINDOW_DURATION = 200000;
         touchport tp (WINDOW_DURATION);
-        Leap::Controller c (tp);
+        unique_ptr<frame_source> src = make_frame_source (argc - 1, argv + 1);
+        loop.quit_when (tp.get_done ());
+        loop.quit_when (src->get_done ());
+        src->start (tp);
 
-        // receive frames even when you don't have focus
-        c.setPolicyFlags (Leap::Controller::POLICY_BACKGROUND_FRAMES);
+        // sleep until the user quits, the source runs out of frames, or a signal arrives
+        loop.run ();
 
-        // loop
-        while (!tp.is_done ())
-            usleep (5000);
+        src->stop ();
 
         tp.print (cout);
 